@@ -0,0 +1,96 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Arena.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/19 10:21:44 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/19 10:21:44 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef ARENA_HPP
+# define ARENA_HPP
+
+# include <vector>
+# include <cstddef>
+
+/**
+ * @class Arena
+ * @brief Bump allocator for data that lives exactly as long as a request
+ * 
+ * Memory is carved from large blocks by moving a cursor, and nothing is
+ * freed one piece at a time. reset() rewinds the cursor to the first
+ * block and keeps every block, so once a connection has seen its usual
+ * request size, later requests on it allocate nothing from the heap.
+ * Pointers handed out are only valid until the next reset().
+ */
+class Arena
+{
+private:
+	/**
+	 * @struct Block
+	 * @brief One chunk of memory owned by the arena
+	 */
+	struct Block
+	{
+		char*	data;
+		size_t	size;
+	};
+	
+	std::vector<Block>	_blocks;
+	size_t				_blockSize;
+	size_t				_current;  // block being carved
+	size_t				_used;     // bytes taken from the current block
+
+public:
+	/**
+	 * Constructor, no memory is taken until the first allocation
+	 */
+	Arena(size_t blockSize = 4096);
+	
+	/**
+	 * Copy constructor, the copy starts empty with the same block size;
+	 * pointers into an arena cannot be carried over
+	 */
+	Arena(const Arena& other);
+	
+	/**
+	 * Destructor, frees every block
+	 */
+	~Arena(void);
+	
+	/**
+	 * Assignment operator, drops the contents and keeps the blocks
+	 */
+	Arena&			operator=(const Arena& other);
+	
+	/**
+	 * Get length bytes aligned for any fundamental type
+	 */
+	void*			allocate(size_t length);
+	
+	/**
+	 * Copy bytes into the arena, followed by a NUL
+	 */
+	char*			copy(const char* bytes, size_t length);
+	
+	/**
+	 * Forget everything allocated, in constant time; blocks are kept
+	 */
+	void			reset(void);
+	
+	/**
+	 * Forget everything allocated and give the blocks back
+	 */
+	void			release(void);
+	
+	/**
+	 * Forget everything allocated and give back the blocks past the
+	 * first limit bytes
+	 */
+	void			trim(size_t limit);
+};
+
+#endif
@@ -0,0 +1,111 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Buffer.hpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/12 16:48:30 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/12 16:48:30 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef BUFFER_HPP
+# define BUFFER_HPP
+
+# include <vector>
+# include <cstddef>
+
+/**
+ * @class Buffer
+ * @brief Growable byte buffer with a read cursor
+ * 
+ * Bytes are written at the end and consumed from the front by moving a
+ * cursor, so a parser never copies what is left after each token. The
+ * unread bytes are moved back to the front only when the tail runs out
+ * of room, which keeps the total cost linear in the bytes received.
+ */
+class Buffer
+{
+private:
+	std::vector<char>	_data;
+	size_t				_start;  // first unread byte
+	size_t				_end;    // one past the last written byte
+
+public:
+	/**
+	 * Default constructor, the buffer starts empty
+	 */
+	Buffer(void);
+	
+	/**
+	 * Copy constructor
+	 */
+	Buffer(const Buffer& other);
+	
+	/**
+	 * Destructor
+	 */
+	~Buffer(void);
+	
+	/**
+	 * Assignment operator
+	 */
+	Buffer&			operator=(const Buffer& other);
+	
+	/**
+	 * Get room for at least length bytes at the end; fill it, then
+	 * commit() the number of bytes actually written
+	 */
+	char*			prepare(size_t length);
+	
+	/**
+	 * Make length bytes written after prepare() readable
+	 */
+	void			commit(size_t length);
+	
+	/**
+	 * Copy bytes at the end
+	 */
+	void			append(const char* bytes, size_t length);
+	
+	/**
+	 * Drop length bytes from the front
+	 */
+	void			consume(size_t length);
+	
+	/**
+	 * Drop everything
+	 */
+	void			clear(void);
+	
+	/**
+	 * Give the storage back once it exceeds limit bytes, keeping the
+	 * unread ones
+	 */
+	void			shrink(size_t limit);
+	
+	/**
+	 * Get the first unread byte
+	 */
+	const char*		data(void) const;
+	
+	/**
+	 * Get the number of unread bytes
+	 */
+	size_t			size(void) const;
+	
+	/**
+	 * Check whether there is nothing to read
+	 */
+	bool			empty(void) const;
+	
+	/**
+	 * Find a byte at or after offset from, npos if absent
+	 */
+	size_t			find(char c, size_t from = 0) const;
+	
+	static const size_t	npos = static_cast<size_t>(-1);
+};
+
+#endif
@@ -42,7 +42,7 @@ private:
 	std::string							_requestMethod;
 	std::string							_contentType;
 	std::string							_contentLength;
-	std::string							_requestBody;
+	RequestBody							_requestBody;
 	std::string							_workingDirectory;
 	std::map<std::string, std::string>	_envVars;
 	
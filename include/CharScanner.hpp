@@ -0,0 +1,59 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CharScanner.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/13 10:22:07 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/13 10:22:07 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CHAR_SCANNER_HPP
+# define CHAR_SCANNER_HPP
+
+# include <string>
+# include <cstddef>
+
+/**
+ * @class CharScanner
+ * @brief Byte class scanners used by the HTTP parser
+ * 
+ * Each scanner returns the index of the first byte that stops it, or
+ * length when the whole range was accepted. On x86 the best of the
+ * AVX2 (32 bytes per step), SSE4.2 (16 bytes per step) and scalar
+ * variants is picked once from the running CPU.
+ */
+class CharScanner
+{
+public:
+	/**
+	 * Find the first occurrence of c
+	 */
+	static size_t		findByte(const char* data, size_t length, char c);
+	
+	/**
+	 * Skip token characters (RFC 9110 5.6.2), stops on anything else
+	 * such as the ':' after a field name
+	 */
+	static size_t		skipToken(const char* data, size_t length);
+	
+	/**
+	 * Skip field value characters (HTAB, SP, VCHAR and obs-text), stops
+	 * on control characters such as CR and LF
+	 */
+	static size_t		skipFieldValue(const char* data, size_t length);
+	
+	/**
+	 * Get the name of the variant in use: avx2, sse4.2 or scalar
+	 */
+	static const char*	getImplementation(void);
+	
+	/**
+	 * Force a variant by name, false if this CPU cannot run it
+	 */
+	static bool			setImplementation(const std::string& name);
+};
+
+#endif
@@ -0,0 +1,129 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ClientSocket.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/08 09:41:52 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/08 09:41:52 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CLIENT_SOCKET_HPP
+# define CLIENT_SOCKET_HPP
+
+# include <string>
+# include <sys/types.h>
+# include <sys/socket.h>
+# include <sys/uio.h>
+# include <netinet/in.h>
+
+/**
+ * @class ClientSocket
+ * @brief Owning handle of an accepted client descriptor
+ * 
+ * Unlike Socket, which is shared by reference counting, a ClientSocket is
+ * a plain descriptor plus the peer address in binary form: it allocates
+ * nothing, cannot be copied, and closes the descriptor when it is closed,
+ * reset or destroyed. Ownership moves explicitly with release()/reset().
+ * The printable address is only built when someone asks for it. A socket
+ * accepted without its address (by the io_uring backend) looks it up
+ * with getpeername() the first time it is needed.
+ */
+class ClientSocket
+{
+private:
+	int					_fd;
+	mutable struct sockaddr_in	_addr;  // sin_family 0 until known
+	
+	/**
+	 * Copy constructor - private, a descriptor has a single owner
+	 */
+	ClientSocket(const ClientSocket& other);
+	
+	/**
+	 * Assignment operator - private, a descriptor has a single owner
+	 */
+	ClientSocket&		operator=(const ClientSocket& other);
+
+public:
+	/**
+	 * Default constructor, the handle starts empty (fd -1)
+	 */
+	ClientSocket(void);
+	
+	/**
+	 * Constructor taking ownership of an accepted descriptor
+	 */
+	ClientSocket(int fd, const struct sockaddr_in& addr);
+	
+	/**
+	 * Destructor closes the descriptor it still owns
+	 */
+	~ClientSocket(void);
+	
+	/**
+	 * Close the current descriptor, then take ownership of fd
+	 */
+	void				reset(int fd, const struct sockaddr_in& addr);
+	
+	/**
+	 * Give up ownership without closing, returns the descriptor
+	 */
+	int					release(void);
+	
+	/**
+	 * Close the descriptor
+	 */
+	void				close(void);
+	
+	/**
+	 * Send data, never raising SIGPIPE on a closed peer
+	 */
+	ssize_t				send(const void* buffer, size_t length);
+	
+	/**
+	 * Send several buffers in one call, never raising SIGPIPE
+	 */
+	ssize_t				sendv(const struct iovec* buffers, size_t count);
+	
+	/**
+	 * Send part of a file straight from the page cache, advancing
+	 * offset past the bytes sent
+	 */
+	ssize_t				sendFile(int fileFd, off_t& offset, size_t length);
+	
+	/**
+	 * Receive data
+	 */
+	ssize_t				recv(void* buffer, size_t length);
+	
+	/**
+	 * Get the descriptor, -1 when empty
+	 */
+	int					getFd(void) const;
+	
+	/**
+	 * Get the peer address in binary form, looked up on first use when
+	 * the descriptor was accepted without it
+	 */
+	const struct sockaddr_in&	getAddress(void) const;
+	
+	/**
+	 * Get the peer address as text (dotted quad)
+	 */
+	std::string			getHost(void) const;
+	
+	/**
+	 * Get the peer port
+	 */
+	int					getPort(void) const;
+	
+	/**
+	 * Format a binary IPv4 address as text
+	 */
+	static std::string	formatAddress(const struct sockaddr_in& addr);
+};
+
+#endif
@@ -18,6 +18,8 @@
 # include <map>
 # include <set>
 # include "Logger.hpp"
+# include "MethodTable.hpp"
+# include "VirtualHostTable.hpp"
 
 /**
  * @struct LocationConfig
@@ -28,14 +30,17 @@ struct LocationConfig
 	std::string					path;
 	std::string					root;
 	std::string					index;
-	std::set<std::string>		allowedMethods;
+	MethodMask					allowedMethods;  // no bits allows every method
 	bool						autoindex;
 	std::string					redirect;
 	std::string					uploadStore;
 	std::string					cgiPath;
 	std::set<std::string>		cgiExtensions;
+	unsigned long				clientMaxBodySize;     // the server's unless set
+	bool						hasClientMaxBodySize;
 
-	LocationConfig() : autoindex(false) {}
+	LocationConfig() : allowedMethods(0), autoindex(false), 
+		clientMaxBodySize(0), hasClientMaxBodySize(false) {}
 };
 
 /**
@@ -46,12 +51,46 @@ struct ServerConfig
 {
 	std::string							host;
 	int									port;
+	int									listenBacklog;
 	std::vector<std::string>			serverNames;
 	std::map<int, std::string>			errorPages;
 	unsigned long						clientMaxBodySize;
+	unsigned long						clientBodyBufferSize;  // bytes kept in memory
+	std::string							clientBodyTempPath;    // directory for larger bodies
+	unsigned long						clientHeaderTimeout;  // milliseconds
+	unsigned long						clientBodyTimeout;
+	unsigned long						keepaliveTimeout;
+	unsigned long						sendTimeout;
 	std::vector<LocationConfig>			locations;
 
-	ServerConfig() : port(80), clientMaxBodySize(1048576) {}
+	ServerConfig() : port(80), listenBacklog(511), clientMaxBodySize(1048576),
+		clientBodyBufferSize(16384), clientBodyTempPath("/tmp"),
+		clientHeaderTimeout(60000), clientBodyTimeout(60000),
+		keepaliveTimeout(75000), sendTimeout(60000) {}
+};
+
+/**
+ * @struct ListenConfig
+ * @brief One listening socket and the server blocks sharing it
+ */
+struct ListenConfig
+{
+	std::string							host;
+	int									port;
+	int									backlog;
+	VirtualHostTable					vhosts;
+
+	ListenConfig() : port(80), backlog(511) {}
+};
+
+/**
+ * @enum ThreadBalance
+ * @brief How the acceptor spreads connections over the worker threads
+ */
+enum ThreadBalance
+{
+	BALANCE_ROUND_ROBIN,
+	BALANCE_LEAST_CONN
 };
 
 /**
@@ -66,7 +105,17 @@ class Config
 private:
 	std::string					_configPath;
 	std::vector<ServerConfig>	_servers;
-	Logger									_logger;
+	std::vector<ListenConfig>	_listeners;  // points into _servers
+	std::string					_eventBackend;
+	int							_workerProcesses;
+	int							_workerThreads;
+	ThreadBalance				_threadBalance;
+	int							_acceptBatch;
+	size_t						_openFileCacheMax;  // 0 turns the cache off
+	unsigned long				_openFileCacheValid;  // milliseconds
+	bool						_openFileCacheErrors;
+	size_t						_responseCacheSize;  // 0 turns the cache off
+	size_t						_responseCacheEntry;  // largest body cached
 	
 	/**
 	 * Parse the configuration file
@@ -79,6 +128,31 @@ private:
 	ServerConfig				parseServerBlock(std::vector<std::string>& lines, 
 										size_t& index);
 	
+	/**
+	 * Parse a top-level directive, returns false if it is unknown
+	 */
+	bool						parseGlobalDirective(
+										const std::vector<std::string>& tokens);
+	
+	/**
+	 * Parse the open_file_cache directive (off, or max=N [valid=TIME])
+	 */
+	void						parseOpenFileCache(
+										const std::vector<std::string>& tokens);
+	
+	/**
+	 * Parse the response_cache directive (off, or max_size=SIZE
+	 * [max_entry=SIZE])
+	 */
+	void						parseResponseCache(
+										const std::vector<std::string>& tokens);
+	
+	/**
+	 * Parse the top-level events block from the configuration
+	 */
+	void						parseEventsBlock(std::vector<std::string>& lines,
+										size_t& index);
+	
 	/**
 	 * Parse a location block from the configuration
 	 */
@@ -90,10 +164,27 @@ private:
 	 */
 	void						validateConfig(void);
 	
+	/**
+	 * Group the server blocks by listening address; must run again
+	 * whenever _servers is copied since the tables point into it
+	 */
+	void						buildListeners(void);
+	
 	/**
 	 * Tokenize a configuration line
 	 */
 	std::vector<std::string>	tokenizeLine(const std::string& line);
+	
+	/**
+	 * Parse a time value (30s, 500ms, 2m, 1h; bare numbers are seconds)
+	 * into milliseconds
+	 */
+	static unsigned long		parseTime(const std::string& value);
+	
+	/**
+	 * Parse a size value (512, 16k, 10M, 1G) into bytes
+	 */
+	static unsigned long		parseSize(const std::string& value);
 
 public:
 	/**
@@ -127,10 +218,59 @@ public:
 	const std::vector<ServerConfig>&	getServers(void) const;
 	
 	/**
-	 * Find server configuration by host and port
+	 * Get the event notification backend (select, poll, epoll, io_uring)
+	 */
+	const std::string&				getEventBackend(void) const;
+	
+	/**
+	 * Get the number of worker processes (1 means no master process)
+	 */
+	int								getWorkerProcesses(void) const;
+	
+	/**
+	 * Get the number of event-loop threads (0 means a single loop)
+	 */
+	int								getWorkerThreads(void) const;
+	
+	/**
+	 * Get the policy used to hand connections to the worker threads
+	 */
+	ThreadBalance					getThreadBalance(void) const;
+	
+	/**
+	 * Get the most connections accepted per listener readiness event
+	 */
+	int								getAcceptBatch(void) const;
+	
+	/**
+	 * Get the most entries of each thread's open file cache, 0 when off
+	 */
+	size_t							getOpenFileCacheMax(void) const;
+	
+	/**
+	 * Get how long an open file cache entry is trusted, in milliseconds
+	 */
+	unsigned long					getOpenFileCacheValid(void) const;
+	
+	/**
+	 * Check whether failed lookups are kept in the open file cache
+	 */
+	bool							getOpenFileCacheErrors(void) const;
+	
+	/**
+	 * Get the bytes each thread's response cache may hold, 0 when off
+	 */
+	size_t							getResponseCacheSize(void) const;
+	
+	/**
+	 * Get the largest body the response cache keeps
+	 */
+	size_t							getResponseCacheEntry(void) const;
+	
+	/**
+	 * Get the listening addresses, each with its virtual host table
 	 */
-	const ServerConfig*				findServer(const std::string& host, 
-									int port, const std::string& serverName) const;
+	const std::vector<ListenConfig>&	getListeners(void) const;
 	
 	/**
 	 * Get default error page for a status code
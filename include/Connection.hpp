@@ -0,0 +1,96 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Connection.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/05 15:02:11 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/05 15:02:11 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CONNECTION_HPP
+# define CONNECTION_HPP
+
+# include <ctime>
+# include <deque>
+# include <netinet/in.h>
+# include "Config.hpp"
+# include "ClientSocket.hpp"
+# include "HttpRequest.hpp"
+# include "HttpResponse.hpp"
+# include "Http2Session.hpp"
+
+/**
+ * @enum ConnectionState
+ * @brief Where a client connection is in its request/response cycle
+ */
+enum ConnectionState
+{
+	CONN_IDLE,     // waiting for the first byte of a request
+	CONN_READING,  // a request is being received
+	CONN_WRITING   // a response is being sent
+};
+
+/**
+ * @struct ConnectionStats
+ * @brief Bookkeeping only read when a connection is logged or closed
+ */
+struct ConnectionStats
+{
+	time_t			acceptedAt;
+	unsigned long	requests;
+
+	ConnectionStats() : acceptedAt(0), requests(0) {}
+};
+
+/**
+ * @struct Connection
+ * @brief Everything the event loop keeps about one client connection
+ * 
+ * Connections live in the server's fd-indexed table, so finding the one
+ * behind a ready descriptor is a vector index. The fields used on every
+ * event come first, the statistics are kept apart at the end. The
+ * connection timer lives in the TimerWheel, which is indexed the same way.
+ */
+struct Connection
+{
+	int					fd;
+	ConnectionState		state;
+	const VirtualHostTable*	vhosts;  // of the accepting listener
+	const ServerConfig*	server;  // vhost of the current request, or default
+	ClientSocket		socket;
+	HttpRequest			request;
+	std::deque<HttpResponse>	responses;  // unsent, in request order
+	Http2Session*		http2;  // set once the connection speaks h2c
+	bool				receiving;  // reads complete in the event backend
+	
+	ConnectionStats		stats;
+
+	/**
+	 * Default constructor, the connection starts closed (fd -1)
+	 */
+	Connection(void);
+	
+	/**
+	 * Take ownership of an accepted descriptor
+	 */
+	void				open(int clientFd, const struct sockaddr_in& addr,
+							const VirtualHostTable* listenerHosts);
+	
+	/**
+	 * Wait for the next request, keeping the connection open; routing
+	 * goes back to the listener's default server until the next Host,
+	 * and memory a large request grew is given back
+	 */
+	void				waitForRequest(void);
+	
+	/**
+	 * Close the descriptor and drop the per-request state so the object
+	 * can be reused for another connection
+	 */
+	void				close(void);
+};
+
+#endif
@@ -0,0 +1,49 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EpollPoller.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 11:03:18 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 11:03:18 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef EPOLL_POLLER_HPP
+# define EPOLL_POLLER_HPP
+
+# ifdef __linux__
+
+#  include <sys/epoll.h>
+#  include "EventPoller.hpp"
+
+/**
+ * @class EpollPoller
+ * @brief Linux epoll() backend, only ready descriptors are reported
+ */
+class EpollPoller : public EventPoller
+{
+private:
+	int								_epollFd;
+	std::vector<struct epoll_event>	_events;
+	
+	/**
+	 * Issue an epoll_ctl() call, throws on failure
+	 */
+	void				control(int op, int fd, int events);
+
+public:
+	EpollPoller(void);
+	~EpollPoller(void);
+	
+	void				add(int fd, int events);
+	void				modify(int fd, int events);
+	void				remove(int fd);
+	int					wait(std::vector<PollEvent>& ready, int timeoutMs);
+	const char*			getName(void) const;
+};
+
+# endif
+
+#endif
@@ -0,0 +1,142 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EventPoller.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 10:12:31 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 10:12:31 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef EVENT_POLLER_HPP
+# define EVENT_POLLER_HPP
+
+# include <cstddef>
+# include <string>
+# include <vector>
+
+/**
+ * @enum EventFlags
+ * @brief Readiness conditions a poller can watch for or report, and the
+ * completions of backends that do the I/O themselves
+ */
+enum EventFlags
+{
+	EVENT_READ = 1,
+	EVENT_WRITE = 2,
+	EVENT_ERROR = 4,
+	EVENT_ACCEPTED = 8,   // result is the accepted descriptor
+	EVENT_RECEIVED = 16   // result bytes were received into data
+};
+
+/**
+ * @struct PollEvent
+ * @brief A ready descriptor and the conditions it is ready for, or an
+ * operation the backend completed on it
+ */
+struct PollEvent
+{
+	int			fd;
+	int			events;
+	int			result;  // completions only, -errno on failure
+	const char*	data;    // EVENT_RECEIVED, valid until the next wait()
+	
+	PollEvent(void) : fd(-1), events(0), result(0), data(NULL) {}
+};
+
+/**
+ * @class EventPoller
+ * @brief Interface of the readiness notification backends
+ * 
+ * The server only talks to this interface, so the select(), poll(), epoll()
+ * and io_uring implementations can be swapped from the configuration file
+ * with the "events { use <backend>; }" directive.
+ * 
+ * A backend may also complete accepts and receives itself, reporting the
+ * results instead of readiness. The server asks for it per descriptor
+ * and falls back to readiness when the backend declines.
+ */
+class EventPoller
+{
+private:
+	/**
+	 * Copy constructor - private to prevent copying
+	 */
+	EventPoller(const EventPoller& other);
+	
+	/**
+	 * Assignment operator - private to prevent assignment
+	 */
+	EventPoller&		operator=(const EventPoller& other);
+
+public:
+	/**
+	 * Default constructor
+	 */
+	EventPoller(void);
+	
+	/**
+	 * Destructor
+	 */
+	virtual ~EventPoller(void);
+	
+	/**
+	 * Start watching fd for the given EventFlags
+	 */
+	virtual void		add(int fd, int events) = 0;
+	
+	/**
+	 * Change the EventFlags watched for fd
+	 */
+	virtual void		modify(int fd, int events) = 0;
+	
+	/**
+	 * Accept on a listening socket in the backend, reporting each new
+	 * connection as EVENT_ACCEPTED; false if it cannot, the listener is
+	 * then add()ed for EVENT_READ
+	 */
+	virtual bool		addAcceptor(int fd);
+	
+	/**
+	 * Watch a client socket whose reads complete in the backend: while
+	 * EVENT_READ is watched, data is reported as EVENT_RECEIVED rather
+	 * than readiness; false if it cannot, fd is then add()ed as usual
+	 */
+	virtual bool		addReceiver(int fd, int events);
+	
+	/**
+	 * Stop watching fd, must be called before the descriptor is closed
+	 */
+	virtual void		remove(int fd) = 0;
+	
+	/**
+	 * Wait up to timeoutMs (-1 for no limit) and fill ready with the
+	 * descriptors that can make progress. Returns the number of events
+	 * or -1 on error (errno is preserved).
+	 */
+	virtual int			wait(std::vector<PollEvent>& ready, int timeoutMs) = 0;
+	
+	/**
+	 * Get the backend name as used in the configuration file
+	 */
+	virtual const char*	getName(void) const = 0;
+	
+	/**
+	 * Check whether a backend name is known to this build
+	 */
+	static bool			isSupported(const std::string& backend);
+	
+	/**
+	 * Create the backend with the given name, throws on unknown names
+	 */
+	static EventPoller*	create(const std::string& backend);
+	
+	/**
+	 * Get the backend used when the configuration does not choose one
+	 */
+	static std::string	getDefaultBackend(void);
+};
+
+#endif
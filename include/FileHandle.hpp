@@ -0,0 +1,101 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FileHandle.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/21 14:12:50 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/21 14:12:50 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FILE_HANDLE_HPP
+# define FILE_HANDLE_HPP
+
+# include <string>
+# include <sys/types.h>
+
+/**
+ * @class FileHandle
+ * @brief Shared ownership of an open file descriptor
+ * 
+ * Responses are copied on their way to the connection's queue, and a
+ * file body has to survive every copy without a dup() each time.
+ * Copies share one descriptor, closed when the last copy goes. The
+ * count is not atomic: a handle stays on the thread that opened it.
+ */
+class FileHandle
+{
+private:
+	/**
+	 * @struct Shared
+	 * @brief The descriptor and how many handles use it
+	 */
+	struct Shared
+	{
+		int		fd;
+		size_t	references;
+	};
+	
+	Shared*				_shared;  // NULL when empty
+	
+	/**
+	 * Drop this handle's reference, closing the descriptor on the last
+	 */
+	void				release(void);
+
+public:
+	/**
+	 * Default constructor, the handle starts empty
+	 */
+	FileHandle(void);
+	
+	/**
+	 * Take ownership of an open descriptor
+	 */
+	explicit FileHandle(int fd);
+	
+	/**
+	 * Copy constructor, shares the descriptor
+	 */
+	FileHandle(const FileHandle& other);
+	
+	/**
+	 * Destructor
+	 */
+	~FileHandle(void);
+	
+	/**
+	 * Assignment operator, shares the descriptor
+	 */
+	FileHandle&			operator=(const FileHandle& other);
+	
+	/**
+	 * Open a file for reading, empty handle on failure (errno is set)
+	 */
+	static FileHandle	open(const std::string& path);
+	
+	/**
+	 * Get the descriptor, -1 when empty
+	 */
+	int					getFd(void) const;
+	
+	/**
+	 * Check if the handle holds a descriptor
+	 */
+	bool				isOpen(void) const;
+	
+	/**
+	 * Let go of the descriptor; other copies keep it open
+	 */
+	void				reset(void);
+	
+	/**
+	 * Read at an offset, without moving a file position other copies
+	 * may rely on; returns the bytes read or -1
+	 */
+	ssize_t				read(off_t offset, char* into, size_t length) const;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HeaderTable.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/15 11:05:44 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/15 11:05:44 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef HEADER_TABLE_HPP
+# define HEADER_TABLE_HPP
+
+# include <cstddef>
+
+/**
+ * @enum HeaderId
+ * @brief Request header fields the server knows by name
+ */
+enum HeaderId
+{
+	HEADER_HOST,
+	HEADER_CONNECTION,
+	HEADER_CONTENT_LENGTH,
+	HEADER_CONTENT_TYPE,
+	HEADER_TRANSFER_ENCODING,
+	HEADER_EXPECT,
+	HEADER_ACCEPT,
+	HEADER_ACCEPT_ENCODING,
+	HEADER_ACCEPT_LANGUAGE,
+	HEADER_AUTHORIZATION,
+	HEADER_COOKIE,
+	HEADER_USER_AGENT,
+	HEADER_REFERER,
+	HEADER_ORIGIN,
+	HEADER_CACHE_CONTROL,
+	HEADER_PRAGMA,
+	HEADER_IF_MODIFIED_SINCE,
+	HEADER_IF_NONE_MATCH,
+	HEADER_IF_RANGE,
+	HEADER_IF_MATCH,
+	HEADER_IF_UNMODIFIED_SINCE,
+	HEADER_RANGE,
+	HEADER_UPGRADE,
+	HEADER_HTTP2_SETTINGS,
+	HEADER_TE,
+	HEADER_KEEP_ALIVE,
+	HEADER_X_FORWARDED_FOR,
+	HEADER_COUNT,
+	HEADER_UNKNOWN = HEADER_COUNT
+};
+
+/**
+ * @class HeaderTable
+ * @brief Maps header field names to HeaderId and back
+ * 
+ * Lookups use a perfect hash over the known names (same scheme as
+ * gperf: the length plus a weight for the 2nd, 3rd and last character),
+ * so a name costs one table probe and one case-insensitive compare.
+ */
+class HeaderTable
+{
+public:
+	/**
+	 * Get the id of a field name in any case, HEADER_UNKNOWN if the
+	 * name is not a known one
+	 */
+	static HeaderId		lookup(const char* name, size_t length);
+	
+	/**
+	 * Get the canonical spelling of a known field name
+	 */
+	static const char*	getName(HeaderId id);
+};
+
+#endif
@@ -0,0 +1,99 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Hpack.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/20 11:02:37 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/20 11:02:37 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef HPACK_HPP
+# define HPACK_HPP
+
+# include <string>
+# include <vector>
+# include <deque>
+# include <utility>
+# include <cstddef>
+
+/**
+ * One decoded header field, name first
+ */
+typedef std::pair<std::string, std::string>	HeaderField;
+
+/**
+ * @class Hpack
+ * @brief HTTP/2 header compression (RFC 7541)
+ * 
+ * An instance holds the dynamic table of one direction of a connection
+ * and decodes the header blocks the peer sends. Encoding is stateless:
+ * responses are written as literals that never enter the peer's table,
+ * using the static table for names and common statuses.
+ */
+class Hpack
+{
+private:
+	std::deque<HeaderField>	_table;  // newest entry first
+	size_t					_tableSize;
+	size_t					_maxTableSize;  // set by the peer, up to the limit
+	size_t					_tableSizeLimit;  // what our SETTINGS allow
+	
+	/**
+	 * Get the field at an index of the static or dynamic table
+	 */
+	bool					lookup(size_t index, HeaderField& field) const;
+	
+	/**
+	 * Add a field to the dynamic table, evicting the oldest as needed
+	 */
+	void					insert(const HeaderField& field);
+	
+	/**
+	 * Drop the oldest entries until the table fits in size bytes
+	 */
+	void					evict(size_t size);
+
+public:
+	/**
+	 * Default constructor, a 4096 byte table as the protocol starts with
+	 */
+	Hpack(void);
+	
+	/**
+	 * Copy constructor
+	 */
+	Hpack(const Hpack& other);
+	
+	/**
+	 * Destructor
+	 */
+	~Hpack(void);
+	
+	/**
+	 * Assignment operator
+	 */
+	Hpack&					operator=(const Hpack& other);
+	
+	/**
+	 * Decode a complete header block, false on a compression error,
+	 * which is fatal to the connection
+	 */
+	bool					decode(const char* data, size_t length, 
+								std::vector<HeaderField>& fields);
+	
+	/**
+	 * Append the encoding of a status pseudo-header
+	 */
+	static void				encodeStatus(int statusCode, std::string& out);
+	
+	/**
+	 * Append the encoding of a field (name in lowercase)
+	 */
+	static void				encode(const std::string& name, 
+								const std::string& value, std::string& out);
+};
+
+#endif
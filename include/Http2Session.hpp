@@ -0,0 +1,312 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Http2Session.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/20 15:40:12 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/20 15:40:12 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef HTTP2_SESSION_HPP
+# define HTTP2_SESSION_HPP
+
+# include <map>
+# include <string>
+# include <vector>
+# include <stdint.h>
+# include <netinet/in.h>
+# include "Buffer.hpp"
+# include "Config.hpp"
+# include "ClientSocket.hpp"
+# include "Hpack.hpp"
+# include "HttpRequest.hpp"
+# include "HttpResponse.hpp"
+# include "Logger.hpp"
+
+/**
+ * @enum Http2FrameType
+ * @brief Frame types of RFC 9113 section 6
+ */
+enum Http2FrameType
+{
+	H2_DATA = 0x0,
+	H2_HEADERS = 0x1,
+	H2_PRIORITY = 0x2,
+	H2_RST_STREAM = 0x3,
+	H2_SETTINGS = 0x4,
+	H2_PUSH_PROMISE = 0x5,
+	H2_PING = 0x6,
+	H2_GOAWAY = 0x7,
+	H2_WINDOW_UPDATE = 0x8,
+	H2_CONTINUATION = 0x9
+};
+
+/**
+ * @enum Http2Error
+ * @brief Error codes of RFC 9113 section 7
+ */
+enum Http2Error
+{
+	H2_NO_ERROR = 0x0,
+	H2_PROTOCOL_ERROR = 0x1,
+	H2_INTERNAL_ERROR = 0x2,
+	H2_FLOW_CONTROL_ERROR = 0x3,
+	H2_STREAM_CLOSED = 0x5,
+	H2_FRAME_SIZE_ERROR = 0x6,
+	H2_REFUSED_STREAM = 0x7,
+	H2_COMPRESSION_ERROR = 0x9,
+	H2_ENHANCE_YOUR_CALM = 0xb
+};
+
+/**
+ * @class Http2Session
+ * @brief One cleartext HTTP/2 connection (h2c)
+ * 
+ * The session turns frames into requests and responses into frames.
+ * Each stream owns an HttpRequest, fed the request as HTTP/1.1 text
+ * rebuilt from the decoded header block and DATA frames. The usual
+ * parser, limits, routing and handlers then run unchanged. Responses go
+ * out as HEADERS plus DATA frames. The DATA frames are interleaved
+ * across streams within the peer's flow control windows.
+ */
+class Http2Session
+{
+private:
+	/**
+	 * @struct Stream
+	 * @brief A request/response exchange on the connection
+	 */
+	struct Stream
+	{
+		uint32_t		id;
+		HttpRequest		request;
+		bool			chunked;      // the body is fed as chunks
+		bool			remoteClosed; // the peer sent END_STREAM
+		bool			responded;    // the response HEADERS were queued
+		HttpResponse	response;
+		size_t			bodyLength;   // response body to send
+		size_t			bodySent;
+		int64_t			sendWindow;
+		size_t			consumed;     // bytes received since WINDOW_UPDATE
+	};
+	
+	const Config&				_config;
+	const VirtualHostTable*		_virtualHosts;
+	OpenFileCache*				_fileCache;
+	struct sockaddr_in			_clientAddr;
+	Hpack						_decoder;
+	Buffer						_input;
+	Buffer						_output;
+	std::map<uint32_t, Stream*>	_streams;
+	uint32_t					_lastStreamId;
+	std::string					_headerBlock;  // HEADERS and CONTINUATION
+	uint32_t					_blockStream;  // 0 unless a block is open
+	bool						_blockEndStream;
+	bool						_prefaceReceived;
+	bool						_goingAway;  // GOAWAY sent, input is ignored
+	bool						_draining;  // graceful GOAWAY either way, no new streams
+	int64_t						_sendWindow;  // connection level
+	int64_t						_initialWindow;  // peer's stream windows
+	size_t						_maxFrameSize;  // largest frame the peer takes
+	size_t						_consumed;  // bytes received since WINDOW_UPDATE
+	unsigned long				_answered;  // requests answered so far
+	Logger						_logger;
+	
+	/**
+	 * Copy constructor - private, a session owns its streams
+	 */
+	Http2Session(const Http2Session& other);
+	
+	/**
+	 * Assignment operator - private, a session owns its streams
+	 */
+	Http2Session&				operator=(const Http2Session& other);
+	
+	/**
+	 * Parse every complete frame in the input
+	 */
+	void						process(void);
+	
+	/**
+	 * Handle one frame, false once the connection is failing
+	 */
+	bool						handleFrame(uint8_t type, uint8_t flags, 
+									uint32_t streamId, const char* payload, 
+									size_t length);
+	
+	/**
+	 * Handle a SETTINGS frame
+	 */
+	bool						handleSettings(uint8_t flags, uint32_t streamId, 
+									const char* payload, size_t length);
+	
+	/**
+	 * Apply settings sent by the peer
+	 */
+	bool						applySettings(const char* payload, size_t length);
+	
+	/**
+	 * Handle a HEADERS or CONTINUATION frame
+	 */
+	bool						handleHeaders(uint8_t type, uint8_t flags, 
+									uint32_t streamId, const char* payload, 
+									size_t length);
+	
+	/**
+	 * Decode a complete header block and start or finish its request
+	 */
+	bool						finishHeaderBlock(void);
+	
+	/**
+	 * Rebuild the HTTP/1.1 head of a request from its header fields,
+	 * false if the fields are malformed (RFC 9113 8.1.1)
+	 */
+	bool						buildHead(Stream* stream, 
+									const std::vector<HeaderField>& fields, 
+									std::string& head);
+	
+	/**
+	 * Handle a DATA frame
+	 */
+	bool						handleData(uint8_t flags, uint32_t streamId, 
+									const char* payload, size_t length);
+	
+	/**
+	 * Handle a WINDOW_UPDATE frame
+	 */
+	bool						handleWindowUpdate(uint32_t streamId, 
+									const char* payload, size_t length);
+	
+	/**
+	 * Feed part of a request body to the stream's parser
+	 */
+	void						feedBody(Stream* stream, const char* data, 
+									size_t length);
+	
+	/**
+	 * Mark the end of a request body
+	 */
+	void						finishBody(Stream* stream);
+	
+	/**
+	 * Run the handlers for a complete request and queue the response
+	 */
+	void						respond(Stream* stream);
+	
+	/**
+	 * Queue DATA frames for pending response bodies, within the windows
+	 */
+	void						pump(void);
+	
+	/**
+	 * Forget a stream
+	 */
+	void						closeStream(uint32_t streamId);
+	
+	/**
+	 * Find an open stream, NULL if there is none
+	 */
+	Stream*						findStream(uint32_t streamId) const;
+	
+	/**
+	 * Queue a frame
+	 */
+	void						writeFrame(uint8_t type, uint8_t flags, 
+									uint32_t streamId, const char* payload, 
+									size_t length);
+	
+	/**
+	 * Write a frame header into the output's free space and get room for
+	 * its payload; the frame is queued by committing both
+	 */
+	char*						prepareFrame(uint8_t type, uint8_t flags, 
+									uint32_t streamId, size_t length);
+	
+	/**
+	 * Queue a WINDOW_UPDATE frame
+	 */
+	void						writeWindowUpdate(uint32_t streamId, 
+									uint32_t increment);
+	
+	/**
+	 * Queue a RST_STREAM frame and forget the stream
+	 */
+	void						resetStream(uint32_t streamId, Http2Error error);
+	
+	/**
+	 * Queue a GOAWAY frame; the connection closes once it is sent
+	 */
+	bool						fail(Http2Error error, const char* reason);
+
+public:
+	/**
+	 * Constructor for a connection accepted on a listener
+	 */
+	Http2Session(const Config& config, const VirtualHostTable* virtualHosts, 
+		OpenFileCache* fileCache, const struct sockaddr_in& clientAddr);
+	
+	/**
+	 * Destructor
+	 */
+	~Http2Session(void);
+	
+	/**
+	 * Start a prior-knowledge connection: queue the server preface
+	 */
+	void						start(void);
+	
+	/**
+	 * Take over an HTTP/1.1 connection whose request asked for h2c: queue
+	 * 101 Switching Protocols and the server preface; the request is
+	 * answered on stream 1. False if its HTTP2-Settings are invalid.
+	 */
+	bool						upgrade(const HttpRequest& request);
+	
+	/**
+	 * Handle bytes that were received before the session took over
+	 */
+	void						receive(const char* data, size_t length);
+	
+	/**
+	 * Read and handle everything available on the socket
+	 * Returns false when the peer closed the connection or failed
+	 */
+	bool						read(ClientSocket& clientSocket);
+	
+	/**
+	 * Send queued frames until the socket is full
+	 * Returns false on a send error
+	 */
+	bool						flush(ClientSocket& clientSocket);
+	
+	/**
+	 * Check if frames are waiting to be sent
+	 */
+	bool						hasOutput(void) const;
+	
+	/**
+	 * Check if any stream is open
+	 */
+	bool						hasStreams(void) const;
+	
+	/**
+	 * Get the number of requests answered on the connection
+	 */
+	unsigned long				getAnswered(void) const;
+	
+	/**
+	 * Check if the connection should close now
+	 */
+	bool						isFinished(void) const;
+	
+	/**
+	 * Refuse new streams with a graceful GOAWAY; the connection closes
+	 * once the open streams are answered
+	 */
+	void						goAway(void);
+};
+
+#endif
@@ -0,0 +1,42 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HttpDate.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/26 11:20:44 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/26 11:20:44 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef HTTP_DATE_HPP
+# define HTTP_DATE_HPP
+
+# include <string>
+# include <ctime>
+
+/**
+ * @class HttpDate
+ * @brief Reads and writes the HTTP-date format (RFC 9110 5.6.7)
+ * 
+ * Dates are always written as IMF-fixdate. Reading also takes the two
+ * obsolete forms, RFC 850 and asctime(), since clients may still send
+ * them.
+ */
+class HttpDate
+{
+public:
+	/**
+	 * Format a time as IMF-fixdate (Sun, 06 Nov 1994 08:49:37 GMT)
+	 */
+	static std::string	format(time_t time);
+	
+	/**
+	 * Parse an HTTP-date in any of its three forms, false if it is not
+	 * one
+	 */
+	static bool			parse(const std::string& value, time_t& time);
+};
+
+#endif
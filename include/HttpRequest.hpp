@@ -15,11 +15,19 @@
 
 # include <string>
 # include <map>
-# include "Socket.hpp"
+# include <vector>
+# include "Arena.hpp"
+# include "Buffer.hpp"
+# include "HeaderTable.hpp"
+# include "MethodTable.hpp"
+# include "RequestBody.hpp"
+# include "ClientSocket.hpp"
 # include "Config.hpp"
 # include "HttpResponse.hpp"
 # include "CgiHandler.hpp"
 # include "Logger.hpp"
+# include "OpenFileCache.hpp"
+# include "ResponseCache.hpp"
 
 /**
  * @enum ParseState
@@ -37,6 +45,36 @@ enum ParseState
 	ERROR
 };
 
+/**
+ * @struct ByteRange
+ * @brief Positions of the first and last byte of a requested range
+ */
+struct ByteRange
+{
+	off_t	first;
+	off_t	last;
+};
+
+/**
+ * @struct TextView
+ * @brief A span of the request head, as an offset and a length
+ */
+struct TextView
+{
+	size_t	offset;
+	size_t	length;
+};
+
+/**
+ * @struct HeaderView
+ * @brief One header field of the request head
+ */
+struct HeaderView
+{
+	TextView	name;
+	TextView	value;
+};
+
 /**
  * @class HttpRequest
  * @brief Handles HTTP request parsing and processing
@@ -51,20 +89,59 @@ private:
 	std::string							_method;
 	std::string							_uri;
 	std::string							_httpVersion;
+	HttpMethod							_methodId;  // parsed with the request line
+	int									_minorVersion;  // HTTP/1.x
 	std::string							_path;
 	std::string							_query;
-	std::map<std::string, std::string>	_headers;
-	std::string							_body;
+	Arena								_arena;  // memory of this request only
+	const char*							_head;  // request line and headers, in the arena
+	size_t								_headLength;
+	TextView							_methodView;
+	TextView							_uriView;
+	TextView							_versionView;
+	HeaderView							_knownHeaders[HEADER_COUNT];  // empty name if absent
+	HeaderView*							_otherHeaders;  // in the arena
+	size_t								_otherCount;
+	size_t								_otherCapacity;
+	RequestBody							_body;
 	
 	ParseState							_state;
-	std::string							_buffer;
+	Buffer								_buffer;
+	size_t								_parsed;   // head bytes already parsed
+	size_t								_scanned;  // bytes known to hold no LF
+	int									_errorStatus;
 	size_t								_contentLength;
+	size_t								_bodyLimit;  // client_max_body_size in effect
+	bool								_expectContinue;  // 100 Continue owed
+	size_t								_recvSize;  // grows while reads come back full
 	size_t								_chunkSize;
 	bool								_chunked;
 	bool								_connectionError;
-	const ServerConfig*					_serverConfig;
+	bool								_http2Preface;  // PRI * HTTP/2.0 seen
+	const VirtualHostTable*				_virtualHosts;
+	const ServerConfig*					_serverConfig;  // resolved from Host
+	OpenFileCache*						_fileCache;  // the thread's, may be NULL
+	ResponseCache*						_responseCache;  // HTTP/1 only, may be NULL
+	struct sockaddr_in					_clientAddr;
 	Logger								_logger;
 	
+	/**
+	 * Run the state machine over the buffered bytes
+	 * Returns true when the request is complete or rejected
+	 */
+	bool								parse(void);
+	
+	/**
+	 * Find the next LF in the buffer without rescanning bytes already
+	 * searched, npos if the line is not complete yet
+	 */
+	size_t								findLineEnd(void);
+	
+	/**
+	 * Stop parsing and answer with the given error status
+	 */
+	bool								reject(int statusCode, const char* reason);
+	
 	/**
 	 * Parse the request line (GET /path HTTP/1.1)
 	 */
@@ -75,6 +152,51 @@ private:
 	 */
 	bool								parseHeaders(void);
 	
+	/**
+	 * Record a field that has no slot of its own
+	 */
+	void								addOtherHeader(const HeaderView& header);
+	
+	/**
+	 * Copy the head and the field list of another request into this
+	 * request's arena
+	 */
+	void								copyHead(const HttpRequest& other);
+	
+	/**
+	 * Copy the head out of the buffer once and pick the body framing
+	 */
+	bool								finishHeaders(void);
+	
+	/**
+	 * Answer Expect: 100-continue once the body is about to be read
+	 */
+	void								sendContinue(ClientSocket& clientSocket);
+	
+	/**
+	 * Get the text of a view into the head
+	 */
+	std::string							viewString(const TextView& view) const;
+	
+	/**
+	 * Check whether a view into the head contains a word, in any case
+	 */
+	bool								containsNoCase(const TextView& view, 
+											const char* word) const;
+	
+	/**
+	 * Check whether the last element of a comma-separated list in the
+	 * head is exactly the given token, in any case
+	 */
+	bool								endsWithToken(const TextView& view, 
+											const char* token) const;
+	
+	/**
+	 * Read a view into the head as a decimal length, false if it is not
+	 */
+	bool								parseLength(const TextView& view, 
+											size_t& length) const;
+	
 	/**
 	 * Parse request body
 	 */
@@ -90,30 +212,105 @@ private:
 	 */
 	bool								parseChunkedData(void);
 	
+	/**
+	 * Skip the trailer fields after the last chunk
+	 */
+	bool								parseChunkedTrailer(void);
+	
 	/**
 	 * Find the location configuration for this request
 	 */
 	const LocationConfig*				findLocation(const ServerConfig& server) const;
 	
+	/**
+	 * Handler of a method, called once the location allows it
+	 */
+	typedef HttpResponse	(HttpRequest::*MethodHandler)(
+		const LocationConfig& location, HttpResponse& response, 
+		const Config& config);
+	
+	/**
+	 * Handlers indexed by HttpMethod, NULL for methods not implemented
+	 */
+	static const MethodHandler			_handlers[METHOD_COUNT];
+	
 	/**
 	 * Handle GET request for static file serving
 	 */
 	HttpResponse						handleGet(const LocationConfig& location, 
 												HttpResponse& response, const Config& config);
 	
-	HttpResponse handlePost(LocationConfig const &location, 
-		HttpResponse &response, Config const &config);
+	/**
+	 * Look a path up, through the file cache when there is one
+	 */
+	FileInfo							lookupFile(const std::string& path);
+	
+	/**
+	 * Drop a path this request wrote or removed from the caches
+	 */
+	void								forgetFile(const std::string& path);
 	
 	/**
-	 * Handle DELETE request for file deletion
+	 * Build the strong entity tag of a file version from its inode,
+	 * size and modification time to the nanosecond
 	 */
-	HttpResponse						handleDelete(const LocationConfig& location, 
+	static std::string					makeEntityTag(const FileInfo& info);
+	
+	/**
+	 * Check whether a list of entity tags (or *) holds a tag, ignoring
+	 * weakness as If-None-Match does
+	 */
+	static bool							listsEntityTag(const std::string& list, 
+											const std::string& tag);
+	
+	/**
+	 * Check whether the validators sent with the request still match
+	 * the file, so a 304 can stand for it
+	 */
+	bool								isNotModified(const std::string& tag, 
+											time_t mtime) const;
+	
+	/**
+	 * Check whether a Range may be honoured: no If-Range, or one that
+	 * still names this version of the file
+	 */
+	bool								isRangeFresh(const std::string& tag, 
+											time_t mtime) const;
+	
+	/**
+	 * Parse a Range header against the file size; returns 206 with the
+	 * ranges to send, 416 if none can be, or 200 to ignore the header
+	 */
+	static int							parseRanges(const std::string& value, 
+											off_t size, std::vector<ByteRange>& ranges);
+	
+	/**
+	 * Answer a GET with the requested ranges of a file, as one part or
+	 * as multipart/byteranges
+	 */
+	HttpResponse						serveRanges(const FileInfo& info, 
+												const std::string& path, 
+												const std::vector<ByteRange>& ranges, 
 												HttpResponse& response, const Config& config);
 	
 	/**
-	 * Get MIME type for file extension
+	 * Answer with an open file found for a GET
+	 */
+	HttpResponse						serveFile(const FileInfo& info, 
+												const std::string& path, HttpResponse& response, 
+												const Config& config);
+	
+	/**
+	 * Handle POST request for uploads and form data
 	 */
-	std::string							getMimeType(const std::string& filename) const;
+	HttpResponse						handlePost(const LocationConfig& location, 
+												HttpResponse& response, const Config& config);
+	
+	/**
+	 * Handle DELETE request for file deletion
+	 */
+	HttpResponse						handleDelete(const LocationConfig& location, 
+												HttpResponse& response, const Config& config);
 	
 	/**
 	 * Check if path is safe and within allowed directory
@@ -162,11 +359,50 @@ public:
 	 */
 	HttpRequest&		operator=(const HttpRequest& other);
 	
+	/**
+	 * Start the next request on the same connection; the memory of the
+	 * previous one and any bytes already received are kept for it
+	 */
+	void								reset(void);
+	
+	/**
+	 * Give back the memory a large request left behind, before the
+	 * connection waits idle for the next one
+	 */
+	void								shrink(void);
+	
+	/**
+	 * Parse a pipelined request from bytes already received; a 100
+	 * Continue it is owed waits for continueIfOwed()
+	 * Returns true when it is complete
+	 */
+	bool								resume(void);
+	
+	/**
+	 * Send the 100 Continue a pipelined request is owed, once the
+	 * responses queued ahead of it are out
+	 */
+	void								continueIfOwed(ClientSocket& clientSocket);
+	
 	/**
 	 * Read and parse data from a client socket
 	 * Returns true when request is complete
 	 */
-	bool								read(Socket& clientSocket);
+	bool								read(ClientSocket& clientSocket);
+	
+	/**
+	 * Parse data the event backend already received for the client
+	 * socket; length is the receive's result, a negative errno on error
+	 * Returns true when request is complete
+	 */
+	bool								receive(ClientSocket& clientSocket, 
+											const char* data, ssize_t length);
+	
+	/**
+	 * Keep data received while a response is being sent, for the
+	 * request that follows it
+	 */
+	void								stash(const char* data, ssize_t length);
 	
 	/**
 	 * Process the request and generate a response
@@ -178,6 +414,11 @@ public:
 	 */
 	const std::string&					getMethod(void) const;
 	
+	/**
+	 * Get the request method as parsed from the request line
+	 */
+	HttpMethod							getMethodId(void) const;
+	
 	/**
 	 * Get the request URI
 	 */
@@ -189,19 +430,57 @@ public:
 	const std::string&					getHttpVersion(void) const;
 	
 	/**
-	 * Get a specific header value
+	 * Get a known header value, empty if absent
+	 */
+	std::string							getHeader(HeaderId id) const;
+	
+	/**
+	 * Get a specific header value by name, in any case
 	 */
 	std::string							getHeader(const std::string& name) const;
 	
 	/**
-	 * Get all headers
+	 * Check if a known header was sent
+	 */
+	bool								hasHeader(HeaderId id) const;
+	
+	/**
+	 * Get all headers, built from the parsed views on demand
 	 */
-	const std::map<std::string, std::string>&	getHeaders(void) const;
+	std::map<std::string, std::string>	getHeaders(void) const;
 	
 	/**
 	 * Get the request body
 	 */
-	const std::string&					getBody(void) const;
+	const RequestBody&					getBody(void) const;
+	
+	/**
+	 * Parse bytes handed over by another protocol layer
+	 * Returns true when the request is complete or rejected
+	 */
+	bool								feed(const char* data, size_t length);
+	
+	/**
+	 * Move the bytes received but not parsed to another buffer
+	 */
+	void								takeBuffered(Buffer& into);
+	
+	/**
+	 * Check if the connection opened with the HTTP/2 preface instead of
+	 * a request; the preface is left unparsed in the buffer
+	 */
+	bool								isHttp2Preface(void) const;
+	
+	/**
+	 * Check if the request asks to upgrade the connection to h2c
+	 */
+	bool								wantsHttp2Upgrade(void) const;
+	
+	/**
+	 * Check if the client lets the connection stay open after this
+	 * request (RFC 9112 9.3)
+	 */
+	bool								wantsKeepAlive(void) const;
 	
 	/**
 	 * Check if there was a connection error (should close connection)
@@ -209,9 +488,48 @@ public:
 	bool								hasConnectionError(void) const;
 	
 	/**
-	 * Set server configuration for size validation during parsing
+	 * Check if any byte of this request has been received yet
+	 */
+	bool								hasReceivedData(void) const;
+	
+	/**
+	 * Check if the headers are done and the body is being received
+	 */
+	bool								isReadingBody(void) const;
+	
+	/**
+	 * Set the virtual hosts of the listener the request arrived on; the
+	 * server is resolved from the Host header as soon as the headers end
+	 */
+	void								setVirtualHosts(const VirtualHostTable* virtualHosts);
+	
+	/**
+	 * Set the open file cache of the thread serving the request, NULL
+	 * to look every file up again
+	 */
+	void								setFileCache(OpenFileCache* fileCache);
+	
+	/**
+	 * Set the response cache of the thread serving the request, NULL
+	 * to build every response
+	 */
+	void								setResponseCache(ResponseCache* responseCache);
+	
+	/**
+	 * Get the server handling this request (the listener's default until
+	 * the headers are parsed)
+	 */
+	const ServerConfig*					getServerConfig(void) const;
+	
+	/**
+	 * Set the peer address of the connection the request came from
+	 */
+	void								setClientAddress(const struct sockaddr_in& addr);
+	
+	/**
+	 * Get the peer address of the connection the request came from
 	 */
-	void								setServerConfig(const ServerConfig* serverConfig);
+	const struct sockaddr_in&			getClientAddress(void) const;
 };
 
 #endif
@@ -16,9 +16,23 @@
 # include <string>
 # include <map>
 # include <vector>
-# include "Socket.hpp"
+# include "ClientSocket.hpp"
+# include <sys/uio.h>
+# include "FileHandle.hpp"
+# include "SharedBuffer.hpp"
 # include "Logger.hpp"
 
+/**
+ * @struct BodyPart
+ * @brief Text sent as is, then a range of the response's file
+ */
+struct BodyPart
+{
+	std::string		prefix;
+	off_t			offset;
+	size_t			length;
+};
+
 /**
  * @class HttpResponse
  * @brief Represents an HTTP response
@@ -33,7 +47,15 @@ private:
 	std::string						_statusText;
 	std::map<std::string, std::string>	_headers;
 	std::string						_body;
-	std::string						_rawResponse;
+	FileHandle						_file;  // body sent from a file instead
+	std::vector<BodyPart>			_parts;  // the file body, in order
+	size_t							_fileLength;  // bytes of all parts
+	size_t							_fileSent;
+	size_t							_part;  // part being sent
+	size_t							_partSent;  // bytes of it already sent
+	SharedBuffer					_shared;  // cached head fields and body, sent after the raw part
+	size_t							_sharedBody;  // body bytes at the end of _shared
+	std::string						_rawResponse;  // head, and the body unless a file or shared
 	size_t							_bytesSent;
 	bool							_keepAlive;
 	Logger							_logger;
@@ -52,6 +74,12 @@ private:
 	 * Get a formatted date string for HTTP headers
 	 */
 	std::string						getFormattedDate(void);
+	
+	/**
+	 * Record file body bytes handed to the socket, moving on to the
+	 * next part once one is done
+	 */
+	void							advanceFile(size_t length);
 
 public:
 	/**
@@ -90,6 +118,32 @@ public:
 	 */
 	void							setBody(const std::string& body);
 	
+	/**
+	 * Send a range of an open file as the body, without reading it
+	 */
+	void							setFile(const FileHandle& file, off_t offset, 
+									size_t length);
+	
+	/**
+	 * Send text and ranges of an open file as the body, without
+	 * reading the file
+	 */
+	void							setFileParts(const FileHandle& file, 
+									const std::vector<BodyPart>& parts);
+	
+	/**
+	 * Answer with a cached response: the head fields that never change
+	 * and the body, of which bodyLength bytes are body
+	 */
+	void							setShared(int statusCode, 
+									const SharedBuffer& cached, size_t bodyLength);
+	
+	/**
+	 * Move the head fields that do not change between requests and the
+	 * in-memory body into a buffer the cache can hand out again
+	 */
+	SharedBuffer					share(void);
+	
 	/**
 	 * Set whether to keep the connection alive
 	 */
@@ -101,10 +155,65 @@ public:
 	bool							shouldKeepAlive(void) const;
 	
 	/**
-	 * Send the response to a client socket
-	 * Returns true when the response has been fully sent
+	 * Fill in the headers every response carries: Date, Content-Length,
+	 * Connection, Content-Type and Server, unless already set
+	 */
+	void							addDefaultHeaders(void);
+	
+	/**
+	 * Get the status code
+	 */
+	int								getStatusCode(void) const;
+	
+	/**
+	 * Get the header fields
+	 */
+	const std::map<std::string, std::string>&	getHeaders(void) const;
+	
+	/**
+	 * Get the body length, in memory or in a file
+	 */
+	size_t							getBodyLength(void) const;
+	
+	/**
+	 * Copy body bytes starting at offset, whether they are in memory or
+	 * in a file; returns how many were copied, -1 on a read error
+	 */
+	ssize_t							readBody(size_t offset, char* into, 
+									size_t length) const;
+	
+	/**
+	 * Point at most max buffers at the bytes not sent yet, building the
+	 * raw response first; returns how many were used
+	 */
+	size_t							getPending(struct iovec* buffers, size_t max);
+	
+	/**
+	 * Record bytes handed to the socket, returns how many of them
+	 * belonged to this response
+	 */
+	size_t							markSent(size_t length);
+	
+	/**
+	 * Check if the body is sent from a file
+	 */
+	bool							hasFile(void) const;
+	
+	/**
+	 * Check if the head is out and the file body is next
+	 */
+	bool							isSendingFile(void) const;
+	
+	/**
+	 * Send the next piece of the file body; returns the bytes sent or
+	 * -1 with errno set
+	 */
+	ssize_t							sendFile(ClientSocket& clientSocket);
+	
+	/**
+	 * Check if the whole response has been sent
 	 */
-	bool							send(Socket& clientSocket);
+	bool							isSent(void) const;
 };
 
 #endif
@@ -33,6 +33,8 @@ class Logger {
 private:
 	LogLevel _filterLevel;
 
+	void flush(LogLevel level) const;
+
 public:
 	Logger();
 	Logger(LogLevel level);
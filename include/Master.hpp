@@ -0,0 +1,159 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Master.hpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/29 14:05:33 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/29 14:05:33 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MASTER_HPP
+# define MASTER_HPP
+
+# include <string>
+# include <vector>
+# include <ctime>
+# include <csignal>
+# include <sys/types.h>
+# include "Config.hpp"
+# include "Logger.hpp"
+
+/**
+ * @class Master
+ * @brief Supervisor of the worker processes (worker_processes > 1)
+ * 
+ * The master never touches client traffic. It forks one worker per slot;
+ * each worker runs its own Server and binds its own SO_REUSEPORT copy of
+ * every listening socket, so the kernel balances new connections across
+ * them. Workers that die are restarted, after a delay when they die
+ * right after starting and not at all once that keeps happening.
+ * SIGTERM/SIGINT are forwarded for a clean shutdown. SIGHUP reloads the
+ * configuration into a new generation of workers; once every new worker
+ * reports its listeners open, the old ones get SIGHUP, close theirs and
+ * exit when their connections are done.
+ */
+class Master
+{
+public:
+	/**
+	 * Entry point run by each worker process, returns its exit status;
+	 * it writes its pid to readyFd once it listens
+	 */
+	typedef int			(*WorkerMain)(const Config& config, int readyFd);
+
+private:
+	/**
+	 * @struct Worker
+	 * @brief One slot of the current worker generation
+	 */
+	struct Worker
+	{
+		pid_t			pid;        // 0 while the slot has no process
+		bool			ready;      // its listeners are open
+		unsigned long	spawnedAt;  // monotonic ms
+		unsigned long	retryAt;    // monotonic ms, 0 unless a restart waits
+		int				failures;   // exits right after start, in a row
+		
+		Worker() : pid(0), ready(false), spawnedAt(0), retryAt(0), 
+			failures(0) {}
+	};
+
+	std::string				_configPath;
+	Config					_config;
+	WorkerMain				_workerMain;
+	std::vector<Worker>		_workers;
+	std::vector<pid_t>		_previous;  // serve until the new generation is ready
+	std::vector<pid_t>		_retiring;  // draining their last connections
+	int						_readyFds[2];
+	sigset_t				_originalMask;
+	Logger					_logger;
+	
+	/**
+	 * Install the master signal handlers and block them outside ppoll
+	 */
+	void				setupSignals(void);
+	
+	/**
+	 * Fork the worker of a slot
+	 */
+	void				spawnWorker(size_t slot);
+	
+	/**
+	 * Restart the slots whose delay after a failed start has passed
+	 */
+	void				respawnDue(void);
+	
+	/**
+	 * Get the milliseconds until the next restart or retiring signal,
+	 * -1 if nothing is timed
+	 */
+	int					nextTimeout(void) const;
+	
+	/**
+	 * Mark the workers that reported their listeners open
+	 */
+	void				readReady(void);
+	
+	/**
+	 * Tell the previous generation to drain once every slot of the new
+	 * one is ready or given up
+	 */
+	void				retirePrevious(void);
+	
+	/**
+	 * Collect exited workers and restart the slots that are still wanted
+	 */
+	void				reapWorkers(void);
+	
+	/**
+	 * Check whether any worker runs or is about to be restarted
+	 */
+	bool				hasWorkers(void) const;
+	
+	/**
+	 * Re-read the configuration file and start a new worker generation
+	 */
+	void				reload(void);
+	
+	/**
+	 * Send a signal to every running worker, old generations included
+	 */
+	void				signalWorkers(int signum);
+	
+	/**
+	 * Forward SIGTERM and wait for every worker to exit
+	 */
+	void				shutdown(void);
+	
+	/**
+	 * Copy constructor - private to prevent copying
+	 */
+	Master(const Master& other);
+	
+	/**
+	 * Assignment operator - private to prevent assignment
+	 */
+	Master&				operator=(const Master& other);
+
+public:
+	/**
+	 * Constructor with the configuration and the worker entry point
+	 */
+	Master(const std::string& configPath, const Config& config,
+		WorkerMain workerMain);
+	
+	/**
+	 * Destructor
+	 */
+	~Master(void);
+	
+	/**
+	 * Spawn the workers and supervise them until shutdown
+	 */
+	int					run(void);
+};
+
+#endif
@@ -0,0 +1,71 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MethodTable.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/21 09:48:27 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/21 09:48:27 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef METHOD_TABLE_HPP
+# define METHOD_TABLE_HPP
+
+# include <cstddef>
+
+/**
+ * @enum HttpMethod
+ * @brief Request methods the server knows by name (RFC 9110 9.3)
+ */
+enum HttpMethod
+{
+	METHOD_GET,
+	METHOD_HEAD,
+	METHOD_POST,
+	METHOD_PUT,
+	METHOD_DELETE,
+	METHOD_CONNECT,
+	METHOD_OPTIONS,
+	METHOD_TRACE,
+	METHOD_PATCH,
+	METHOD_COUNT,
+	METHOD_UNKNOWN = METHOD_COUNT
+};
+
+/**
+ * @typedef MethodMask
+ * @brief A set of methods, one bit per HttpMethod
+ */
+typedef unsigned int	MethodMask;
+
+/**
+ * @class MethodTable
+ * @brief Maps method names to HttpMethod and back
+ * 
+ * Methods are case-sensitive, so a name is told apart by its length and
+ * first letter and confirmed with one compare.
+ */
+class MethodTable
+{
+public:
+	/**
+	 * Get the id of a method name, METHOD_UNKNOWN if the name is not a
+	 * known one
+	 */
+	static HttpMethod	lookup(const char* name, size_t length);
+	
+	/**
+	 * Get the name of a known method
+	 */
+	static const char*	getName(HttpMethod method);
+	
+	/**
+	 * Get the bit of a method in a MethodMask; unknown methods have a
+	 * bit of their own, which no configured mask sets
+	 */
+	static MethodMask	getBit(HttpMethod method);
+};
+
+#endif
@@ -0,0 +1,35 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MimeTypes.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/22 10:05:31 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/22 10:05:31 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MIME_TYPES_HPP
+# define MIME_TYPES_HPP
+
+# include <string>
+
+/**
+ * @class MimeTypes
+ * @brief Maps file names to the media type sent as Content-Type
+ * 
+ * The answer depends on the extension only, in any case. It is a
+ * static string, so callers can keep it without copying.
+ */
+class MimeTypes
+{
+public:
+	/**
+	 * Get the media type of a file name, application/octet-stream if
+	 * its extension is not a known one
+	 */
+	static const char*	lookup(const std::string& filename);
+};
+
+#endif
@@ -0,0 +1,148 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   OpenFileCache.hpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/22 10:05:31 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/22 10:05:31 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef OPEN_FILE_CACHE_HPP
+# define OPEN_FILE_CACHE_HPP
+
+# include <list>
+# include <map>
+# include <string>
+# include <sys/types.h>
+# include "FileHandle.hpp"
+
+/**
+ * @struct FileInfo
+ * @brief What a GET needs to know about a path, open when it is a file
+ */
+struct FileInfo
+{
+	FileHandle		file;         // open for regular files only
+	int				error;        // errno of the lookup, 0 if it was found
+	bool			isDirectory;
+	off_t			size;
+	time_t			mtime;
+	long			mtimeNsec;    // edits within a second tell apart
+	ino_t			inode;
+	dev_t			device;
+	const char*		mimeType;
+
+	FileInfo() : error(0), isDirectory(false), size(0), mtime(0), 
+		mtimeNsec(0), inode(0), device(0), mimeType(NULL) {}
+};
+
+/**
+ * @class OpenFileCache
+ * @brief Bounded LRU of open descriptors and stat results by path
+ * 
+ * A hit hands out the descriptor and metadata of an earlier lookup, so
+ * hot files are served without open(), fstat() or close(), and paths
+ * that did not exist are answered without asking the filesystem again.
+ * An entry is trusted for `valid` milliseconds; past that one stat()
+ * tells whether the file is still the same (device, inode, size and
+ * mtime to the nanosecond) before the entry is reopened. Each event-loop thread owns its
+ * cache, since the descriptors are shared without locking.
+ */
+class OpenFileCache
+{
+private:
+	/**
+	 * @struct Entry
+	 * @brief One cached path, most recently used first
+	 */
+	struct Entry
+	{
+		std::string		path;
+		FileInfo		info;
+		unsigned long	checkedAt;  // TimerWheel::nowMs() of the last stat
+	};
+	
+	typedef std::list<Entry>								EntryList;
+	typedef std::map<std::string, EntryList::iterator>		EntryIndex;
+	
+	size_t			_max;      // 0 disables the cache
+	unsigned long	_valid;    // milliseconds before an entry is checked again
+	bool			_errors;   // whether failed lookups are kept
+	EntryList		_entries;
+	EntryIndex		_index;
+	
+	/**
+	 * Check whether a failed lookup would fail again the same way
+	 */
+	static bool		isLasting(int error);
+	
+	/**
+	 * Check whether a cached entry still describes the file at its path
+	 */
+	static bool		isUnchanged(const Entry& entry);
+	
+	/**
+	 * Add a fresh entry in front, dropping the least recently used
+	 * ones past the limit
+	 */
+	void			insert(const std::string& path, const FileInfo& info, 
+						unsigned long now);
+
+public:
+	/**
+	 * Default constructor, the cache is disabled
+	 */
+	OpenFileCache(void);
+	
+	/**
+	 * Constructor with the entry limit, the validity in milliseconds
+	 * and whether failed lookups are cached
+	 */
+	OpenFileCache(size_t max, unsigned long valid, bool errors);
+	
+	/**
+	 * Copy constructor, starts empty with the same settings since the
+	 * descriptors belong to one thread
+	 */
+	OpenFileCache(const OpenFileCache& other);
+	
+	/**
+	 * Destructor, closes the descriptors no response still uses
+	 */
+	~OpenFileCache(void);
+	
+	/**
+	 * Assignment operator, takes the settings and drops the entries
+	 */
+	OpenFileCache&	operator=(const OpenFileCache& other);
+	
+	/**
+	 * Look a path up, from the cache when a recent entry exists
+	 */
+	FileInfo		lookup(const std::string& path);
+	
+	/**
+	 * Open and stat a path without caching it
+	 */
+	static void		load(const std::string& path, FileInfo& info);
+	
+	/**
+	 * Drop the entry of a path known to have changed
+	 */
+	void			forget(const std::string& path);
+	
+	/**
+	 * Get the number of cached paths
+	 */
+	size_t			size(void) const;
+	
+	/**
+	 * Drop every entry
+	 */
+	void			clear(void);
+};
+
+#endif
@@ -0,0 +1,40 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PollPoller.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 10:46:52 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 10:46:52 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef POLL_POLLER_HPP
+# define POLL_POLLER_HPP
+
+# include <poll.h>
+# include "EventPoller.hpp"
+
+/**
+ * @class PollPoller
+ * @brief Portable poll() backend without the FD_SETSIZE limit
+ */
+class PollPoller : public EventPoller
+{
+private:
+	std::vector<struct pollfd>	_pollFds;
+	std::vector<int>			_slots;  // fd -> index in _pollFds, -1 if unused
+
+public:
+	PollPoller(void);
+	~PollPoller(void);
+	
+	void				add(int fd, int events);
+	void				modify(int fd, int events);
+	void				remove(int fd);
+	int					wait(std::vector<PollEvent>& ready, int timeoutMs);
+	const char*			getName(void) const;
+};
+
+#endif
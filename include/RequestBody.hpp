@@ -0,0 +1,132 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   RequestBody.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/17 14:12:36 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/17 14:12:36 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef REQUEST_BODY_HPP
+# define REQUEST_BODY_HPP
+
+# include <string>
+# include <ostream>
+# include <cstddef>
+
+/**
+ * @class RequestBody
+ * @brief Request body kept in memory up to a threshold, then spooled
+ * 
+ * Bodies up to client_body_buffer_size stay in a string. A larger body
+ * moves to an unlinked temporary file under client_body_temp_path, so
+ * the memory held per upload stays bounded however large it is. The
+ * read side works the same for both: find, substr and writeTo read the
+ * file in blocks, and CGI can take the descriptor as its stdin.
+ */
+class RequestBody
+{
+private:
+	std::string		_memory;
+	int				_fd;         // temporary file, -1 while in memory
+	size_t			_size;
+	size_t			_threshold;
+	std::string		_tempPath;
+	
+	/**
+	 * Create the temporary file and move the memory part into it
+	 */
+	bool			spill(void);
+	
+	/**
+	 * Write the whole range to the temporary file
+	 */
+	bool			writeFile(const char* data, size_t length);
+	
+	/**
+	 * Read up to length bytes at offset, returns the count read
+	 */
+	size_t			readAt(char* data, size_t length, size_t offset) const;
+
+public:
+	/**
+	 * Default constructor, an empty in-memory body
+	 */
+	RequestBody(void);
+	
+	/**
+	 * Copy constructor, a spooled body shares its file by dup()
+	 */
+	RequestBody(const RequestBody& other);
+	
+	/**
+	 * Destructor, closing the file releases it
+	 */
+	~RequestBody(void);
+	
+	/**
+	 * Assignment operator
+	 */
+	RequestBody&	operator=(const RequestBody& other);
+	
+	/**
+	 * Set how much is kept in memory and where larger bodies go
+	 */
+	void			configure(size_t threshold, const std::string& tempPath);
+	
+	/**
+	 * Prepare for a body of known length, spooling at once if it will
+	 * not fit in memory. Returns false if the file cannot be created.
+	 */
+	bool			reserve(size_t length);
+	
+	/**
+	 * Add bytes at the end, false on a write error
+	 */
+	bool			append(const char* data, size_t length);
+	
+	/**
+	 * Drop the body, keeping the memory part's room for the next one
+	 */
+	void			clear(void);
+	
+	/**
+	 * Get the body length
+	 */
+	size_t			size(void) const;
+	
+	/**
+	 * Check whether the body is empty
+	 */
+	bool			empty(void) const;
+	
+	/**
+	 * Check whether the body lives in the temporary file
+	 */
+	bool			isSpooled(void) const;
+	
+	/**
+	 * Get the temporary file descriptor, -1 while in memory
+	 */
+	int				getFd(void) const;
+	
+	/**
+	 * Find needle at or after from, std::string::npos if absent
+	 */
+	size_t			find(const std::string& needle, size_t from = 0) const;
+	
+	/**
+	 * Copy out part of the body
+	 */
+	std::string		substr(size_t offset, size_t length) const;
+	
+	/**
+	 * Stream part of the body into out, false on a read error
+	 */
+	bool			writeTo(std::ostream& out, size_t offset, size_t length) const;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ResponseCache.hpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/24 14:12:08 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/24 14:12:08 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RESPONSE_CACHE_HPP
+# define RESPONSE_CACHE_HPP
+
+# include <list>
+# include <map>
+# include <string>
+# include <utility>
+# include "Config.hpp"
+# include "HttpResponse.hpp"
+# include "Logger.hpp"
+# include "OpenFileCache.hpp"
+# include "SharedBuffer.hpp"
+
+/**
+ * @class ResponseCache
+ * @brief Size-capped LRU of serialized static responses
+ * 
+ * Small files answered with a 200 are kept as the bytes that follow the
+ * status line, Date and Connection: every other head field and the
+ * body. A hit shares that buffer with the response, so it leaves in the
+ * same gathered write as its few per-request lines, with no filesystem
+ * access at all. Entries are keyed by server block and request path,
+ * which together pick the location, root and index. Freshness comes
+ * from inotify: the directory of every cached file is watched, and any
+ * change to the file, or to the directory itself, drops its entries.
+ * Each event-loop thread owns its cache.
+ */
+class ResponseCache
+{
+private:
+	typedef std::pair<const ServerConfig*, std::string>	Key;
+	
+	/**
+	 * @struct Entry
+	 * @brief One cached response, most recently used first
+	 */
+	struct Entry
+	{
+		Key				key;
+		SharedBuffer	response;    // head fields after Date, then the body
+		size_t			bodyLength;
+		std::string		file;        // path of the file it was read from
+		int				watch;       // watch descriptor of the file's directory
+		std::string		name;        // file name in that directory
+	};
+	
+	typedef std::list<Entry>						EntryList;
+	typedef std::map<Key, EntryList::iterator>		EntryIndex;
+	
+	size_t			_maxSize;       // bytes of all entries, 0 disables the cache
+	size_t			_maxEntrySize;  // largest body worth keeping
+	size_t			_used;
+	int				_inotifyFd;     // -1 until started
+	OpenFileCache*	_files;         // told about changed files, may be NULL
+	EntryList		_entries;
+	EntryIndex		_index;
+	Logger			_logger;
+	
+	/**
+	 * Drop one entry
+	 */
+	void			erase(EntryList::iterator entry);
+	
+	/**
+	 * Drop the entries of a file in a watched directory, or of the
+	 * whole directory when name is NULL
+	 */
+	void			invalidate(int watch, const char* name);
+
+public:
+	/**
+	 * Default constructor, the cache is disabled
+	 */
+	ResponseCache(void);
+	
+	/**
+	 * Constructor with the byte limit of all entries and of one body
+	 */
+	ResponseCache(size_t maxSize, size_t maxEntrySize);
+	
+	/**
+	 * Copy constructor, starts empty and stopped with the same settings
+	 */
+	ResponseCache(const ResponseCache& other);
+	
+	/**
+	 * Destructor, closes the inotify descriptor
+	 */
+	~ResponseCache(void);
+	
+	/**
+	 * Assignment operator, takes the settings and drops the entries
+	 */
+	ResponseCache&	operator=(const ResponseCache& other);
+	
+	/**
+	 * Open the inotify descriptor, false if the cache stays disabled;
+	 * files seen changing are dropped from the open file cache as well
+	 */
+	bool			start(OpenFileCache* files);
+	
+	/**
+	 * Get the inotify descriptor to wait on, -1 when disabled
+	 */
+	int				getFd(void) const;
+	
+	/**
+	 * Get the largest body worth reading into memory for the cache,
+	 * 0 when disabled
+	 */
+	size_t			getMaxEntrySize(void) const;
+	
+	/**
+	 * Answer from the cache, false on a miss
+	 */
+	bool			lookup(const ServerConfig* server, const std::string& path, 
+						HttpResponse& response);
+	
+	/**
+	 * Keep a 200 answered from a file in memory, unless it is too large
+	 * or the file changed since it was read
+	 */
+	void			store(const ServerConfig* server, const std::string& path, 
+						const std::string& filePath, const FileInfo& info, 
+						HttpResponse& response);
+	
+	/**
+	 * Read the pending inotify events and drop what they invalidate
+	 */
+	void			handleEvents(void);
+	
+	/**
+	 * Drop the entries read from a file this thread just changed,
+	 * without waiting for its inotify event
+	 */
+	void			forget(const std::string& file);
+	
+	/**
+	 * Get the number of cached responses
+	 */
+	size_t			size(void) const;
+	
+	/**
+	 * Drop every entry
+	 */
+	void			clear(void);
+};
+
+#endif
@@ -0,0 +1,41 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SelectPoller.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 10:31:07 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 10:31:07 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef SELECT_POLLER_HPP
+# define SELECT_POLLER_HPP
+
+# include <sys/select.h>
+# include "EventPoller.hpp"
+
+/**
+ * @class SelectPoller
+ * @brief Portable select() backend, limited to FD_SETSIZE descriptors
+ */
+class SelectPoller : public EventPoller
+{
+private:
+	fd_set				_readFds;
+	fd_set				_writeFds;
+	int					_maxFd;
+
+public:
+	SelectPoller(void);
+	~SelectPoller(void);
+	
+	void				add(int fd, int events);
+	void				modify(int fd, int events);
+	void				remove(int fd);
+	int					wait(std::vector<PollEvent>& ready, int timeoutMs);
+	const char*			getName(void) const;
+};
+
+#endif
@@ -17,11 +17,29 @@
 # include <vector>
 # include <string>
 # include <sys/time.h>
+# include <pthread.h>
 # include "Config.hpp"
 # include "Socket.hpp"
 # include "HttpRequest.hpp"
 # include "HttpResponse.hpp"
 # include "Logger.hpp"
+# include "EventPoller.hpp"
+# include "TimerWheel.hpp"
+# include "Connection.hpp"
+# include "OpenFileCache.hpp"
+# include "ResponseCache.hpp"
+
+/**
+ * @enum ConnectionTimer
+ * @brief What a client connection is currently waiting for
+ */
+enum ConnectionTimer
+{
+	TIMER_HEADER,     // client_header_timeout, 408 once bytes arrived
+	TIMER_BODY,       // client_body_timeout, 408
+	TIMER_KEEPALIVE,  // keepalive_timeout, silent close
+	TIMER_SEND        // send_timeout, silent close
+};
 
 /**
  * @class Server
@@ -29,41 +47,198 @@
  * 
  * This class is responsible for initializing server sockets based on configuration,
  * accepting new connections, processing HTTP requests, and sending responses.
- * It implements a non-blocking I/O model using poll() as required by the subject.
+ * It implements a non-blocking I/O model on top of an EventPoller backend
+ * (select, poll or epoll) chosen in the configuration file, so each loop
+ * iteration only dispatches the descriptors reported ready.
+ * 
+ * With worker_threads the server that owns the listeners becomes an
+ * acceptor and hands accepted descriptors to shard servers, each running
+ * its own event loop in its own thread with a private connection table.
+ * 
+ * Every client connection has one timer in a TimerWheel owned by the event
+ * loop, re-armed as it moves between reading headers, reading the body,
+ * sending and idling in keep-alive; the poller never blocks past the next
+ * timer that can fire.
  */
 class Server
 {
 private:
+	/**
+	 * A connection accepted by the acceptor, waiting for its shard
+	 */
+	struct Handoff
+	{
+		int					fd;
+		struct sockaddr_in	addr;
+		const VirtualHostTable*	vhosts;
+	};
+	
 	const Config*				_config;  // Changed to pointer to allow default constructor
+	bool						_supervised;  // a worker of the master process
 	std::vector<Socket>			_listenSockets;
-	std::map<int, Socket>		_clientSockets;
-	std::map<int, HttpRequest>	_requests;
-	std::map<int, HttpResponse>	_responses;
-	fd_set						_readFds;
-	fd_set						_writeFds;
-	fd_set						_errorFds;
-	int							_maxFd;
+	std::map<int, const VirtualHostTable*>	_listenHosts;  // per listen fd
+	std::vector<Connection*>	_connections;  // indexed by client fd
+	std::vector<Connection*>	_freeConnections;
+	EventPoller*				_poller;
+	std::vector<PollEvent>		_ready;
+	TimerWheel					_timers;
+	OpenFileCache				_fileCache;  // this thread's open files
+	ResponseCache				_responseCache;  // this thread's small responses
+	std::vector<TimerEvent>		_fired;
+	std::vector<Server*>		_shards;
+	std::vector<pthread_t>		_threads;
+	size_t						_nextShard;
+	pthread_mutex_t				_handoffMutex;  // guards the fields below
+	std::vector<Handoff>		_handoff;
+	size_t						_connectionCount;
+	bool						_running;
+	bool						_drainRequested;  // set by the acceptor
+	bool						_draining;  // no listeners, no keep-alive
+	int							_wakeFds[2];
 	Logger				_logger;
 	
 	/**
-	 * Initialize listening sockets based on configuration
+	 * Initialize one listening socket per configured address
 	 */
 	void			initializeSockets(void);
 	
 	/**
-	 * Accept new client connections
+	 * Return the listening socket owning fd, or NULL for client sockets
+	 */
+	Socket*			findListenSocket(int fd);
+	
+	/**
+	 * Accept new client connections on a ready listening socket, up to
+	 * the configured accept_batch
+	 */
+	void			acceptConnections(Socket& listenSocket);
+	
+	/**
+	 * Take a connection the event backend accepted on a listening socket;
+	 * clientFd is the accept's result, a negative errno on error
+	 */
+	void			acceptCompleted(Socket& listenSocket, int clientFd);
+	
+	/**
+	 * Register an accepted descriptor in this server's event loop
+	 */
+	void			addConnection(int clientFd, const struct sockaddr_in& addr,
+						const VirtualHostTable* vhosts);
+	
+	/**
+	 * Create the worker threads and their shard servers
+	 */
+	void			startShards(int count);
+	
+	/**
+	 * Prepare a server that only runs an event loop for handed-off clients
+	 */
+	void			startShard(void);
+	
+	/**
+	 * Start watching for file changes if this loop caches responses
+	 */
+	void			startResponseCache(void);
+	
+	/**
+	 * Pick the shard that receives the next connection
+	 */
+	Server*			pickShard(void);
+	
+	/**
+	 * Hand an accepted connection to this shard (called by the acceptor)
+	 */
+	void			adoptConnection(int clientFd, const struct sockaddr_in& addr,
+						const VirtualHostTable* vhosts);
+	
+	/**
+	 * Register the connections queued by the acceptor
+	 */
+	void			drainHandoff(void);
+	
+	/**
+	 * Get the number of open connections (used for least_conn balancing)
+	 */
+	size_t			getConnectionCount(void);
+	
+	/**
+	 * Check whether a shard should keep running its loop
 	 */
-	void			acceptConnections(fd_set *readFdsReady);
+	bool			isRunning(void);
 	
 	/**
-	 * Handle client requests
+	 * Wake a shard up through its pipe; called from the acceptor thread
 	 */
-	void			handleRequests(fd_set *readFdsReady);
+	void			wake(void);
 	
 	/**
-	 * Send responses to clients
+	 * Ask a shard to leave its loop and wake it up
 	 */
-	void			sendResponses(fd_set *writeFdsReady);
+	void			requestStop(void);
+	
+	/**
+	 * Ask a shard to finish its connections without keeping them alive
+	 */
+	void			requestDrain(void);
+	
+	/**
+	 * Close the connections waiting for a request and send GOAWAY on the
+	 * HTTP/2 ones, once the server drains
+	 */
+	void			closeIdleConnections(void);
+	
+	/**
+	 * Thread entry point running a shard event loop
+	 */
+	static void*	threadMain(void* arg);
+	
+	/**
+	 * Get the open connection behind fd, or NULL
+	 */
+	Connection*		findConnection(int fd) const;
+	
+	/**
+	 * Handle a client request on a readable socket, or on the data the
+	 * event backend received for it
+	 */
+	void			handleRequest(int clientFd, const PollEvent& event);
+	
+	/**
+	 * Answer every complete request received so far, in order, and
+	 * switch the connection to writing
+	 */
+	void			queueResponses(Connection* conn);
+	
+	/**
+	 * Send the queued responses on a writable socket
+	 */
+	void			sendResponse(int clientFd);
+	
+	/**
+	 * Hand the connection to an HTTP/2 session if its request opened
+	 * with the h2c preface or asked to upgrade, false otherwise
+	 */
+	bool			startHttp2(Connection* conn);
+	
+	/**
+	 * Read and write frames on an HTTP/2 connection
+	 */
+	void			serveHttp2(Connection* conn, const PollEvent& event);
+	
+	/**
+	 * Pick the events and timer an HTTP/2 connection waits on next
+	 */
+	void			updateHttp2(Connection* conn);
+	
+	/**
+	 * React to an expired connection timer
+	 */
+	void			handleTimeout(const TimerEvent& timer);
+	
+	/**
+	 * Close a client connection and drop its state
+	 */
+	void			closeConnection(int clientFd);
 	
 		/**
 	 * Copy constructor - private to prevent copying
@@ -82,9 +257,10 @@ public:
 	Server(void);
 	
 	/**
-	 * Constructor with configuration
+	 * Constructor with configuration; a server supervised by the master
+	 * shares its listeners with the other workers and generations
 	 */
-	Server(const Config& config);
+	Server(const Config& config, bool supervised = false);
 	
 	/**
 	 * Destructor
@@ -101,6 +277,17 @@ public:
 	 */
 	void			run(void);
 	
+	/**
+	 * Stop accepting and let the open connections finish their current
+	 * requests, for a graceful reload
+	 */
+	void			drain(void);
+	
+	/**
+	 * Check whether a draining server has no connection left
+	 */
+	bool			isIdle(void);
+	
 	/**
 	 * Stop the server
 	 */
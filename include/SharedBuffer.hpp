@@ -0,0 +1,89 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SharedBuffer.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/24 14:12:08 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/24 14:12:08 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef SHARED_BUFFER_HPP
+# define SHARED_BUFFER_HPP
+
+# include <string>
+
+/**
+ * @class SharedBuffer
+ * @brief Shared ownership of immutable bytes
+ * 
+ * A cached response is handed to every connection that asks for it
+ * while it may be evicted at any time. Copies share the bytes, freed
+ * when the last copy goes. The count is not atomic: a buffer stays on
+ * the thread that made it.
+ */
+class SharedBuffer
+{
+private:
+	/**
+	 * @struct Shared
+	 * @brief The bytes and how many buffers use them
+	 */
+	struct Shared
+	{
+		std::string	data;
+		size_t		references;
+	};
+	
+	Shared*			_shared;  // NULL when empty
+	
+	/**
+	 * Drop this buffer's reference, freeing the bytes on the last
+	 */
+	void			release(void);
+
+public:
+	/**
+	 * Default constructor, the buffer starts empty
+	 */
+	SharedBuffer(void);
+	
+	/**
+	 * Take a copy of the bytes to share
+	 */
+	explicit SharedBuffer(const std::string& data);
+	
+	/**
+	 * Copy constructor, shares the bytes
+	 */
+	SharedBuffer(const SharedBuffer& other);
+	
+	/**
+	 * Destructor
+	 */
+	~SharedBuffer(void);
+	
+	/**
+	 * Assignment operator, shares the bytes
+	 */
+	SharedBuffer&	operator=(const SharedBuffer& other);
+	
+	/**
+	 * Get the bytes, NULL when empty
+	 */
+	const char*		data(void) const;
+	
+	/**
+	 * Get the number of bytes
+	 */
+	size_t			size(void) const;
+	
+	/**
+	 * Let go of the bytes; other copies keep them
+	 */
+	void			reset(void);
+};
+
+#endif
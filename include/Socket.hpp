@@ -24,7 +24,8 @@
  * @brief Wrapper for socket operations with safe copying semantics
  * 
  * This class encapsulates socket functionality using reference counting
- * to safely manage the underlying file descriptor when copied.
+ * to safely manage the underlying file descriptor when copied. It is used
+ * for listening sockets; accepted connections are held by ClientSocket.
  */
 class Socket
 {
@@ -58,11 +59,6 @@ private:
 		 */
 		SocketImpl(const std::string& host, int port);
 		
-		/**
-		 * Constructor with existing socket file descriptor
-		 */
-		SocketImpl(int fd, const struct sockaddr_in& addr);
-		
 		/**
 		 * Destructor
 		 */
@@ -103,6 +99,11 @@ private:
 		 */
 		void				setNonBlocking(void);
 		
+		/**
+		 * Allow several sockets to bind the same address (SO_REUSEPORT)
+		 */
+		void				setReusePort(void);
+		
 		/**
 		 * Send data on the socket
 		 */
@@ -147,11 +148,6 @@ public:
 	 */
 	Socket(const std::string& host, int port);
 	
-	/**
-	 * Constructor with existing socket file descriptor
-	 */
-	Socket(int fd, const struct sockaddr_in& addr);
-	
 	/**
 	 * Copy constructor - implements reference counting
 	 */
@@ -175,18 +171,25 @@ public:
 	/**
 	 * Set the socket to listen for connections
 	 */
-	void				listen(int backlog = 10);
+	void				listen(int backlog = 511);
 	
 	/**
-	 * Accept a new connection
+	 * Accept a new connection as a bare descriptor, -1 if none is waiting.
+	 * The descriptor is already non-blocking and close-on-exec, and is
+	 * meant to be owned by a ClientSocket.
 	 */
-	Socket				accept(void);
+	int					accept(struct sockaddr_in& clientAddr);
 	
 	/**
 	 * Set the socket to non-blocking mode
 	 */
 	void				setNonBlocking(void);
 	
+	/**
+	 * Allow several sockets to bind the same address (SO_REUSEPORT)
+	 */
+	void				setReusePort(void);
+	
 	/**
 	 * Send data on the socket
 	 */
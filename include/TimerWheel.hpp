@@ -0,0 +1,141 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TimerWheel.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/03 10:14:27 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/03 10:14:27 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef TIMER_WHEEL_HPP
+# define TIMER_WHEEL_HPP
+
+# include <vector>
+# include <cstddef>
+
+/**
+ * @struct TimerEvent
+ * @brief A timer that fired: the id it was scheduled for and its kind
+ */
+struct TimerEvent
+{
+	int		id;
+	int		kind;
+};
+
+/**
+ * @class TimerWheel
+ * @brief Hierarchical timing wheel keyed by small integer ids
+ * 
+ * Timers live in LEVELS wheels of SLOTS buckets; level n covers
+ * SLOTS^(n+1) ticks, so scheduling, cancelling and expiring a timer are
+ * O(1) whatever the number of connections. Far timers are cascaded to a
+ * finer level when the wheel below wraps around. Each id (a client fd)
+ * holds at most one timer, scheduling it again replaces the old one.
+ */
+class TimerWheel
+{
+private:
+	enum
+	{
+		LEVELS = 4,
+		SLOT_BITS = 6,
+		SLOTS = 1 << SLOT_BITS,
+		SLOT_MASK = SLOTS - 1
+	};
+	
+	/**
+	 * Per-id timer, linked by id into the bucket it is stored in
+	 */
+	struct Node
+	{
+		unsigned long	expires;  // absolute tick
+		int				kind;
+		int				bucket;   // -1 when not scheduled
+		int				prev;
+		int				next;
+	};
+	
+	std::vector<Node>	_nodes;
+	int					_buckets[LEVELS * SLOTS];
+	unsigned long		_current;  // next tick to be processed
+	unsigned long		_tickMs;
+	size_t				_count;
+	
+	/**
+	 * Put a node in the bucket matching its expiry
+	 */
+	void					link(int id);
+	
+	/**
+	 * Take a node out of its bucket
+	 */
+	void					unlink(int id);
+	
+	/**
+	 * Move the timers of one coarse bucket down to finer levels
+	 */
+	void					cascade(int level, int slot);
+
+public:
+	/**
+	 * Get the monotonic clock in milliseconds
+	 */
+	static unsigned long	nowMs(void);
+	
+	/**
+	 * Constructor with the tick resolution in milliseconds
+	 */
+	TimerWheel(unsigned long tickMs = 100);
+	
+	/**
+	 * Copy constructor
+	 */
+	TimerWheel(const TimerWheel& other);
+	
+	/**
+	 * Destructor
+	 */
+	~TimerWheel(void);
+	
+	/**
+	 * Assignment operator
+	 */
+	TimerWheel&				operator=(const TimerWheel& other);
+	
+	/**
+	 * Arm (or re-arm) the timer of id to fire after timeoutMs
+	 */
+	void					schedule(int id, int kind, unsigned long timeoutMs);
+	
+	/**
+	 * Disarm the timer of id, if any
+	 */
+	void					cancel(int id);
+	
+	/**
+	 * Get the kind of the timer armed for id, or -1 if there is none
+	 */
+	int						getKind(int id) const;
+	
+	/**
+	 * Get how long the event loop may block before the next tick that
+	 * needs processing, or -1 when no timer is armed
+	 */
+	int						nextTimeout(void) const;
+	
+	/**
+	 * Advance the wheel to the current time and collect fired timers
+	 */
+	void					expire(std::vector<TimerEvent>& fired);
+	
+	/**
+	 * Get the number of armed timers
+	 */
+	size_t					size(void) const;
+};
+
+#endif
@@ -0,0 +1,196 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   UringPoller.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/27 09:41:15 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/27 09:41:15 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef URING_POLLER_HPP
+# define URING_POLLER_HPP
+
+# if defined(__linux__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#   define WEBSERV_HAVE_IO_URING 1
+#  endif
+# endif
+
+# ifdef WEBSERV_HAVE_IO_URING
+
+#  include <linux/io_uring.h>
+#  include "EventPoller.hpp"
+
+/**
+ * @class UringPoller
+ * @brief io_uring backend driven by raw io_uring_setup/io_uring_enter
+ * 
+ * Every watched descriptor has one IORING_OP_POLL_ADD request in flight.
+ * Arming, re-arming and cancelling polls only writes SQEs into the shared
+ * ring; all of them are submitted by the same io_uring_enter() call that
+ * waits for completions, so a loop iteration costs a single syscall for
+ * readiness no matter how many interest changes the handlers made.
+ * One-shot polls are re-armed after each completion, which keeps the
+ * level-triggered semantics the rest of the server relies on.
+ * 
+ * When the kernel has provided buffer rings (Linux 5.19), listeners get a
+ * multishot IORING_OP_ACCEPT and client sockets an IORING_OP_RECV that
+ * picks a buffer from the ring as data arrives, so neither accept() nor
+ * recv() is a syscall of its own. A receive is only armed while the
+ * descriptor is watched for EVENT_READ; its buffer goes back to the ring
+ * on the next wait().
+ */
+class UringPoller : public EventPoller
+{
+private:
+	/**
+	 * @enum FdMode
+	 * @brief What the kernel does for a descriptor besides polling
+	 */
+	enum FdMode
+	{
+		MODE_POLL,     // readiness only
+		MODE_ACCEPT,   // multishot accept
+		MODE_RECEIVE   // receive into ring buffers, poll for writing
+	};
+	
+	/**
+	 * @struct FdState
+	 * @brief Interest and in-flight request bookkeeping for one descriptor
+	 */
+	struct FdState
+	{
+		int				events;
+		FdMode			mode;
+		unsigned int	generation;    // tags completions of the current poll
+		unsigned int	ioGeneration;  // same for the accept or receive
+		bool			registered;
+		bool			armed;         // a POLL_ADD is queued or in flight
+		bool			ioArmed;       // an ACCEPT or RECV is
+		
+		FdState(void) : events(0), mode(MODE_POLL), generation(0), 
+			ioGeneration(0), registered(false), armed(false), 
+			ioArmed(false) {}
+	};
+	
+	int						_ringFd;
+	void*					_sqRing;
+	size_t					_sqRingSize;
+	void*					_cqRing;
+	size_t					_cqRingSize;
+	struct io_uring_sqe*	_sqes;
+	size_t					_sqesSize;
+	unsigned int*			_sqHead;
+	unsigned int*			_sqTail;
+	unsigned int*			_sqMask;
+	unsigned int*			_sqArray;
+	unsigned int			_sqEntries;
+	unsigned int*			_cqHead;
+	unsigned int*			_cqTail;
+	unsigned int*			_cqMask;
+	struct io_uring_cqe*	_cqes;
+	unsigned int			_pending;    // SQEs written but not yet submitted
+	struct io_uring_buf_ring*	_bufRing;  // NULL without completions
+	size_t					_bufRingSize;
+	char*					_bufData;
+	size_t					_bufDataSize;
+	std::vector<FdState>	_fds;
+	std::vector<int>		_rearm;
+	std::vector<unsigned int>	_delivered;  // buffers handed out by wait()
+	
+	/**
+	 * Map the submission and completion rings, throws on failure
+	 */
+	void					mapRings(const struct io_uring_params& params);
+	
+	/**
+	 * Register the receive buffer ring; completions stay off if the
+	 * kernel refuses it
+	 */
+	void					setupBuffers(void);
+	
+	/**
+	 * Give a receive buffer back to the kernel
+	 */
+	void					recycleBuffer(unsigned int id);
+	
+	/**
+	 * Release the rings and the io_uring instance
+	 */
+	void					release(void);
+	
+	/**
+	 * Get a free SQE, flushing the queue to the kernel when it is full
+	 */
+	struct io_uring_sqe*	getSqe(void);
+	
+	/**
+	 * Queue a one-shot poll for fd with its current interest
+	 */
+	void					queuePoll(int fd);
+	
+	/**
+	 * Queue the cancellation of the poll currently in flight for fd
+	 */
+	void					queueCancel(int fd);
+	
+	/**
+	 * Queue the accept or receive of fd
+	 */
+	void					queueIo(int fd);
+	
+	/**
+	 * Queue the cancellation of the accept or receive in flight for fd
+	 */
+	void					queueIoCancel(int fd);
+	
+	/**
+	 * Queue whatever fd's interest needs and is not in flight yet
+	 */
+	void					arm(int fd);
+	
+	/**
+	 * Get the poll events fd's interest needs, 0 for none
+	 */
+	unsigned int			pollMask(const FdState& state) const;
+	
+	/**
+	 * Turn the completion of an accept or receive into an event
+	 */
+	void					reapIo(const struct io_uring_cqe& cqe, 
+								std::vector<PollEvent>& ready);
+	
+	/**
+	 * Submit pending SQEs and optionally wait for one completion
+	 */
+	int						enter(unsigned int minComplete, int timeoutMs);
+	
+	/**
+	 * Move the available completions into ready
+	 */
+	void					reap(std::vector<PollEvent>& ready);
+	
+	/**
+	 * Get the state slot for fd, growing the table when needed
+	 */
+	FdState&				getState(int fd);
+
+public:
+	UringPoller(void);
+	~UringPoller(void);
+	
+	void					add(int fd, int events);
+	bool					addAcceptor(int fd);
+	bool					addReceiver(int fd, int events);
+	void					modify(int fd, int events);
+	void					remove(int fd);
+	int						wait(std::vector<PollEvent>& ready, int timeoutMs);
+	const char*				getName(void) const;
+};
+
+# endif
+
+#endif
@@ -0,0 +1,74 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   VirtualHostTable.hpp                               :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/10 14:27:05 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/10 14:27:05 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef VIRTUAL_HOST_TABLE_HPP
+# define VIRTUAL_HOST_TABLE_HPP
+
+# include <string>
+# include <map>
+
+struct ServerConfig;
+
+/**
+ * @class VirtualHostTable
+ * @brief The server blocks reachable through one listening address
+ * 
+ * Built once per listener from the configuration: requests are routed
+ * by looking the Host header up among the server_names, and fall back to
+ * the first server block declared for the address (the default server).
+ */
+class VirtualHostTable
+{
+private:
+	const ServerConfig*							_defaultServer;
+	std::map<std::string, const ServerConfig*>	_names;  // lowercase
+
+public:
+	/**
+	 * Default constructor, the table starts empty
+	 */
+	VirtualHostTable(void);
+	
+	/**
+	 * Copy constructor
+	 */
+	VirtualHostTable(const VirtualHostTable& other);
+	
+	/**
+	 * Destructor
+	 */
+	~VirtualHostTable(void);
+	
+	/**
+	 * Assignment operator
+	 */
+	VirtualHostTable&	operator=(const VirtualHostTable& other);
+	
+	/**
+	 * Register a server block; the first one becomes the default and the
+	 * first block claiming a name keeps it
+	 */
+	void				add(const ServerConfig* server);
+	
+	/**
+	 * Get the default server of the listener
+	 */
+	const ServerConfig*	getDefault(void) const;
+	
+	/**
+	 * Find the server for a Host header value (port optional), falling
+	 * back to the default server
+	 */
+	const ServerConfig*	find(const std::string& host) const;
+};
+
+#endif
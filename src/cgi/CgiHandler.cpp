@@ -21,6 +21,7 @@
 #include <fcntl.h>
 #include <cstring>
 #include <cerrno>
+#include <csignal>
 
 /**
  * Default constructor
@@ -187,13 +188,17 @@ void	CgiHandler::setupEnvironment(const HttpRequest& request, const LocationConf
 	_pathInfo = path;
 	_queryString = (queryPos != std::string::npos) ? uri.substr(queryPos + 1) : "";
 	_requestMethod = request.getMethod();
-	_contentType = request.getHeader("Content-Type");
+	_contentType = request.getHeader(HEADER_CONTENT_TYPE);
 	_requestBody = request.getBody();
 	
 	std::ostringstream oss;
-	oss << _requestBody.length();
+	oss << _requestBody.size();
 	_contentLength = oss.str();
 	
+	// The peer address is kept in binary form until a script needs it
+	std::ostringstream remotePort;
+	remotePort << ntohs(request.getClientAddress().sin_port);
+	
 	// Set up standard CGI environment variables
 	_envVars["REQUEST_METHOD"] = _requestMethod;
 	_envVars["PATH_INFO"] = _pathInfo;
@@ -205,6 +210,8 @@ void	CgiHandler::setupEnvironment(const HttpRequest& request, const LocationConf
 	_envVars["SERVER_NAME"] = "webserv";
 	_envVars["SERVER_PORT"] = "8080";
 	_envVars["SERVER_PROTOCOL"] = "HTTP/1.1";
+	_envVars["REMOTE_ADDR"] = ClientSocket::formatAddress(request.getClientAddress());
+	_envVars["REMOTE_PORT"] = remotePort.str();
 	_envVars["GATEWAY_INTERFACE"] = "CGI/1.1";
 	_envVars["REDIRECT_STATUS"] = "200"; // Required by PHP-CGI for security
 	
@@ -264,12 +271,20 @@ std::string	CgiHandler::executeCgi(void)
 	{
 		// Child process - execute CGI script
 		
+		// An ignored SIGPIPE would survive exec into the script
+		signal(SIGPIPE, SIG_DFL);
+		
 		// Close unused pipe ends
 		close(inputPipe[1]);
 		close(outputPipe[0]);
 		
+		// A spooled body is read by the script straight from its file
+		int bodyFd = _requestBody.isSpooled() ? _requestBody.getFd() : inputPipe[0];
+		if (_requestBody.isSpooled())
+			lseek(bodyFd, 0, SEEK_SET);
+		
 		// Redirect stdin and stdout
-		if (dup2(inputPipe[0], STDIN_FILENO) == -1 ||
+		if (dup2(bodyFd, STDIN_FILENO) == -1 ||
 			dup2(outputPipe[1], STDOUT_FILENO) == -1)
 		{
 			std::cerr << "DEBUG: dup2 failed: " << strerror(errno) << std::endl;
@@ -331,10 +346,12 @@ std::string	CgiHandler::executeCgi(void)
 		close(inputPipe[0]);
 		close(outputPipe[1]);
 		
-		// Send request body to CGI if present
-		if (!_requestBody.empty())
+		// Send an in-memory request body to CGI if present, it is at most
+		// client_body_buffer_size bytes
+		if (!_requestBody.empty() && !_requestBody.isSpooled())
 		{
-			ssize_t bytesWritten = write(inputPipe[1], _requestBody.c_str(), _requestBody.length());
+			std::string body = _requestBody.substr(0, _requestBody.size());
+			ssize_t bytesWritten = write(inputPipe[1], body.c_str(), body.length());
 			if (bytesWritten == -1)
 			{
 				std::cerr << "DEBUG: Failed to write to CGI stdin: " << strerror(errno) << std::endl;
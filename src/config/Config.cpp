@@ -11,32 +11,52 @@
 /* ************************************************************************** */
 
 #include "Config.hpp"
+#include "EventPoller.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <unistd.h>
 
 /**
  * Default constructor
  */
-Config::Config(void) : _configPath("")
+Config::Config(void) : _configPath(""), 
+	_eventBackend(EventPoller::getDefaultBackend()), _workerProcesses(1),
+	_workerThreads(0), _threadBalance(BALANCE_ROUND_ROBIN), _acceptBatch(64),
+	_openFileCacheMax(0), _openFileCacheValid(60000), _openFileCacheErrors(true),
+	_responseCacheSize(0), _responseCacheEntry(65536)
 {
 }
 
 /**
  * Constructor reads and parses the configuration file
  */
-Config::Config(const std::string& configPath) : _configPath(configPath)
+Config::Config(const std::string& configPath) : _configPath(configPath),
+	_eventBackend(EventPoller::getDefaultBackend()), _workerProcesses(1),
+	_workerThreads(0), _threadBalance(BALANCE_ROUND_ROBIN), _acceptBatch(64),
+	_openFileCacheMax(0), _openFileCacheValid(60000), _openFileCacheErrors(true),
+	_responseCacheSize(0), _responseCacheEntry(65536)
 {
 	parseConfig();
 	validateConfig();
+	buildListeners();
 }
 
 /**
  * Copy constructor
  */
 Config::Config(const Config& other) : _configPath(other._configPath),
-	_servers(other._servers)
+	_servers(other._servers), _eventBackend(other._eventBackend),
+	_workerProcesses(other._workerProcesses),
+	_workerThreads(other._workerThreads), _threadBalance(other._threadBalance),
+	_acceptBatch(other._acceptBatch),
+	_openFileCacheMax(other._openFileCacheMax),
+	_openFileCacheValid(other._openFileCacheValid),
+	_openFileCacheErrors(other._openFileCacheErrors),
+	_responseCacheSize(other._responseCacheSize),
+	_responseCacheEntry(other._responseCacheEntry)
 {
+	buildListeners();
 }
 
 /**
@@ -55,6 +75,17 @@ Config&	Config::operator=(const Config& other)
 	{
 		_configPath = other._configPath;
 		_servers = other._servers;
+		_eventBackend = other._eventBackend;
+		_workerProcesses = other._workerProcesses;
+		_workerThreads = other._workerThreads;
+		_threadBalance = other._threadBalance;
+		_acceptBatch = other._acceptBatch;
+		_openFileCacheMax = other._openFileCacheMax;
+		_openFileCacheValid = other._openFileCacheValid;
+		_openFileCacheErrors = other._openFileCacheErrors;
+		_responseCacheSize = other._responseCacheSize;
+		_responseCacheEntry = other._responseCacheEntry;
+		buildListeners();
 	}
 	return *this;
 }
@@ -94,7 +125,7 @@ void	Config::parseConfig(void)
 	
 	file.close();
 	
-	// Parse all server blocks
+	// Parse all server blocks and the global events block
 	size_t index = 0;
 	while (index < lines.size())
 	{
@@ -104,6 +135,15 @@ void	Config::parseConfig(void)
 			ServerConfig server = parseServerBlock(lines, index);
 			_servers.push_back(server);
 		}
+		else if (lines[index].find("events {") == 0)
+		{
+			index++;
+			parseEventsBlock(lines, index);
+		}
+		else if (parseGlobalDirective(tokenizeLine(lines[index])))
+		{
+			index++;
+		}
 		else
 		{
 			throw std::runtime_error("Expected 'server {' at line " 
@@ -149,6 +189,16 @@ ServerConfig	Config::parseServerBlock(std::vector<std::string>& lines,
 				server.host = "0.0.0.0";
 				std::istringstream(hostPort) >> server.port;
 			}
+			
+			for (size_t i = 2; i < tokens.size(); i++)
+			{
+				if (tokens[i].compare(0, 8, "backlog=") != 0)
+					continue;
+				std::istringstream iss(tokens[i].substr(8));
+				if (!(iss >> server.listenBacklog) || server.listenBacklog < 1)
+					throw std::runtime_error("Invalid listen backlog: " 
+						+ tokens[i]);
+			}
 		}
 		else if (tokens[0] == "server_name" && tokens.size() >= 2)
 		{
@@ -165,21 +215,19 @@ ServerConfig	Config::parseServerBlock(std::vector<std::string>& lines,
 			}
 		}
 		else if (tokens[0] == "client_max_body_size" && tokens.size() >= 2)
-		{
-			std::string size = tokens[1];
-			unsigned long value;
-			std::istringstream(size) >> value;
-			
-			char unit = size[size.length() - 1];
-			if (unit == 'K')
-				value *= 1024;
-			else if (unit == 'M')
-				value *= 1024 * 1024;
-			else if (unit == 'G')
-				value *= 1024 * 1024 * 1024;
-				
-			server.clientMaxBodySize = value;
-		}
+			server.clientMaxBodySize = parseSize(tokens[1]);
+		else if (tokens[0] == "client_body_buffer_size" && tokens.size() >= 2)
+			server.clientBodyBufferSize = parseSize(tokens[1]);
+		else if (tokens[0] == "client_body_temp_path" && tokens.size() >= 2)
+			server.clientBodyTempPath = tokens[1];
+		else if (tokens[0] == "client_header_timeout" && tokens.size() >= 2)
+			server.clientHeaderTimeout = parseTime(tokens[1]);
+		else if (tokens[0] == "client_body_timeout" && tokens.size() >= 2)
+			server.clientBodyTimeout = parseTime(tokens[1]);
+		else if (tokens[0] == "keepalive_timeout" && tokens.size() >= 2)
+			server.keepaliveTimeout = parseTime(tokens[1]);
+		else if (tokens[0] == "send_timeout" && tokens.size() >= 2)
+			server.sendTimeout = parseTime(tokens[1]);
 		else if (tokens[0] == "location" && tokens.size() >= 3 
 			&& tokens[2] == "{")
 		{
@@ -193,6 +241,14 @@ ServerConfig	Config::parseServerBlock(std::vector<std::string>& lines,
 		index++;
 	}
 	
+	// Locations without their own body limit take the server's, wherever
+	// the server directive appears in the block
+	for (size_t i = 0; i < server.locations.size(); i++)
+	{
+		if (!server.locations[i].hasClientMaxBodySize)
+			server.locations[i].clientMaxBodySize = server.clientMaxBodySize;
+	}
+	
 	// Move past the closing brace
 	if (index < lines.size())
 		index++;
@@ -200,6 +256,150 @@ ServerConfig	Config::parseServerBlock(std::vector<std::string>& lines,
 	return server;
 }
 
+/**
+ * Parse a top-level directive, returns false if it is unknown
+ */
+bool	Config::parseGlobalDirective(const std::vector<std::string>& tokens)
+{
+	if (tokens.size() < 2)
+		return false;
+		
+	if (tokens[0] == "worker_processes")
+	{
+		if (tokens[1] == "auto")
+		{
+			long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+			_workerProcesses = (cpus > 0) ? static_cast<int>(cpus) : 1;
+		}
+		else
+		{
+			std::istringstream iss(tokens[1]);
+			if (!(iss >> _workerProcesses) || _workerProcesses < 1)
+				throw std::runtime_error("Invalid worker_processes value: " 
+					+ tokens[1]);
+		}
+		return true;
+	}
+	if (tokens[0] == "worker_threads")
+	{
+		std::istringstream iss(tokens[1]);
+		if (!(iss >> _workerThreads) || _workerThreads < 0)
+			throw std::runtime_error("Invalid worker_threads value: " 
+				+ tokens[1]);
+		if (tokens.size() >= 3 && tokens[2] == "least_conn")
+			_threadBalance = BALANCE_LEAST_CONN;
+		else if (tokens.size() >= 3 && tokens[2] != "round_robin")
+			throw std::runtime_error("Invalid worker_threads balance: " 
+				+ tokens[2]);
+		return true;
+	}
+	if (tokens[0] == "open_file_cache")
+	{
+		parseOpenFileCache(tokens);
+		return true;
+	}
+	if (tokens[0] == "open_file_cache_errors")
+	{
+		if (tokens[1] != "on" && tokens[1] != "off")
+			throw std::runtime_error("Invalid open_file_cache_errors value: " 
+				+ tokens[1]);
+		_openFileCacheErrors = (tokens[1] == "on");
+		return true;
+	}
+	if (tokens[0] == "response_cache")
+	{
+		parseResponseCache(tokens);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Parse the open_file_cache directive (off, or max=N [valid=TIME])
+ */
+void	Config::parseOpenFileCache(const std::vector<std::string>& tokens)
+{
+	if (tokens[1] == "off")
+	{
+		_openFileCacheMax = 0;
+		return;
+	}
+	_openFileCacheMax = 0;
+	for (size_t i = 1; i < tokens.size(); ++i)
+	{
+		if (tokens[i].compare(0, 4, "max=") == 0)
+		{
+			std::istringstream iss(tokens[i].substr(4));
+			if (!(iss >> _openFileCacheMax) || _openFileCacheMax == 0)
+				throw std::runtime_error("Invalid open_file_cache max: " 
+					+ tokens[i]);
+		}
+		else if (tokens[i].compare(0, 6, "valid=") == 0)
+			_openFileCacheValid = parseTime(tokens[i].substr(6));
+		else
+			throw std::runtime_error("Invalid open_file_cache parameter: " 
+				+ tokens[i]);
+	}
+	if (_openFileCacheMax == 0)
+		throw std::runtime_error("open_file_cache needs max=N or off");
+}
+
+/**
+ * Parse the response_cache directive (off, or max_size=SIZE
+ * [max_entry=SIZE])
+ */
+void	Config::parseResponseCache(const std::vector<std::string>& tokens)
+{
+	_responseCacheSize = 0;
+	if (tokens[1] == "off")
+		return;
+	for (size_t i = 1; i < tokens.size(); ++i)
+	{
+		if (tokens[i].compare(0, 9, "max_size=") == 0)
+			_responseCacheSize = parseSize(tokens[i].substr(9));
+		else if (tokens[i].compare(0, 10, "max_entry=") == 0)
+			_responseCacheEntry = parseSize(tokens[i].substr(10));
+		else
+			throw std::runtime_error("Invalid response_cache parameter: " 
+				+ tokens[i]);
+	}
+	if (_responseCacheSize == 0)
+		throw std::runtime_error("response_cache needs max_size=SIZE or off");
+}
+
+/**
+ * Parse the top-level events block from the configuration
+ */
+void	Config::parseEventsBlock(std::vector<std::string>& lines, size_t& index)
+{
+	while (index < lines.size() && lines[index] != "}")
+	{
+		std::vector<std::string> tokens = tokenizeLine(lines[index]);
+		
+		if (!tokens.empty() && tokens[0] == "use" && tokens.size() >= 2)
+		{
+			if (!EventPoller::isSupported(tokens[1]))
+				throw std::runtime_error("Unsupported event backend: " 
+					+ tokens[1]);
+			_eventBackend = tokens[1];
+		}
+		else if (!tokens.empty() && tokens[0] == "accept_batch" 
+			&& tokens.size() >= 2)
+		{
+			std::istringstream iss(tokens[1]);
+			if (!(iss >> _acceptBatch) || _acceptBatch < 1)
+				throw std::runtime_error("Invalid accept_batch value: " 
+					+ tokens[1]);
+		}
+		
+		index++;
+	}
+	
+	// Move past the closing brace
+	if (index < lines.size())
+		index++;
+}
+
 /**
  * Parse a location block from the configuration
  */
@@ -225,7 +425,15 @@ LocationConfig	Config::parseLocationBlock(std::vector<std::string>& lines,
 		else if (tokens[0] == "method" && tokens.size() >= 2)
 		{
 			for (size_t i = 1; i < tokens.size(); i++)
-				location.allowedMethods.insert(tokens[i]);
+			{
+				HttpMethod method = MethodTable::lookup(tokens[i].c_str(), 
+					tokens[i].size());
+				
+				if (method == METHOD_UNKNOWN)
+					throw std::runtime_error("Unknown method in location " 
+						+ location.path + ": " + tokens[i]);
+				location.allowedMethods |= MethodTable::getBit(method);
+			}
 		}
 		else if (tokens[0] == "autoindex" && tokens.size() >= 2)
 			location.autoindex = (tokens[1] == "on");
@@ -240,6 +448,11 @@ LocationConfig	Config::parseLocationBlock(std::vector<std::string>& lines,
 			for (size_t i = 1; i < tokens.size(); i++)
 				location.cgiExtensions.insert(tokens[i]);
 		}
+		else if (tokens[0] == "client_max_body_size" && tokens.size() >= 2)
+		{
+			location.clientMaxBodySize = parseSize(tokens[1]);
+			location.hasClientMaxBodySize = true;
+		}
 		
 		index++;
 	}
@@ -286,6 +499,50 @@ void	Config::validateConfig(void)
 	}
 }
 
+/**
+ * Group the server blocks by listening address; must run again
+ * whenever _servers is copied since the tables point into it
+ */
+void	Config::buildListeners(void)
+{
+	_listeners.clear();
+	
+	// Wildcard listeners first: a specific address on a port that also
+	// listens on 0.0.0.0 cannot be bound separately, so it joins that table
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (size_t i = 0; i < _servers.size(); i++)
+		{
+			const ServerConfig& server = _servers[i];
+			bool wildcard = (server.host == "0.0.0.0");
+			
+			if (wildcard != (pass == 0))
+				continue;
+				
+			ListenConfig* listener = NULL;
+			for (size_t j = 0; j < _listeners.size() && !listener; j++)
+			{
+				if (_listeners[j].port == server.port 
+					&& (_listeners[j].host == server.host 
+						|| _listeners[j].host == "0.0.0.0"))
+					listener = &_listeners[j];
+			}
+			
+			if (!listener)
+			{
+				_listeners.push_back(ListenConfig());
+				listener = &_listeners.back();
+				listener->host = server.host;
+				listener->port = server.port;
+				listener->backlog = server.listenBacklog;
+			}
+			else if (server.listenBacklog > listener->backlog)
+				listener->backlog = server.listenBacklog;
+			listener->vhosts.add(&server);
+		}
+	}
+}
+
 /**
  * Tokenize a configuration line
  */
@@ -307,6 +564,55 @@ std::vector<std::string>	Config::tokenizeLine(const std::string& line)
 	return tokens;
 }
 
+/**
+ * Parse a time value (30s, 500ms, 2m, 1h; bare numbers are seconds)
+ * into milliseconds
+ */
+unsigned long	Config::parseTime(const std::string& value)
+{
+	std::istringstream iss(value);
+	unsigned long amount;
+	std::string unit;
+	
+	if (!(iss >> amount))
+		throw std::runtime_error("Invalid time value: " + value);
+	iss >> unit;
+	
+	if (unit.empty() || unit == "s")
+		return amount * 1000;
+	if (unit == "ms")
+		return amount;
+	if (unit == "m")
+		return amount * 60 * 1000;
+	if (unit == "h")
+		return amount * 60 * 60 * 1000;
+	throw std::runtime_error("Invalid time unit: " + value);
+}
+
+/**
+ * Parse a size value (512, 16k, 10M, 1G) into bytes
+ */
+unsigned long	Config::parseSize(const std::string& value)
+{
+	std::istringstream iss(value);
+	unsigned long amount;
+	std::string unit;
+	
+	if (!(iss >> amount))
+		throw std::runtime_error("Invalid size value: " + value);
+	iss >> unit;
+	
+	if (unit.empty())
+		return amount;
+	if (unit == "k" || unit == "K")
+		return amount * 1024;
+	if (unit == "m" || unit == "M")
+		return amount * 1024 * 1024;
+	if (unit == "g" || unit == "G")
+		return amount * 1024 * 1024 * 1024;
+	throw std::runtime_error("Invalid size unit: " + value);
+}
+
 /**
  * Get all configured servers
  */
@@ -316,96 +622,91 @@ const std::vector<ServerConfig>&	Config::getServers(void) const
 }
 
 /**
- * Find server configuration by host, port and server name
+ * Get the event notification backend (select, poll, epoll, io_uring)
  */
-const ServerConfig* Config::findServer(const std::string& host, int port, 
-	const std::string& serverName) const
+const std::string&	Config::getEventBackend(void) const
 {
-	_logger.tempOss << "Finding server for host='" << host 
-	<< "', port=" << port << ", name='" << serverName << "'";
-	_logger.debug();
-
-	const ServerConfig* defaultServer = NULL;
-
-	// Log all available servers for debugging
-	_logger.tempOss << "Total servers in config: " << _servers.size();
-
-	for (size_t i = 0; i < _servers.size(); i++)
-	{
-	const ServerConfig& server = _servers[i];
+	return _eventBackend;
+}
 
-	_logger.tempOss << "Checking server #" << i << ": host='" << server.host 
-	<< "', port=" << server.port;
-	_logger.debug();
+/**
+ * Get the number of worker processes (1 means no master process)
+ */
+int	Config::getWorkerProcesses(void) const
+{
+	return _workerProcesses;
+}
 
-	if (!server.serverNames.empty()) {
-	_logger.tempOss << ", names=[";
-	for (size_t j = 0; j < server.serverNames.size(); j++) {
-	if (j > 0) _logger.tempOss << ", ";
-	_logger.tempOss << "'" << server.serverNames[j] << "'";
-	}
-	_logger.tempOss << "]";
-	}
-	_logger.info();
+/**
+ * Get the number of event-loop threads (0 means a single loop)
+ */
+int	Config::getWorkerThreads(void) const
+{
+	return _workerThreads;
+}
 
-	// Check for matching host & port
-	bool hostMatches = (server.host == host || server.host == "0.0.0.0");
-	bool portMatches = (server.port == port);
+/**
+ * Get the policy used to hand connections to the worker threads
+ */
+ThreadBalance	Config::getThreadBalance(void) const
+{
+	return _threadBalance;
+}
 
-	if (hostMatches && portMatches)
-	{
-		_logger.tempOss << "Found matching host/port";
-		_logger.debug();
+/**
+ * Get the most connections accepted per listener readiness event
+ */
+int	Config::getAcceptBatch(void) const
+{
+	return _acceptBatch;
+}
 
-	// Check if server name matches
-	if (server.serverNames.empty())
-	{
-		_logger.tempOss << "Server has no server_names, using as default";
-		_logger.debug();
-	if (!defaultServer)
-	defaultServer = &server;
-	}
-	else
-	{
-	for (size_t j = 0; j < server.serverNames.size(); j++)
-	{
-		_logger.tempOss << "Comparing server_name '" 
-		<< server.serverNames[j] << "' with '" 
-		<< serverName << "'";
-		_logger.debug();
+/**
+ * Get the most entries of each thread's open file cache, 0 when off
+ */
+size_t	Config::getOpenFileCacheMax(void) const
+{
+	return _openFileCacheMax;
+}
 
-	if (server.serverNames[j] == serverName)
-	{
-		_logger.tempOss << "Server name matches!";
-		_logger.debug();
-		return &server;
-	}
-	}
+/**
+ * Get how long an open file cache entry is trusted, in milliseconds
+ */
+unsigned long	Config::getOpenFileCacheValid(void) const
+{
+	return _openFileCacheValid;
+}
 
-	// No matching server name, but host/port match, so potential default
-	if (!defaultServer)
-	{
-		_logger.tempOss << "No matching server_name, " 
-		<< "but using as potential default";
-		_logger.debug();
-	defaultServer = &server;
-	}
-	}
-	}
-	}
+/**
+ * Check whether failed lookups are kept in the open file cache
+ */
+bool	Config::getOpenFileCacheErrors(void) const
+{
+	return _openFileCacheErrors;
+}
 
-	if (defaultServer){
-		_logger.tempOss << "Returning default server for this host/port";
-		_logger.debug();
-	}
+/**
+ * Get the bytes each thread's response cache may hold, 0 when off
+ */
+size_t	Config::getResponseCacheSize(void) const
+{
+	return _responseCacheSize;
+}
 
-	else{
-		_logger.tempOss << "No matching server found!";
-		_logger.debug();
-	}
-	
+/**
+ * Get the largest body the response cache keeps
+ */
+size_t	Config::getResponseCacheEntry(void) const
+{
+	return _responseCacheEntry;
+}
 
-	return defaultServer;
+/**
+ * Get the listening addresses, each with its virtual host table
+ */
+const std::vector<ListenConfig>&	Config::getListeners(void) const
+{
+	return _listeners;
 }
 
 /**
@@ -413,6 +714,8 @@ const ServerConfig* Config::findServer(const std::string& host, int port,
  */
 std::string Config::getDefaultErrorPage(int statusCode) const
 {
+    Logger logger;
+    
     // percorre todos os servidores
     for (size_t i = 0; i < _servers.size(); ++i)
     {
@@ -451,9 +754,9 @@ std::string Config::getDefaultErrorPage(int statusCode) const
             ss << file.rdbuf();
             return ss.str();
         }
-        _logger.tempOss << "could not open error page'"
+        logger.tempOss << "could not open error page'"
                   << fullPath  << ")\n";
-									_logger.warning();
+									logger.warning();
         
     }
     // se falhar, continua para a error page embutida
@@ -0,0 +1,98 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   VirtualHostTable.cpp                               :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/10 14:27:05 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/10 14:27:05 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "VirtualHostTable.hpp"
+#include "Config.hpp"
+#include <cctype>
+
+/**
+ * Default constructor, the table starts empty
+ */
+VirtualHostTable::VirtualHostTable(void) : _defaultServer(NULL)
+{
+}
+
+/**
+ * Copy constructor
+ */
+VirtualHostTable::VirtualHostTable(const VirtualHostTable& other) :
+	_defaultServer(other._defaultServer), _names(other._names)
+{
+}
+
+/**
+ * Destructor
+ */
+VirtualHostTable::~VirtualHostTable(void)
+{
+}
+
+/**
+ * Assignment operator
+ */
+VirtualHostTable&	VirtualHostTable::operator=(const VirtualHostTable& other)
+{
+	if (this != &other)
+	{
+		_defaultServer = other._defaultServer;
+		_names = other._names;
+	}
+	return *this;
+}
+
+/**
+ * Register a server block; the first one becomes the default and the
+ * first block claiming a name keeps it
+ */
+void	VirtualHostTable::add(const ServerConfig* server)
+{
+	if (!_defaultServer)
+		_defaultServer = server;
+		
+	for (size_t i = 0; i < server->serverNames.size(); i++)
+	{
+		std::string name = server->serverNames[i];
+		
+		for (size_t j = 0; j < name.length(); j++)
+			name[j] = std::tolower(static_cast<unsigned char>(name[j]));
+		_names.insert(std::make_pair(name, server));
+	}
+}
+
+/**
+ * Get the default server of the listener
+ */
+const ServerConfig*	VirtualHostTable::getDefault(void) const
+{
+	return _defaultServer;
+}
+
+/**
+ * Find the server for a Host header value (port optional), falling
+ * back to the default server
+ */
+const ServerConfig*	VirtualHostTable::find(const std::string& host) const
+{
+	if (_names.empty() || host.empty())
+		return _defaultServer;
+		
+	// Host names are case-insensitive and may carry the port
+	std::string name = host.substr(0, host.find(':'));
+	for (size_t i = 0; i < name.length(); i++)
+		name[i] = std::tolower(static_cast<unsigned char>(name[i]));
+		
+	std::map<std::string, const ServerConfig*>::const_iterator it = 
+		_names.find(name);
+	if (it == _names.end())
+		return _defaultServer;
+	return it->second;
+}
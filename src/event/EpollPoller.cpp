@@ -0,0 +1,131 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EpollPoller.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 12:14:50 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 12:14:50 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "EpollPoller.hpp"
+
+#ifdef __linux__
+
+# include <unistd.h>
+# include <fcntl.h>
+# include <cerrno>
+# include <cstring>
+# include <stdexcept>
+
+/**
+ * Maximum number of events collected by a single epoll_wait() call
+ */
+static const int	MAX_EVENTS = 1024;
+
+/**
+ * Constructor creates the epoll instance
+ */
+EpollPoller::EpollPoller(void) : _epollFd(-1), _events(MAX_EVENTS)
+{
+	_epollFd = epoll_create(MAX_EVENTS);
+	if (_epollFd < 0)
+		throw std::runtime_error("Failed to create epoll instance: " 
+			+ std::string(strerror(errno)));
+	fcntl(_epollFd, F_SETFD, FD_CLOEXEC);
+}
+
+/**
+ * Destructor closes the epoll instance
+ */
+EpollPoller::~EpollPoller(void)
+{
+	if (_epollFd >= 0)
+		close(_epollFd);
+}
+
+/**
+ * Issue an epoll_ctl() call, throws on failure
+ */
+void	EpollPoller::control(int op, int fd, int events)
+{
+	struct epoll_event ev;
+	
+	memset(&ev, 0, sizeof(ev));
+	if (events & EVENT_READ)
+		ev.events |= EPOLLIN;
+	if (events & EVENT_WRITE)
+		ev.events |= EPOLLOUT;
+	ev.data.fd = fd;
+	if (epoll_ctl(_epollFd, op, fd, &ev) < 0)
+		throw std::runtime_error("epoll_ctl failed: " 
+			+ std::string(strerror(errno)));
+}
+
+/**
+ * Start watching fd
+ */
+void	EpollPoller::add(int fd, int events)
+{
+	control(EPOLL_CTL_ADD, fd, events);
+}
+
+/**
+ * Change the conditions watched for fd
+ */
+void	EpollPoller::modify(int fd, int events)
+{
+	control(EPOLL_CTL_MOD, fd, events);
+}
+
+/**
+ * Stop watching fd
+ */
+void	EpollPoller::remove(int fd)
+{
+	struct epoll_event ev;
+	
+	// Pre-2.6.9 kernels require a non-NULL event even for EPOLL_CTL_DEL
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+/**
+ * Wait for readiness, only ready descriptors are returned by the kernel
+ */
+int	EpollPoller::wait(std::vector<PollEvent>& ready, int timeoutMs)
+{
+	ready.clear();
+	
+	int count = epoll_wait(_epollFd, &_events[0], MAX_EVENTS, timeoutMs);
+	if (count <= 0)
+		return count;
+		
+	for (int i = 0; i < count; i++)
+	{
+		unsigned int revents = _events[i].events;
+		PollEvent event;
+		
+		event.fd = _events[i].data.fd;
+		event.events = 0;
+		if (revents & EPOLLIN)
+			event.events |= EVENT_READ;
+		if (revents & EPOLLOUT)
+			event.events |= EVENT_WRITE;
+		if (revents & (EPOLLERR | EPOLLHUP))
+			event.events |= EVENT_ERROR;
+		ready.push_back(event);
+	}
+	return count;
+}
+
+/**
+ * Get the backend name
+ */
+const char*	EpollPoller::getName(void) const
+{
+	return "epoll";
+}
+
+#endif
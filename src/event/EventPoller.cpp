@@ -0,0 +1,133 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EventPoller.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 11:20:44 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 11:20:44 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "EventPoller.hpp"
+#include "SelectPoller.hpp"
+#include "PollPoller.hpp"
+#include "EpollPoller.hpp"
+#include "UringPoller.hpp"
+#include "Logger.hpp"
+#include <stdexcept>
+
+/**
+ * Default constructor
+ */
+EventPoller::EventPoller(void)
+{
+}
+
+/**
+ * Private copy constructor - pollers own kernel resources
+ */
+EventPoller::EventPoller(const EventPoller& other)
+{
+	(void)other;
+}
+
+/**
+ * Private assignment operator - pollers own kernel resources
+ */
+EventPoller&	EventPoller::operator=(const EventPoller& other)
+{
+	(void)other;
+	return *this;
+}
+
+/**
+ * Destructor
+ */
+EventPoller::~EventPoller(void)
+{
+}
+
+/**
+ * Readiness backends leave accepting to the server
+ */
+bool	EventPoller::addAcceptor(int fd)
+{
+	(void)fd;
+	return false;
+}
+
+/**
+ * Readiness backends leave receiving to the server
+ */
+bool	EventPoller::addReceiver(int fd, int events)
+{
+	(void)fd;
+	(void)events;
+	return false;
+}
+
+/**
+ * Check whether a backend name is known to this build
+ */
+bool	EventPoller::isSupported(const std::string& backend)
+{
+	if (backend == "select" || backend == "poll")
+		return true;
+#ifdef __linux__
+	if (backend == "epoll")
+		return true;
+#endif
+#ifdef WEBSERV_HAVE_IO_URING
+	if (backend == "io_uring")
+		return true;
+#endif
+	return false;
+}
+
+/**
+ * Create the backend with the given name, throws on unknown names
+ */
+EventPoller*	EventPoller::create(const std::string& backend)
+{
+	if (backend == "select")
+		return new SelectPoller();
+	if (backend == "poll")
+		return new PollPoller();
+#ifdef __linux__
+	if (backend == "epoll")
+		return new EpollPoller();
+#endif
+#ifdef WEBSERV_HAVE_IO_URING
+	if (backend == "io_uring")
+	{
+		// Kernels without io_uring (or with it disabled) get epoll instead
+		try
+		{
+			return new UringPoller();
+		}
+		catch (const std::exception& e)
+		{
+			Logger logger;
+			logger.tempOss << "io_uring unavailable (" << e.what() 
+				<< "), falling back to epoll";
+			logger.warning();
+			return new EpollPoller();
+		}
+	}
+#endif
+	throw std::runtime_error("Unsupported event backend: " + backend);
+}
+
+/**
+ * Get the backend used when the configuration does not choose one
+ */
+std::string	EventPoller::getDefaultBackend(void)
+{
+#ifdef __linux__
+	return "epoll";
+#else
+	return "poll";
+#endif
+}
@@ -0,0 +1,138 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PollPoller.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 11:57:29 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 11:57:29 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "PollPoller.hpp"
+#include <stdexcept>
+
+/**
+ * Constructor
+ */
+PollPoller::PollPoller(void)
+{
+}
+
+/**
+ * Destructor
+ */
+PollPoller::~PollPoller(void)
+{
+}
+
+/**
+ * Translate EventFlags into poll() event bits
+ */
+static short	toPollEvents(int events)
+{
+	short pollEvents = 0;
+	
+	if (events & EVENT_READ)
+		pollEvents |= POLLIN;
+	if (events & EVENT_WRITE)
+		pollEvents |= POLLOUT;
+	return pollEvents;
+}
+
+/**
+ * Start watching fd
+ */
+void	PollPoller::add(int fd, int events)
+{
+	if (fd < 0)
+		throw std::runtime_error("Invalid descriptor for poll()");
+	if (static_cast<size_t>(fd) >= _slots.size())
+		_slots.resize(fd + 1, -1);
+	if (_slots[fd] >= 0)
+	{
+		modify(fd, events);
+		return;
+	}
+	
+	struct pollfd entry;
+	entry.fd = fd;
+	entry.events = toPollEvents(events);
+	entry.revents = 0;
+	_slots[fd] = static_cast<int>(_pollFds.size());
+	_pollFds.push_back(entry);
+}
+
+/**
+ * Change the conditions watched for fd
+ */
+void	PollPoller::modify(int fd, int events)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _slots.size() || _slots[fd] < 0)
+		throw std::runtime_error("Descriptor not registered with poll()");
+	_pollFds[_slots[fd]].events = toPollEvents(events);
+}
+
+/**
+ * Stop watching fd, the last entry takes its place to keep the array dense
+ */
+void	PollPoller::remove(int fd)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _slots.size() || _slots[fd] < 0)
+		return;
+		
+	int index = _slots[fd];
+	int last = static_cast<int>(_pollFds.size()) - 1;
+	
+	if (index != last)
+	{
+		_pollFds[index] = _pollFds[last];
+		_slots[_pollFds[index].fd] = index;
+	}
+	_pollFds.pop_back();
+	_slots[fd] = -1;
+}
+
+/**
+ * Wait for readiness and collect the entries with pending revents
+ */
+int	PollPoller::wait(std::vector<PollEvent>& ready, int timeoutMs)
+{
+	ready.clear();
+	if (_pollFds.empty() && timeoutMs < 0)
+		return 0;
+		
+	int activity = poll(_pollFds.empty() ? NULL : &_pollFds[0], 
+		_pollFds.size(), timeoutMs);
+	if (activity <= 0)
+		return activity;
+		
+	for (size_t i = 0; i < _pollFds.size() 
+		&& static_cast<int>(ready.size()) < activity; i++)
+	{
+		short revents = _pollFds[i].revents;
+		if (!revents)
+			continue;
+			
+		PollEvent event;
+		event.fd = _pollFds[i].fd;
+		event.events = 0;
+		if (revents & POLLIN)
+			event.events |= EVENT_READ;
+		if (revents & POLLOUT)
+			event.events |= EVENT_WRITE;
+		if (revents & (POLLERR | POLLHUP | POLLNVAL))
+			event.events |= EVENT_ERROR;
+		ready.push_back(event);
+	}
+	return static_cast<int>(ready.size());
+}
+
+/**
+ * Get the backend name
+ */
+const char*	PollPoller::getName(void) const
+{
+	return "poll";
+}
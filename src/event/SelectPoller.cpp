@@ -0,0 +1,115 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SelectPoller.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/25 11:38:02 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/25 11:38:02 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "SelectPoller.hpp"
+#include <sys/time.h>
+#include <stdexcept>
+
+/**
+ * Constructor starts with empty descriptor sets
+ */
+SelectPoller::SelectPoller(void) : _maxFd(-1)
+{
+	FD_ZERO(&_readFds);
+	FD_ZERO(&_writeFds);
+}
+
+/**
+ * Destructor
+ */
+SelectPoller::~SelectPoller(void)
+{
+}
+
+/**
+ * Start watching fd, select() cannot represent descriptors past FD_SETSIZE
+ */
+void	SelectPoller::add(int fd, int events)
+{
+	if (fd < 0 || fd >= FD_SETSIZE)
+		throw std::runtime_error("Descriptor out of range for select()");
+	modify(fd, events);
+	if (fd > _maxFd)
+		_maxFd = fd;
+}
+
+/**
+ * Change the conditions watched for fd
+ */
+void	SelectPoller::modify(int fd, int events)
+{
+	FD_CLR(fd, &_readFds);
+	FD_CLR(fd, &_writeFds);
+	if (events & EVENT_READ)
+		FD_SET(fd, &_readFds);
+	if (events & EVENT_WRITE)
+		FD_SET(fd, &_writeFds);
+}
+
+/**
+ * Stop watching fd and shrink the scanned range if possible
+ */
+void	SelectPoller::remove(int fd)
+{
+	if (fd < 0 || fd >= FD_SETSIZE)
+		return;
+	FD_CLR(fd, &_readFds);
+	FD_CLR(fd, &_writeFds);
+	while (_maxFd >= 0 && !FD_ISSET(_maxFd, &_readFds) 
+		&& !FD_ISSET(_maxFd, &_writeFds))
+		_maxFd--;
+}
+
+/**
+ * Wait for readiness, the whole 0.._maxFd range is scanned afterwards
+ */
+int	SelectPoller::wait(std::vector<PollEvent>& ready, int timeoutMs)
+{
+	fd_set readFds = _readFds;
+	fd_set writeFds = _writeFds;
+	struct timeval timeout;
+	struct timeval* timeoutPtr = NULL;
+	
+	ready.clear();
+	if (timeoutMs >= 0)
+	{
+		timeout.tv_sec = timeoutMs / 1000;
+		timeout.tv_usec = (timeoutMs % 1000) * 1000;
+		timeoutPtr = &timeout;
+	}
+	
+	int activity = select(_maxFd + 1, &readFds, &writeFds, NULL, timeoutPtr);
+	if (activity <= 0)
+		return activity;
+		
+	for (int fd = 0; fd <= _maxFd; fd++)
+	{
+		PollEvent event;
+		event.fd = fd;
+		event.events = 0;
+		if (FD_ISSET(fd, &readFds))
+			event.events |= EVENT_READ;
+		if (FD_ISSET(fd, &writeFds))
+			event.events |= EVENT_WRITE;
+		if (event.events)
+			ready.push_back(event);
+	}
+	return static_cast<int>(ready.size());
+}
+
+/**
+ * Get the backend name
+ */
+const char*	SelectPoller::getName(void) const
+{
+	return "select";
+}
@@ -0,0 +1,279 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TimerWheel.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/03 10:14:27 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/03 10:14:27 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "TimerWheel.hpp"
+#include <ctime>
+
+/**
+ * Constructor with the tick resolution in milliseconds
+ */
+TimerWheel::TimerWheel(unsigned long tickMs) : _current(0),
+	_tickMs(tickMs ? tickMs : 1), _count(0)
+{
+	for (int i = 0; i < LEVELS * SLOTS; i++)
+		_buckets[i] = -1;
+	_current = nowMs() / _tickMs;
+}
+
+/**
+ * Copy constructor
+ */
+TimerWheel::TimerWheel(const TimerWheel& other) : _nodes(other._nodes),
+	_current(other._current), _tickMs(other._tickMs), _count(other._count)
+{
+	for (int i = 0; i < LEVELS * SLOTS; i++)
+		_buckets[i] = other._buckets[i];
+}
+
+/**
+ * Destructor
+ */
+TimerWheel::~TimerWheel(void)
+{
+}
+
+/**
+ * Assignment operator
+ */
+TimerWheel&	TimerWheel::operator=(const TimerWheel& other)
+{
+	if (this != &other)
+	{
+		_nodes = other._nodes;
+		_current = other._current;
+		_tickMs = other._tickMs;
+		_count = other._count;
+		for (int i = 0; i < LEVELS * SLOTS; i++)
+			_buckets[i] = other._buckets[i];
+	}
+	return *this;
+}
+
+/**
+ * Get the monotonic clock in milliseconds
+ */
+unsigned long	TimerWheel::nowMs(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long>(ts.tv_sec) * 1000 
+		+ static_cast<unsigned long>(ts.tv_nsec) / 1000000;
+}
+
+/**
+ * Put a node in the bucket matching its expiry
+ */
+void	TimerWheel::link(int id)
+{
+	Node& node = _nodes[id];
+	
+	// Overdue timers go to the bucket processed next
+	if (node.expires < _current)
+		node.expires = _current;
+		
+	unsigned long delta = node.expires - _current;
+	int level = 0;
+	
+	while (level < LEVELS - 1 
+		&& delta >= (1UL << (SLOT_BITS * (level + 1))))
+		level++;
+		
+	// Beyond the outermost wheel: clamp to the furthest tick it can hold
+	if (delta >= (1UL << (SLOT_BITS * LEVELS)))
+		node.expires = _current + (1UL << (SLOT_BITS * LEVELS)) - 1;
+		
+	int bucket = level * SLOTS 
+		+ static_cast<int>((node.expires >> (SLOT_BITS * level)) & SLOT_MASK);
+	
+	node.bucket = bucket;
+	node.prev = -1;
+	node.next = _buckets[bucket];
+	if (node.next >= 0)
+		_nodes[node.next].prev = id;
+	_buckets[bucket] = id;
+}
+
+/**
+ * Take a node out of its bucket
+ */
+void	TimerWheel::unlink(int id)
+{
+	Node& node = _nodes[id];
+	
+	if (node.prev >= 0)
+		_nodes[node.prev].next = node.next;
+	else
+		_buckets[node.bucket] = node.next;
+	if (node.next >= 0)
+		_nodes[node.next].prev = node.prev;
+	node.bucket = -1;
+}
+
+/**
+ * Move the timers of one coarse bucket down to finer levels
+ */
+void	TimerWheel::cascade(int level, int slot)
+{
+	int bucket = level * SLOTS + slot;
+	int id = _buckets[bucket];
+	
+	_buckets[bucket] = -1;
+	while (id >= 0)
+	{
+		int next = _nodes[id].next;
+		link(id);
+		id = next;
+	}
+}
+
+/**
+ * Arm (or re-arm) the timer of id to fire after timeoutMs
+ */
+void	TimerWheel::schedule(int id, int kind, unsigned long timeoutMs)
+{
+	if (id < 0)
+		return;
+		
+	if (static_cast<size_t>(id) >= _nodes.size())
+	{
+		Node unused = {0, 0, -1, -1, -1};
+		_nodes.resize(id + 1, unused);
+	}
+	
+	unsigned long now = nowMs();
+	
+	if (_nodes[id].bucket >= 0)
+		unlink(id);
+	else
+	{
+		// An empty wheel is not advanced by expire(), catch up first
+		if (_count == 0 && _current < now / _tickMs)
+			_current = now / _tickMs;
+		_count++;
+	}
+	
+	// Round up so a timer never fires before its timeout
+	_nodes[id].expires = (now + timeoutMs + _tickMs - 1) / _tickMs;
+	_nodes[id].kind = kind;
+	link(id);
+}
+
+/**
+ * Disarm the timer of id, if any
+ */
+void	TimerWheel::cancel(int id)
+{
+	if (id < 0 || static_cast<size_t>(id) >= _nodes.size() 
+		|| _nodes[id].bucket < 0)
+		return;
+		
+	unlink(id);
+	_count--;
+}
+
+/**
+ * Get the kind of the timer armed for id, or -1 if there is none
+ */
+int	TimerWheel::getKind(int id) const
+{
+	if (id < 0 || static_cast<size_t>(id) >= _nodes.size() 
+		|| _nodes[id].bucket < 0)
+		return -1;
+	return _nodes[id].kind;
+}
+
+/**
+ * Get how long the event loop may block before the next tick that
+ * needs processing, or -1 when no timer is armed
+ */
+int	TimerWheel::nextTimeout(void) const
+{
+	if (_count == 0)
+		return -1;
+		
+	// Wake up at the first busy level-0 bucket, or when level 0 wraps
+	// around and coarser timers have to be cascaded
+	unsigned long target = (_current | SLOT_MASK) + 1;
+	
+	for (unsigned long tick = _current; tick < target; tick++)
+	{
+		if (_buckets[tick & SLOT_MASK] >= 0)
+		{
+			target = tick;
+			break;
+		}
+	}
+	
+	unsigned long deadline = target * _tickMs;
+	unsigned long now = nowMs();
+	
+	if (deadline <= now)
+		return 0;
+	return static_cast<int>(deadline - now);
+}
+
+/**
+ * Advance the wheel to the current time and collect fired timers
+ */
+void	TimerWheel::expire(std::vector<TimerEvent>& fired)
+{
+	unsigned long now = nowMs() / _tickMs;
+	
+	fired.clear();
+	while (_current <= now)
+	{
+		if (_count == 0)
+		{
+			_current = now + 1;
+			break;
+		}
+		
+		int slot = static_cast<int>(_current & SLOT_MASK);
+		
+		if (slot == 0)
+		{
+			for (int level = 1; level < LEVELS; level++)
+			{
+				int index = static_cast<int>(
+					(_current >> (SLOT_BITS * level)) & SLOT_MASK);
+				cascade(level, index);
+				if (index != 0)
+					break;
+			}
+		}
+		
+		int id = _buckets[slot];
+		_buckets[slot] = -1;
+		while (id >= 0)
+		{
+			Node& node = _nodes[id];
+			TimerEvent event;
+			
+			event.id = id;
+			event.kind = node.kind;
+			fired.push_back(event);
+			id = node.next;
+			node.bucket = -1;
+			_count--;
+		}
+		_current++;
+	}
+}
+
+/**
+ * Get the number of armed timers
+ */
+size_t	TimerWheel::size(void) const
+{
+	return _count;
+}
@@ -0,0 +1,706 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   UringPoller.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/27 10:18:02 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/27 10:18:02 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "UringPoller.hpp"
+
+#ifdef WEBSERV_HAVE_IO_URING
+
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <sys/socket.h>
+# include <poll.h>
+# include <unistd.h>
+# include <fcntl.h>
+# include <cerrno>
+# include <cstring>
+# include <stdexcept>
+
+/**
+ * Number of submission queue entries requested from the kernel
+ */
+static const unsigned int	RING_ENTRIES = 1024;
+
+/**
+ * Receive buffers in the provided ring (a power of two) and their size
+ */
+static const unsigned int	BUFFER_COUNT = 256;
+static const unsigned int	BUFFER_SIZE = 16384;
+
+/**
+ * Buffer group the receives pick their buffers from
+ */
+static const unsigned short	BUFFER_GROUP = 0;
+
+/**
+ * user_data of POLL_REMOVE and ASYNC_CANCEL requests, their completions
+ * are ignored
+ */
+static const unsigned long long	CANCEL_TAG = ~0ULL;
+
+/**
+ * Kind of request, in the top two bits of user_data
+ */
+static const unsigned long long	TAG_POLL = 0;
+static const unsigned long long	TAG_ACCEPT = 1;
+static const unsigned long long	TAG_RECEIVE = 2;
+
+/**
+ * Generations keep their low 30 bits in user_data
+ */
+static const unsigned int	GENERATION_MASK = 0x3fffffff;
+
+/**
+ * Build the user_data identifying a request of fd at a given generation
+ */
+static unsigned long long	makeTag(int fd, unsigned int generation, 
+	unsigned long long kind)
+{
+	return (kind << 62) 
+		| (static_cast<unsigned long long>(generation & GENERATION_MASK) << 32)
+		| static_cast<unsigned int>(fd);
+}
+
+/**
+ * Constructor creates the ring, throws when the kernel cannot provide
+ * everything this backend relies on so the caller can fall back
+ */
+UringPoller::UringPoller(void) : _ringFd(-1), _sqRing(MAP_FAILED),
+	_sqRingSize(0), _cqRing(MAP_FAILED), _cqRingSize(0), 
+	_sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)), _sqesSize(0),
+	_pending(0), _bufRing(NULL), _bufRingSize(0), _bufData(NULL), 
+	_bufDataSize(0)
+{
+	struct io_uring_params params;
+	
+	memset(&params, 0, sizeof(params));
+	_ringFd = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+	if (_ringFd < 0)
+		throw std::runtime_error("io_uring_setup failed: " 
+			+ std::string(strerror(errno)));
+	fcntl(_ringFd, F_SETFD, FD_CLOEXEC);
+	
+	// Timed waits need IORING_ENTER_EXT_ARG (Linux 5.11)
+	if (!(params.features & IORING_FEAT_EXT_ARG))
+	{
+		release();
+		throw std::runtime_error("io_uring lacks IORING_FEAT_EXT_ARG");
+	}
+	
+	try
+	{
+		mapRings(params);
+	}
+	catch (const std::exception&)
+	{
+		release();
+		throw;
+	}
+	setupBuffers();
+}
+
+/**
+ * Destructor unmaps the rings and closes the instance
+ */
+UringPoller::~UringPoller(void)
+{
+	release();
+}
+
+/**
+ * Map the submission and completion rings, throws on failure
+ */
+void	UringPoller::mapRings(const struct io_uring_params& params)
+{
+	_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	_cqRingSize = params.cq_off.cqes 
+		+ params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (_cqRingSize > _sqRingSize)
+			_sqRingSize = _cqRingSize;
+		_cqRingSize = _sqRingSize;
+	}
+	
+	_sqRing = mmap(NULL, _sqRingSize, PROT_READ | PROT_WRITE, 
+		MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+	if (_sqRing == MAP_FAILED)
+		throw std::runtime_error("Failed to map io_uring SQ ring");
+		
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		_cqRing = _sqRing;
+	else
+	{
+		_cqRing = mmap(NULL, _cqRingSize, PROT_READ | PROT_WRITE, 
+			MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+		if (_cqRing == MAP_FAILED)
+			throw std::runtime_error("Failed to map io_uring CQ ring");
+	}
+	
+	_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	_sqes = static_cast<struct io_uring_sqe*>(mmap(NULL, _sqesSize, 
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, 
+		IORING_OFF_SQES));
+	if (_sqes == MAP_FAILED)
+		throw std::runtime_error("Failed to map io_uring SQEs");
+	
+	char* sq = static_cast<char*>(_sqRing);
+	char* cq = static_cast<char*>(_cqRing);
+	
+	_sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+	_sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+	_sqMask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+	_sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+	_sqEntries = params.sq_entries;
+	_cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+	_cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+	_cqMask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+/**
+ * Register the receive buffer ring; completions stay off if the kernel
+ * refuses it, and every descriptor is then polled for readiness
+ */
+void	UringPoller::setupBuffers(void)
+{
+# ifdef IORING_ACCEPT_MULTISHOT
+	// Pages are only touched, and so only resident, once a buffer is used
+	_bufRingSize = BUFFER_COUNT * sizeof(struct io_uring_buf);
+	void* ring = mmap(NULL, _bufRingSize, PROT_READ | PROT_WRITE, 
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	_bufDataSize = static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE;
+	void* data = mmap(NULL, _bufDataSize, PROT_READ | PROT_WRITE, 
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	struct io_uring_buf_reg reg;
+	
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = reinterpret_cast<unsigned long long>(ring);
+	reg.ring_entries = BUFFER_COUNT;
+	reg.bgid = BUFFER_GROUP;
+	if (ring == MAP_FAILED || data == MAP_FAILED || syscall(
+		__NR_io_uring_register, _ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+	{
+		if (ring != MAP_FAILED)
+			munmap(ring, _bufRingSize);
+		if (data != MAP_FAILED)
+			munmap(data, _bufDataSize);
+		return;
+	}
+	
+	_bufRing = static_cast<struct io_uring_buf_ring*>(ring);
+	_bufData = static_cast<char*>(data);
+	for (unsigned int id = 0; id < BUFFER_COUNT; id++)
+		recycleBuffer(id);
+# endif
+}
+
+/**
+ * Give a receive buffer back to the kernel; only this thread moves the
+ * tail, the kernel reads it
+ */
+void	UringPoller::recycleBuffer(unsigned int id)
+{
+# ifdef IORING_ACCEPT_MULTISHOT
+	// The entries start at the ring itself: the header's bufs member sits
+	// behind an empty struct, which C++ gives a size
+	struct io_uring_buf* bufs = reinterpret_cast<struct io_uring_buf*>(_bufRing);
+	unsigned short tail = _bufRing->tail;
+	struct io_uring_buf* buf = &bufs[tail & (BUFFER_COUNT - 1)];
+	
+	buf->addr = reinterpret_cast<unsigned long long>(
+		_bufData + static_cast<size_t>(id) * BUFFER_SIZE);
+	buf->len = BUFFER_SIZE;
+	buf->bid = static_cast<unsigned short>(id);
+	__atomic_store_n(&_bufRing->tail, static_cast<unsigned short>(tail + 1), 
+		__ATOMIC_RELEASE);
+# else
+	(void)id;
+# endif
+}
+
+/**
+ * Release the rings and the io_uring instance
+ */
+void	UringPoller::release(void)
+{
+	if (_sqes != MAP_FAILED)
+		munmap(_sqes, _sqesSize);
+	if (_cqRing != MAP_FAILED && _cqRing != _sqRing)
+		munmap(_cqRing, _cqRingSize);
+	if (_sqRing != MAP_FAILED)
+		munmap(_sqRing, _sqRingSize);
+	_sqes = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+	_cqRing = MAP_FAILED;
+	_sqRing = MAP_FAILED;
+	if (_ringFd >= 0)
+		close(_ringFd);
+	_ringFd = -1;
+	
+	// The kernel let go of the buffers with the instance
+	if (_bufRing)
+		munmap(_bufRing, _bufRingSize);
+	if (_bufData)
+		munmap(_bufData, _bufDataSize);
+	_bufRing = NULL;
+	_bufData = NULL;
+}
+
+/**
+ * Get the state slot for fd, growing the table when needed
+ */
+UringPoller::FdState&	UringPoller::getState(int fd)
+{
+	if (fd < 0)
+		throw std::runtime_error("Invalid descriptor for io_uring");
+	if (static_cast<size_t>(fd) >= _fds.size())
+		_fds.resize(fd + 1);
+	return _fds[fd];
+}
+
+/**
+ * Get a free SQE, flushing the queue to the kernel when it is full.
+ * Without SQPOLL the kernel only reads SQEs inside io_uring_enter(), so
+ * the entry may be filled after the tail has been published.
+ */
+struct io_uring_sqe*	UringPoller::getSqe(void)
+{
+	unsigned int tail = *_sqTail;
+	unsigned int head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+	
+	if (tail - head >= _sqEntries)
+	{
+		if (enter(0, 0) < 0 && errno != ETIME)
+			throw std::runtime_error("io_uring_enter failed: " 
+				+ std::string(strerror(errno)));
+		head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+		if (tail - head >= _sqEntries)
+			throw std::runtime_error("io_uring submission queue is full");
+	}
+	
+	unsigned int index = tail & *_sqMask;
+	struct io_uring_sqe* sqe = &_sqes[index];
+	
+	memset(sqe, 0, sizeof(*sqe));
+	_sqArray[index] = index;
+	__atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+	_pending++;
+	return sqe;
+}
+
+/**
+ * Get the poll events fd's interest needs, 0 for none; reading is the
+ * receive's job on a receiving descriptor
+ */
+unsigned int	UringPoller::pollMask(const FdState& state) const
+{
+	unsigned int mask = 0;
+	
+	if ((state.events & EVENT_READ) && state.mode == MODE_POLL)
+		mask |= POLLIN;
+	if (state.events & EVENT_WRITE)
+		mask |= POLLOUT;
+	return mask;
+}
+
+/**
+ * Queue a one-shot poll for fd with its current interest
+ */
+void	UringPoller::queuePoll(int fd)
+{
+	FdState& state = _fds[fd];
+	
+	struct io_uring_sqe* sqe = getSqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = pollMask(state);
+	sqe->user_data = makeTag(fd, state.generation, TAG_POLL);
+	state.armed = true;
+}
+
+/**
+ * Queue the cancellation of the poll currently in flight for fd
+ */
+void	UringPoller::queueCancel(int fd)
+{
+	FdState& state = _fds[fd];
+	
+	struct io_uring_sqe* sqe = getSqe();
+	sqe->opcode = IORING_OP_POLL_REMOVE;
+	sqe->fd = -1;
+	sqe->addr = makeTag(fd, state.generation, TAG_POLL);
+	sqe->user_data = CANCEL_TAG;
+	state.armed = false;
+}
+
+/**
+ * Queue the accept or receive of fd. Accepted sockets come out
+ * non-blocking and close-on-exec, like accept4() makes them; a receive
+ * takes whichever ring buffer is free when data arrives.
+ */
+void	UringPoller::queueIo(int fd)
+{
+	FdState& state = _fds[fd];
+	
+	struct io_uring_sqe* sqe = getSqe();
+	sqe->fd = fd;
+	if (state.mode == MODE_ACCEPT)
+	{
+		sqe->opcode = IORING_OP_ACCEPT;
+# ifdef IORING_ACCEPT_MULTISHOT
+		sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+# endif
+		sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+		sqe->user_data = makeTag(fd, state.ioGeneration, TAG_ACCEPT);
+	}
+	else
+	{
+		sqe->opcode = IORING_OP_RECV;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = BUFFER_GROUP;
+		sqe->len = BUFFER_SIZE;
+		sqe->user_data = makeTag(fd, state.ioGeneration, TAG_RECEIVE);
+	}
+	state.ioArmed = true;
+}
+
+/**
+ * Queue the cancellation of the accept or receive in flight for fd
+ */
+void	UringPoller::queueIoCancel(int fd)
+{
+	FdState& state = _fds[fd];
+	
+	struct io_uring_sqe* sqe = getSqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = makeTag(fd, state.ioGeneration, 
+		state.mode == MODE_ACCEPT ? TAG_ACCEPT : TAG_RECEIVE);
+	sqe->user_data = CANCEL_TAG;
+	state.ioArmed = false;
+}
+
+/**
+ * Queue whatever fd's interest needs and is not in flight yet
+ */
+void	UringPoller::arm(int fd)
+{
+	FdState& state = _fds[fd];
+	
+	if (!state.registered)
+		return;
+	// An empty poll still reports errors and hangups
+	if (!state.armed && (state.mode == MODE_POLL || pollMask(state) != 0))
+		queuePoll(fd);
+	if (!state.ioArmed && (state.mode == MODE_ACCEPT || 
+		(state.mode == MODE_RECEIVE && (state.events & EVENT_READ))))
+		queueIo(fd);
+}
+
+/**
+ * Submit pending SQEs and optionally wait for one completion
+ */
+int	UringPoller::enter(unsigned int minComplete, int timeoutMs)
+{
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	unsigned int flags = IORING_ENTER_EXT_ARG;
+	
+	memset(&arg, 0, sizeof(arg));
+	if (minComplete > 0)
+	{
+		flags |= IORING_ENTER_GETEVENTS;
+		if (timeoutMs >= 0)
+		{
+			ts.tv_sec = timeoutMs / 1000;
+			ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+			arg.ts = reinterpret_cast<unsigned long long>(&ts);
+		}
+	}
+	
+	int submitted = syscall(__NR_io_uring_enter, _ringFd, _pending, 
+		minComplete, flags, &arg, sizeof(arg));
+	if (submitted > 0)
+		_pending -= (static_cast<unsigned int>(submitted) > _pending) 
+			? _pending : submitted;
+	return submitted;
+}
+
+/**
+ * Move the available completions into ready
+ */
+void	UringPoller::reap(std::vector<PollEvent>& ready)
+{
+	unsigned int head = *_cqHead;
+	unsigned int tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+	
+	while (head != tail)
+	{
+		struct io_uring_cqe* cqe = &_cqes[head & *_cqMask];
+		unsigned long long tag = cqe->user_data;
+		int res = cqe->res;
+		
+		head++;
+		if (tag == CANCEL_TAG)
+			continue;
+		if ((tag >> 62) != TAG_POLL)
+		{
+			reapIo(*cqe, ready);
+			continue;
+		}
+			
+		int fd = static_cast<int>(tag & 0xffffffffULL);
+		unsigned int generation = static_cast<unsigned int>(tag >> 32) 
+			& GENERATION_MASK;
+		
+		// Drop completions of polls that were cancelled or replaced
+		if (fd < 0 || static_cast<size_t>(fd) >= _fds.size())
+			continue;
+		FdState& state = _fds[fd];
+		if (!state.registered || 
+			(state.generation & GENERATION_MASK) != generation)
+			continue;
+			
+		state.armed = false;
+		_rearm.push_back(fd);
+		
+		PollEvent event;
+		event.fd = fd;
+		event.events = 0;
+		if (res < 0)
+			event.events = EVENT_ERROR;
+		else
+		{
+			if (res & POLLIN)
+				event.events |= EVENT_READ;
+			if (res & POLLOUT)
+				event.events |= EVENT_WRITE;
+			if (res & (POLLERR | POLLHUP | POLLNVAL))
+				event.events |= EVENT_ERROR;
+		}
+		if (event.events)
+			ready.push_back(event);
+	}
+	__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Turn the completion of an accept or receive into an event. Those of
+ * a request that was cancelled or replaced still hand back their buffer,
+ * and close the socket they accepted.
+ */
+void	UringPoller::reapIo(const struct io_uring_cqe& cqe, 
+	std::vector<PollEvent>& ready)
+{
+	unsigned long long kind = cqe.user_data >> 62;
+	int fd = static_cast<int>(cqe.user_data & 0xffffffffULL);
+	unsigned int generation = static_cast<unsigned int>(cqe.user_data >> 32) 
+		& GENERATION_MASK;
+	bool hasBuffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+	unsigned int id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+	
+	if (fd < 0 || static_cast<size_t>(fd) >= _fds.size() || 
+		!_fds[fd].registered || 
+		(_fds[fd].ioGeneration & GENERATION_MASK) != generation)
+	{
+		if (hasBuffer)
+			recycleBuffer(id);
+		if (kind == TAG_ACCEPT && cqe.res >= 0)
+			close(cqe.res);
+		return;
+	}
+	
+	FdState& state = _fds[fd];
+	PollEvent event;
+	
+	event.fd = fd;
+	event.result = cqe.res;
+	if (kind == TAG_ACCEPT)
+	{
+		// A multishot accept stays armed until it reports otherwise
+		if (!(cqe.flags & IORING_CQE_F_MORE))
+		{
+			state.ioArmed = false;
+			_rearm.push_back(fd);
+		}
+		event.events = EVENT_ACCEPTED;
+	}
+	else
+	{
+		state.ioArmed = false;
+		_rearm.push_back(fd);
+		// Every buffer was in use: retried once wait() has returned them
+		if (cqe.res == -ENOBUFS)
+			return;
+		event.events = EVENT_RECEIVED;
+		if (hasBuffer)
+		{
+			event.data = _bufData + static_cast<size_t>(id) * BUFFER_SIZE;
+			_delivered.push_back(id);
+		}
+	}
+	ready.push_back(event);
+}
+
+/**
+ * Start watching fd
+ */
+void	UringPoller::add(int fd, int events)
+{
+	FdState& state = getState(fd);
+	
+	if (state.registered)
+	{
+		modify(fd, events);
+		return;
+	}
+	state.registered = true;
+	state.mode = MODE_POLL;
+	state.events = events;
+	state.generation++;
+	arm(fd);
+}
+
+/**
+ * Accept on a listening socket with a multishot accept, when the ring
+ * buffers (from the same kernel release) could be set up
+ */
+bool	UringPoller::addAcceptor(int fd)
+{
+	if (!_bufRing)
+		return false;
+	
+	FdState& state = getState(fd);
+	
+	if (state.registered)
+		remove(fd);
+	state.registered = true;
+	state.mode = MODE_ACCEPT;
+	state.events = 0;
+	state.generation++;
+	state.ioGeneration++;
+	arm(fd);
+	return true;
+}
+
+/**
+ * Watch a client socket whose reads complete into the ring buffers
+ */
+bool	UringPoller::addReceiver(int fd, int events)
+{
+	if (!_bufRing)
+		return false;
+	
+	FdState& state = getState(fd);
+	
+	if (state.registered)
+		remove(fd);
+	state.registered = true;
+	state.mode = MODE_RECEIVE;
+	state.events = events;
+	state.generation++;
+	state.ioGeneration++;
+	arm(fd);
+	return true;
+}
+
+/**
+ * Change the conditions watched for fd, an armed poll is replaced. A
+ * receive in flight is left alone when reading stops being watched: it
+ * may already hold data, which is reported rather than lost.
+ */
+void	UringPoller::modify(int fd, int events)
+{
+	FdState& state = getState(fd);
+	
+	if (!state.registered)
+		throw std::runtime_error("Descriptor not registered with io_uring");
+	if (state.events == events)
+		return;
+	
+	unsigned int mask = pollMask(state);
+	
+	state.events = events;
+	
+	if (state.armed && pollMask(state) != mask)
+	{
+		queueCancel(fd);
+		state.generation++;
+	}
+	arm(fd);
+}
+
+/**
+ * Stop watching fd
+ */
+void	UringPoller::remove(int fd)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _fds.size())
+		return;
+		
+	FdState& state = _fds[fd];
+	if (!state.registered)
+		return;
+	if (state.armed)
+		queueCancel(fd);
+	if (state.ioArmed)
+		queueIoCancel(fd);
+	state.registered = false;
+	state.generation++;
+	state.ioGeneration++;
+}
+
+/**
+ * Re-arm fired polls, submit every queued change and wait for events,
+ * all within a single io_uring_enter() call
+ */
+int	UringPoller::wait(std::vector<PollEvent>& ready, int timeoutMs)
+{
+	ready.clear();
+	
+	// The data of the previous batch has been consumed by now
+	for (size_t i = 0; i < _delivered.size(); i++)
+		recycleBuffer(_delivered[i]);
+	_delivered.clear();
+	
+	for (size_t i = 0; i < _rearm.size(); i++)
+		arm(_rearm[i]);
+	_rearm.clear();
+	
+	// Completions may already be waiting, in which case only submit
+	bool haveCompletions = (*_cqHead 
+		!= __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE));
+	
+	if (haveCompletions)
+	{
+		if (_pending > 0 && enter(0, 0) < 0 && errno != EINTR)
+			return -1;
+	}
+	else if (enter(1, timeoutMs) < 0 && errno != ETIME)
+	{
+		// EAGAIN/EBUSY: the CQ must be drained before more SQEs are taken
+		if (errno != EAGAIN && errno != EBUSY)
+			return -1;
+	}
+	
+	reap(ready);
+	return static_cast<int>(ready.size());
+}
+
+/**
+ * Get the backend name
+ */
+const char*	UringPoller::getName(void) const
+{
+	return "io_uring";
+}
+
+#endif
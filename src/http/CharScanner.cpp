@@ -0,0 +1,390 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CharScanner.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/13 10:22:07 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/13 10:22:07 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "CharScanner.hpp"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define CHAR_SCANNER_X86
+# include <immintrin.h>
+#endif
+
+/**
+ * Token characters, classified by nibble: c is a token character when
+ * TOKEN_LOW[c & 15] & TOKEN_HIGH[c >> 4] is not zero. Each high nibble
+ * from 2 to 7 owns one bit, so the same tables drive pshufb lookups.
+ */
+static const unsigned char	TOKEN_LOW[16] __attribute__((aligned(16))) = {
+	0x3a, 0x3f, 0x3e, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,
+	0x3e, 0x3e, 0x3d, 0x15, 0x34, 0x15, 0x3d, 0x1c
+};
+static const unsigned char	TOKEN_HIGH[16] __attribute__((aligned(16))) = {
+	0x00, 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/**
+ * Check whether a byte may appear in a field value
+ */
+static inline bool	isFieldValueChar(unsigned char c)
+{
+	return c == '\t' || (c >= ' ' && c != 0x7f);
+}
+
+/**
+ * Scalar variants, also used for the tail shorter than a vector
+ */
+static size_t	findByteScalar(const char* data, size_t length, char c)
+{
+	const void* found = memchr(data, c, length);
+	
+	if (!found)
+		return length;
+	return static_cast<const char*>(found) - data;
+}
+
+static size_t	skipTokenScalar(const char* data, size_t length)
+{
+	size_t i = 0;
+	
+	while (i < length)
+	{
+		unsigned char c = data[i];
+		if (!(TOKEN_LOW[c & 15] & TOKEN_HIGH[c >> 4]))
+			break;
+		i++;
+	}
+	return i;
+}
+
+static size_t	skipFieldValueScalar(const char* data, size_t length)
+{
+	size_t i = 0;
+	
+	while (i < length && isFieldValueChar(data[i]))
+		i++;
+	return i;
+}
+
+#ifdef CHAR_SCANNER_X86
+
+/**
+ * SSE4.2 variants, 16 bytes per step
+ */
+__attribute__((target("sse4.2")))
+static size_t	findByteSse42(const char* data, size_t length, char c)
+{
+	const __m128i needle = _mm_set1_epi8(c);
+	size_t i = 0;
+	
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+	return i + findByteScalar(data + i, length - i, c);
+}
+
+__attribute__((target("sse4.2")))
+static size_t	skipTokenSse42(const char* data, size_t length)
+{
+	const __m128i low = _mm_load_si128(
+		reinterpret_cast<const __m128i*>(TOKEN_LOW));
+	const __m128i high = _mm_load_si128(
+		reinterpret_cast<const __m128i*>(TOKEN_HIGH));
+	const __m128i nibble = _mm_set1_epi8(0x0f);
+	size_t i = 0;
+	
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		__m128i lowBits = _mm_shuffle_epi8(low, _mm_and_si128(chunk, nibble));
+		__m128i highBits = _mm_shuffle_epi8(high, 
+			_mm_and_si128(_mm_srli_epi16(chunk, 4), nibble));
+		__m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(lowBits, highBits), 
+			_mm_setzero_si128());
+		int mask = _mm_movemask_epi8(invalid);
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+	return i + skipTokenScalar(data + i, length - i);
+}
+
+__attribute__((target("sse4.2")))
+static size_t	skipFieldValueSse42(const char* data, size_t length)
+{
+	// Allowed ranges: HTAB, SP to '~', obs-text
+	static const char ranges[16] __attribute__((aligned(16))) = {
+		'\t', '\t', ' ', '~', '\x80', '\xff'
+	};
+	const __m128i allowed = _mm_load_si128(
+		reinterpret_cast<const __m128i*>(ranges));
+	size_t i = 0;
+	
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		int index = _mm_cmpestri(allowed, 6, chunk, 16, 
+			_SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY | 
+			_SIDD_LEAST_SIGNIFICANT);
+		if (index != 16)
+			return i + index;
+	}
+	return i + skipFieldValueScalar(data + i, length - i);
+}
+
+/**
+ * AVX2 variants, 32 bytes per step then one 16-byte step, all VEX
+ * encoded: falling back to the SSE variants for the tail would mix in
+ * legacy SSE instructions and pay the AVX transition penalty per call
+ */
+
+/**
+ * Clear the upper halves before leaving AVX code, GCC only does it
+ * itself when optimizing
+ */
+__attribute__((target("avx2")))
+static inline size_t	avx2Return(size_t index)
+{
+	_mm256_zeroupper();
+	return index;
+}
+
+__attribute__((target("avx2")))
+static size_t	findByteAvx2(const char* data, size_t length, char c)
+{
+	const __m256i needle = _mm256_set1_epi8(c);
+	size_t i = 0;
+	
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i chunk = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(data + i));
+		unsigned int mask = _mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(chunk, needle));
+		if (mask)
+			return avx2Return(i + __builtin_ctz(mask));
+	}
+	if (i + 16 <= length)
+	{
+		__m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		int mask = _mm_movemask_epi8(
+			_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(needle)));
+		if (mask)
+			return avx2Return(i + __builtin_ctz(mask));
+		i += 16;
+	}
+	return avx2Return(i + findByteScalar(data + i, length - i, c));
+}
+
+__attribute__((target("avx2")))
+static size_t	skipTokenAvx2(const char* data, size_t length)
+{
+	// vpshufb looks up within each 128-bit lane, so both lanes get a copy
+	const __m256i low = _mm256_broadcastsi128_si256(_mm_load_si128(
+		reinterpret_cast<const __m128i*>(TOKEN_LOW)));
+	const __m256i high = _mm256_broadcastsi128_si256(_mm_load_si128(
+		reinterpret_cast<const __m128i*>(TOKEN_HIGH)));
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+	size_t i = 0;
+	
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i chunk = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(data + i));
+		__m256i lowBits = _mm256_shuffle_epi8(low, 
+			_mm256_and_si256(chunk, nibble));
+		__m256i highBits = _mm256_shuffle_epi8(high, 
+			_mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+		__m256i invalid = _mm256_cmpeq_epi8(
+			_mm256_and_si256(lowBits, highBits), _mm256_setzero_si256());
+		unsigned int mask = _mm256_movemask_epi8(invalid);
+		if (mask)
+			return avx2Return(i + __builtin_ctz(mask));
+	}
+	if (i + 16 <= length)
+	{
+		const __m128i nibble128 = _mm256_castsi256_si128(nibble);
+		__m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		__m128i lowBits = _mm_shuffle_epi8(_mm256_castsi256_si128(low), 
+			_mm_and_si128(chunk, nibble128));
+		__m128i highBits = _mm_shuffle_epi8(_mm256_castsi256_si128(high), 
+			_mm_and_si128(_mm_srli_epi16(chunk, 4), nibble128));
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+			_mm_and_si128(lowBits, highBits), _mm_setzero_si128()));
+		if (mask)
+			return avx2Return(i + __builtin_ctz(mask));
+		i += 16;
+	}
+	return avx2Return(i + skipTokenScalar(data + i, length - i));
+}
+
+__attribute__((target("avx2")))
+static size_t	skipFieldValueAvx2(const char* data, size_t length)
+{
+	const __m256i lastControl = _mm256_set1_epi8(0x1f);
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i del = _mm256_set1_epi8(0x7f);
+	size_t i = 0;
+	
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i chunk = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(data + i));
+		// Unsigned c <= 0x1f is min(c, 0x1f) == c
+		__m256i control = _mm256_cmpeq_epi8(
+			_mm256_min_epu8(chunk, lastControl), chunk);
+		control = _mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab), control);
+		control = _mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, del));
+		unsigned int mask = _mm256_movemask_epi8(control);
+		if (mask)
+			return avx2Return(i + __builtin_ctz(mask));
+	}
+	if (i + 16 <= length)
+	{
+		__m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		__m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, 
+			_mm256_castsi256_si128(lastControl)), chunk);
+		control = _mm_andnot_si128(_mm_cmpeq_epi8(chunk, 
+			_mm256_castsi256_si128(tab)), control);
+		control = _mm_or_si128(control, _mm_cmpeq_epi8(chunk, 
+			_mm256_castsi256_si128(del)));
+		int mask = _mm_movemask_epi8(control);
+		if (mask)
+			return avx2Return(i + __builtin_ctz(mask));
+		i += 16;
+	}
+	return avx2Return(i + skipFieldValueScalar(data + i, length - i));
+}
+
+#endif
+
+/**
+ * One set of scanners
+ */
+struct ScannerVariant
+{
+	const char*	name;
+	size_t		(*findByte)(const char*, size_t, char);
+	size_t		(*skipToken)(const char*, size_t);
+	size_t		(*skipFieldValue)(const char*, size_t);
+};
+
+static const ScannerVariant	SCALAR_VARIANT = {
+	"scalar", findByteScalar, skipTokenScalar, skipFieldValueScalar
+};
+
+#ifdef CHAR_SCANNER_X86
+static const ScannerVariant	SSE42_VARIANT = {
+	"sse4.2", findByteSse42, skipTokenSse42, skipFieldValueSse42
+};
+static const ScannerVariant	AVX2_VARIANT = {
+	"avx2", findByteAvx2, skipTokenAvx2, skipFieldValueAvx2
+};
+#endif
+
+/**
+ * Check whether the running CPU can execute a variant
+ */
+static bool	isSupported(const ScannerVariant* variant)
+{
+#ifdef CHAR_SCANNER_X86
+	__builtin_cpu_init();
+	if (variant == &AVX2_VARIANT)
+		return __builtin_cpu_supports("avx2");
+	if (variant == &SSE42_VARIANT)
+		return __builtin_cpu_supports("sse4.2");
+#endif
+	return variant == &SCALAR_VARIANT;
+}
+
+/**
+ * Pick the widest variant the running CPU supports
+ */
+static const ScannerVariant*	detectVariant(void)
+{
+#ifdef CHAR_SCANNER_X86
+	if (isSupported(&AVX2_VARIANT))
+		return &AVX2_VARIANT;
+	if (isSupported(&SSE42_VARIANT))
+		return &SSE42_VARIANT;
+#endif
+	return &SCALAR_VARIANT;
+}
+
+// Resolved before main(), read-only afterwards, so shards can share it
+static const ScannerVariant*	g_variant = detectVariant();
+
+/**
+ * Find the first occurrence of c
+ */
+size_t	CharScanner::findByte(const char* data, size_t length, char c)
+{
+	return g_variant->findByte(data, length, c);
+}
+
+/**
+ * Skip token characters, stops on anything else
+ */
+size_t	CharScanner::skipToken(const char* data, size_t length)
+{
+	return g_variant->skipToken(data, length);
+}
+
+/**
+ * Skip field value characters, stops on control characters
+ */
+size_t	CharScanner::skipFieldValue(const char* data, size_t length)
+{
+	return g_variant->skipFieldValue(data, length);
+}
+
+/**
+ * Get the name of the variant in use
+ */
+const char*	CharScanner::getImplementation(void)
+{
+	return g_variant->name;
+}
+
+/**
+ * Force a variant by name, false if this CPU cannot run it
+ */
+bool	CharScanner::setImplementation(const std::string& name)
+{
+	const ScannerVariant* variants[] = {
+#ifdef CHAR_SCANNER_X86
+		&AVX2_VARIANT, &SSE42_VARIANT,
+#endif
+		&SCALAR_VARIANT
+	};
+	
+	for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++)
+	{
+		if (name == variants[i]->name)
+		{
+			if (!isSupported(variants[i]))
+				return false;
+			g_variant = variants[i];
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,135 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HeaderTable.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/15 11:05:44 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/15 11:05:44 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "HeaderTable.hpp"
+#include <strings.h>
+
+/**
+ * Size of the hash space; weights of characters that appear in no
+ * known name push the hash past it
+ */
+static const unsigned int	HASH_SIZE = 70;
+
+/**
+ * Canonical names, in HeaderId order
+ */
+static const char*	HEADER_NAMES[HEADER_COUNT] = {
+	"Host", "Connection", "Content-Length", "Content-Type",
+	"Transfer-Encoding", "Expect", "Accept", "Accept-Encoding",
+	"Accept-Language", "Authorization", "Cookie", "User-Agent",
+	"Referer", "Origin", "Cache-Control", "Pragma",
+	"If-Modified-Since", "If-None-Match", "If-Range", "If-Match",
+	"If-Unmodified-Since", "Range", "Upgrade", "HTTP2-Settings",
+	"TE", "Keep-Alive", "X-Forwarded-For"
+};
+
+/**
+ * Character weights, the same for both cases
+ */
+static const unsigned char	HASH_WEIGHTS[256] = {
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 14, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70,  3, 70,  8, 70,  0,  2,  5,  3,  6, 70, 70, 25, 70,  1,  1,
+	38, 70,  9, 11, 22, 18, 70, 70,  2, 70, 70, 70, 70, 70, 70, 70,
+	70,  3, 70,  8, 70,  0,  2,  5,  3,  6, 70, 70, 25, 70,  1,  1,
+	38, 70,  9, 11, 22, 18, 70, 70,  2, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70,
+	70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70, 70
+};
+
+/**
+ * Header id owning each hash value
+ */
+static const HeaderId	HASH_SLOTS[HASH_SIZE] = {
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_TE,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_COOKIE,
+	HEADER_RANGE, HEADER_KEEP_ALIVE, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_CONNECTION, HEADER_CONTENT_TYPE,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_REFERER, HEADER_CONTENT_LENGTH, HEADER_UNKNOWN,
+	HEADER_PRAGMA, HEADER_ORIGIN, HEADER_UNKNOWN,
+	HEADER_IF_RANGE, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_IF_MATCH, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_ACCEPT_LANGUAGE, HEADER_IF_NONE_MATCH,
+	HEADER_IF_MODIFIED_SINCE, HEADER_TRANSFER_ENCODING, HEADER_IF_UNMODIFIED_SINCE,
+	HEADER_ACCEPT_ENCODING, HEADER_UNKNOWN, HEADER_HOST,
+	HEADER_UNKNOWN, HEADER_X_FORWARDED_FOR, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_USER_AGENT, HEADER_ACCEPT,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_CACHE_CONTROL, HEADER_UPGRADE,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_AUTHORIZATION, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_UNKNOWN,
+	HEADER_UNKNOWN, HEADER_UNKNOWN, HEADER_EXPECT,
+	HEADER_HTTP2_SETTINGS
+};
+
+/**
+ * Hash a field name, equal names in any case hash the same
+ */
+static unsigned int	hashName(const char* name, size_t length)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(name);
+	unsigned int hash = length + HASH_WEIGHTS[bytes[1]] + 
+		HASH_WEIGHTS[bytes[length - 1]];
+	
+	if (length > 2)
+		hash += HASH_WEIGHTS[bytes[2]];
+	return hash;
+}
+
+/**
+ * Get the id of a field name in any case, HEADER_UNKNOWN if the name
+ * is not a known one
+ */
+HeaderId	HeaderTable::lookup(const char* name, size_t length)
+{
+	// The shortest known name is TE, the longest If-Unmodified-Since
+	if (length < 2 || length > 19)
+		return HEADER_UNKNOWN;
+	
+	unsigned int hash = hashName(name, length);
+	
+	if (hash >= HASH_SIZE)
+		return HEADER_UNKNOWN;
+	
+	HeaderId id = HASH_SLOTS[hash];
+	
+	// Different names can share a hash value, the compare settles it;
+	// a match also proves the known name is long enough to index
+	if (id == HEADER_UNKNOWN || 
+		strncasecmp(HEADER_NAMES[id], name, length) != 0 || 
+		HEADER_NAMES[id][length] != '\0')
+		return HEADER_UNKNOWN;
+	return id;
+}
+
+/**
+ * Get the canonical spelling of a known field name
+ */
+const char*	HeaderTable::getName(HeaderId id)
+{
+	if (id >= HEADER_COUNT)
+		return "";
+	return HEADER_NAMES[id];
+}
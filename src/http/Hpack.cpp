@@ -0,0 +1,492 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Hpack.cpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/20 11:02:37 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/20 11:02:37 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Hpack.hpp"
+#include <cstring>
+#include <cstdio>
+
+/**
+ * Limits on what a header block may expand to, so a few bytes of
+ * references to a large table entry cannot blow up in memory
+ */
+static const size_t	DEFAULT_TABLE_SIZE = 4096;
+static const size_t	MAX_DECODED_SIZE = 65536;
+
+/**
+ * Static table (RFC 7541 Appendix A), index 1 first
+ */
+static const char* const	STATIC_TABLE[][2] = {
+	{":authority", ""}, {":method", "GET"}, {":method", "POST"},
+	{":path", "/"}, {":path", "/index.html"}, {":scheme", "http"},
+	{":scheme", "https"}, {":status", "200"}, {":status", "204"},
+	{":status", "206"}, {":status", "304"}, {":status", "400"},
+	{":status", "404"}, {":status", "500"}, {"accept-charset", ""},
+	{"accept-encoding", "gzip, deflate"}, {"accept-language", ""},
+	{"accept-ranges", ""}, {"accept", ""},
+	{"access-control-allow-origin", ""}, {"age", ""}, {"allow", ""},
+	{"authorization", ""}, {"cache-control", ""},
+	{"content-disposition", ""}, {"content-encoding", ""},
+	{"content-language", ""}, {"content-length", ""},
+	{"content-location", ""}, {"content-range", ""},
+	{"content-type", ""}, {"cookie", ""}, {"date", ""}, {"etag", ""},
+	{"expect", ""}, {"expires", ""}, {"from", ""}, {"host", ""},
+	{"if-match", ""}, {"if-modified-since", ""}, {"if-none-match", ""},
+	{"if-range", ""}, {"if-unmodified-since", ""}, {"last-modified", ""},
+	{"link", ""}, {"location", ""}, {"max-forwards", ""},
+	{"proxy-authenticate", ""}, {"proxy-authorization", ""},
+	{"range", ""}, {"referer", ""}, {"refresh", ""}, {"retry-after", ""},
+	{"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""},
+	{"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""},
+	{"via", ""}, {"www-authenticate", ""}
+};
+
+static const size_t	STATIC_TABLE_SIZE = 
+	sizeof(STATIC_TABLE) / sizeof(STATIC_TABLE[0]);
+
+/**
+ * @struct HuffmanCode
+ * @brief Code of one symbol, right-aligned in bits
+ */
+struct HuffmanCode
+{
+	unsigned int	code;
+	unsigned int	bits;
+};
+
+/**
+ * Huffman code (RFC 7541 Appendix B), symbols 0 to 255 then EOS
+ */
+static const HuffmanCode	HUFFMAN_CODES[257] = {
+	{0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+	{0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+	{0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+	{0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+	{0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+	{0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+	{0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+	{0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+	{0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+	{0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+	{0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+	{0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+	{0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+	{0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+	{0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+	{0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+	{0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+	{0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+	{0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+	{0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+	{0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+	{0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+	{0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+	{0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+	{0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+	{0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+	{0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+	{0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+	{0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+	{0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+	{0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+	{0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+	{0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+	{0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+	{0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+	{0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+	{0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+	{0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+	{0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+	{0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+	{0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+	{0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+	{0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+	{0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+	{0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+	{0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+	{0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+	{0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+	{0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+	{0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+	{0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+	{0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+	{0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+	{0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+	{0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+	{0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+	{0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+	{0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+	{0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+	{0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+	{0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+	{0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+	{0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+	{0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+	{0x3fffffff, 30}
+};
+
+static const unsigned int	HUFFMAN_EOS = 256;
+static const unsigned int	HUFFMAN_MAX_BITS = 30;
+
+/**
+ * @struct HuffmanDecoder
+ * @brief Canonical decoding tables derived from HUFFMAN_CODES
+ * 
+ * The code is canonical: within one length, codes are consecutive and
+ * follow symbol order. A prefix of n bits is therefore a complete code
+ * exactly when it falls in [first[n], first[n] + count[n]).
+ */
+struct HuffmanDecoder
+{
+	unsigned int	first[HUFFMAN_MAX_BITS + 1];  // smallest code per length
+	unsigned int	count[HUFFMAN_MAX_BITS + 1];
+	unsigned int	offset[HUFFMAN_MAX_BITS + 1];  // into symbols
+	unsigned short	symbols[257];  // by length, then code
+	
+	HuffmanDecoder(void)
+	{
+		size_t next = 0;
+		
+		for (unsigned int bits = 0; bits <= HUFFMAN_MAX_BITS; bits++)
+		{
+			first[bits] = 0;
+			count[bits] = 0;
+			offset[bits] = next;
+			for (unsigned int symbol = 0; symbol < 257; symbol++)
+			{
+				if (HUFFMAN_CODES[symbol].bits != bits)
+					continue;
+				if (count[bits] == 0)
+					first[bits] = HUFFMAN_CODES[symbol].code;
+				count[bits]++;
+				symbols[next++] = symbol;
+			}
+		}
+	}
+};
+
+static const HuffmanDecoder	g_huffman;
+
+/**
+ * Read an integer with an n-bit prefix (RFC 7541 5.1)
+ */
+static bool	decodeInteger(const unsigned char*& p, const unsigned char* end, 
+	int prefix, size_t& value)
+{
+	size_t mask = (1u << prefix) - 1;
+	
+	if (p >= end)
+		return false;
+	value = *p++ & mask;
+	if (value < mask)
+		return true;
+	for (int shift = 0; p < end; shift += 7)
+	{
+		// Nothing legitimate needs more than four continuation bytes
+		if (shift > 21)
+			return false;
+		value += static_cast<size_t>(*p & 0x7f) << shift;
+		if (!(*p++ & 0x80))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Decode a Huffman coded string (RFC 7541 5.2)
+ */
+static bool	decodeHuffman(const unsigned char* p, size_t length, 
+	std::string& out)
+{
+	unsigned int code = 0;
+	unsigned int bits = 0;
+	
+	for (size_t i = 0; i < length; i++)
+	{
+		for (int bit = 7; bit >= 0; bit--)
+		{
+			code = (code << 1) | ((p[i] >> bit) & 1);
+			bits++;
+			if (bits > HUFFMAN_MAX_BITS)
+				return false;
+			if (code - g_huffman.first[bits] >= g_huffman.count[bits])
+				continue;
+			
+			unsigned int symbol = g_huffman.symbols[g_huffman.offset[bits] + 
+				code - g_huffman.first[bits]];
+			
+			if (symbol == HUFFMAN_EOS)
+				return false;
+			out += static_cast<char>(symbol);
+			code = 0;
+			bits = 0;
+		}
+	}
+	// Padding is the shortest possible prefix of EOS: up to 7 one bits
+	return bits < 8 && code == (1u << bits) - 1;
+}
+
+/**
+ * Read a string literal, Huffman coded or not (RFC 7541 5.2)
+ */
+static bool	decodeString(const unsigned char*& p, const unsigned char* end, 
+	std::string& out)
+{
+	if (p >= end)
+		return false;
+	
+	bool huffman = (*p & 0x80) != 0;
+	size_t length;
+	
+	if (!decodeInteger(p, end, 7, length) || 
+		length > static_cast<size_t>(end - p))
+		return false;
+	out.clear();
+	if (huffman)
+	{
+		if (!decodeHuffman(p, length, out))
+			return false;
+	}
+	else
+		out.assign(reinterpret_cast<const char*>(p), length);
+	p += length;
+	return true;
+}
+
+/**
+ * Append an integer with an n-bit prefix, the prefix byte carrying flags
+ */
+static void	encodeInteger(size_t value, int prefix, unsigned char flags, 
+	std::string& out)
+{
+	size_t mask = (1u << prefix) - 1;
+	
+	if (value < mask)
+	{
+		out += static_cast<char>(flags | value);
+		return;
+	}
+	out += static_cast<char>(flags | mask);
+	value -= mask;
+	while (value >= 0x80)
+	{
+		out += static_cast<char>((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	out += static_cast<char>(value);
+}
+
+/**
+ * Append a string literal without Huffman coding
+ */
+static void	encodeString(const std::string& value, std::string& out)
+{
+	encodeInteger(value.size(), 7, 0x00, out);
+	out += value;
+}
+
+/**
+ * Default constructor, a 4096 byte table as the protocol starts with
+ */
+Hpack::Hpack(void) : _tableSize(0), _maxTableSize(DEFAULT_TABLE_SIZE), 
+	_tableSizeLimit(DEFAULT_TABLE_SIZE)
+{
+}
+
+/**
+ * Copy constructor
+ */
+Hpack::Hpack(const Hpack& other) : _table(other._table), 
+	_tableSize(other._tableSize), _maxTableSize(other._maxTableSize), 
+	_tableSizeLimit(other._tableSizeLimit)
+{
+}
+
+/**
+ * Destructor
+ */
+Hpack::~Hpack(void)
+{
+}
+
+/**
+ * Assignment operator
+ */
+Hpack&	Hpack::operator=(const Hpack& other)
+{
+	if (this != &other)
+	{
+		_table = other._table;
+		_tableSize = other._tableSize;
+		_maxTableSize = other._maxTableSize;
+		_tableSizeLimit = other._tableSizeLimit;
+	}
+	return *this;
+}
+
+/**
+ * Get the field at an index of the static or dynamic table
+ */
+bool	Hpack::lookup(size_t index, HeaderField& field) const
+{
+	if (index == 0)
+		return false;
+	if (index <= STATIC_TABLE_SIZE)
+	{
+		field.first = STATIC_TABLE[index - 1][0];
+		field.second = STATIC_TABLE[index - 1][1];
+		return true;
+	}
+	index -= STATIC_TABLE_SIZE + 1;
+	if (index >= _table.size())
+		return false;
+	field = _table[index];
+	return true;
+}
+
+/**
+ * Drop the oldest entries until the table fits in size bytes
+ */
+void	Hpack::evict(size_t size)
+{
+	while (_tableSize > size && !_table.empty())
+	{
+		const HeaderField& oldest = _table.back();
+		
+		_tableSize -= 32 + oldest.first.size() + oldest.second.size();
+		_table.pop_back();
+	}
+}
+
+/**
+ * Add a field to the dynamic table, evicting the oldest as needed
+ */
+void	Hpack::insert(const HeaderField& field)
+{
+	// Each entry also costs 32 bytes of overhead (RFC 7541 4.1)
+	size_t size = 32 + field.first.size() + field.second.size();
+	
+	if (size > _maxTableSize)
+	{
+		evict(0);
+		return;
+	}
+	evict(_maxTableSize - size);
+	_table.push_front(field);
+	_tableSize += size;
+}
+
+/**
+ * Decode a complete header block, false on a compression error,
+ * which is fatal to the connection
+ */
+bool	Hpack::decode(const char* data, size_t length, 
+	std::vector<HeaderField>& fields)
+{
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+	const unsigned char* end = p + length;
+	bool fieldSeen = false;
+	size_t decoded = 0;
+	
+	fields.clear();
+	while (p < end)
+	{
+		HeaderField field;
+		size_t index;
+		
+		if (*p & 0x80)
+		{
+			// Indexed field (6.1)
+			if (!decodeInteger(p, end, 7, index) || !lookup(index, field))
+				return false;
+		}
+		else if ((*p & 0xe0) == 0x20)
+		{
+			// Table size update (6.3), only before the first field
+			if (fieldSeen || !decodeInteger(p, end, 5, index) || 
+				index > _tableSizeLimit)
+				return false;
+			_maxTableSize = index;
+			evict(_maxTableSize);
+			continue;
+		}
+		else
+		{
+			// Literal (6.2): with incremental indexing, without indexing,
+			// or never indexed; the name is indexed or a literal
+			bool indexing = (*p & 0xc0) == 0x40;
+			int prefix = indexing ? 6 : 4;
+			
+			if (!decodeInteger(p, end, prefix, index))
+				return false;
+			if (index != 0)
+			{
+				if (!lookup(index, field))
+					return false;
+			}
+			else if (!decodeString(p, end, field.first))
+				return false;
+			if (!decodeString(p, end, field.second))
+				return false;
+			if (indexing)
+				insert(field);
+		}
+		fieldSeen = true;
+		decoded += 32 + field.first.size() + field.second.size();
+		if (decoded > MAX_DECODED_SIZE)
+			return false;
+		fields.push_back(field);
+	}
+	return true;
+}
+
+/**
+ * Append the encoding of a status pseudo-header
+ */
+void	Hpack::encodeStatus(int statusCode, std::string& out)
+{
+	char status[16];
+	
+	snprintf(status, sizeof(status), "%d", statusCode);
+	
+	// The common ones are a single indexed byte
+	for (size_t i = 7; i < 14; i++)
+	{
+		if (strcmp(STATIC_TABLE[i][1], status) == 0)
+		{
+			encodeInteger(i + 1, 7, 0x80, out);
+			return;
+		}
+	}
+	encode(":status", status, out);
+}
+
+/**
+ * Append the encoding of a field (name in lowercase)
+ */
+void	Hpack::encode(const std::string& name, const std::string& value, 
+	std::string& out)
+{
+	// Literal without indexing (6.2.2), the name from the static table
+	// when it is there
+	for (size_t i = 0; i < STATIC_TABLE_SIZE; i++)
+	{
+		if (name == STATIC_TABLE[i][0])
+		{
+			encodeInteger(i + 1, 4, 0x00, out);
+			encodeString(value, out);
+			return;
+		}
+	}
+	out += static_cast<char>(0x00);
+	encodeString(name, out);
+	encodeString(value, out);
+}
@@ -0,0 +1,1153 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Http2Session.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/20 15:40:12 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/20 15:40:12 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Http2Session.hpp"
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+	const char		CLIENT_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+	const size_t	CLIENT_PREFACE_LENGTH = 24;
+	const size_t	FRAME_HEADER_LENGTH = 9;
+	const size_t	DEFAULT_FRAME_SIZE = 16384;  // ours, never raised
+	const int64_t	DEFAULT_WINDOW = 65535;
+	const int64_t	MAX_WINDOW = 0x7fffffff;
+	const int64_t	RECEIVE_WINDOW = 1048576;  // advertised per stream and 
+	                                           // for the connection
+	const size_t	MAX_STREAMS = 100;
+	const size_t	MAX_HEADER_BLOCK = 65536;
+	const size_t	MAX_OUTPUT = 262144;  // queued DATA before waiting
+	const size_t	READ_SIZE = 65536;
+	const size_t	READ_BUDGET = 262144;
+	
+	const uint8_t	FLAG_END_STREAM = 0x1;
+	const uint8_t	FLAG_ACK = 0x1;
+	const uint8_t	FLAG_END_HEADERS = 0x4;
+	const uint8_t	FLAG_PADDED = 0x8;
+	const uint8_t	FLAG_PRIORITY = 0x20;
+	
+	const uint16_t	SETTINGS_ENABLE_PUSH = 0x2;
+	const uint16_t	SETTINGS_MAX_CONCURRENT_STREAMS = 0x3;
+	const uint16_t	SETTINGS_INITIAL_WINDOW_SIZE = 0x4;
+	const uint16_t	SETTINGS_MAX_FRAME_SIZE = 0x5;
+	
+	/**
+	 * Read a big-endian 32-bit integer
+	 */
+	uint32_t	readUint32(const char* p)
+	{
+		const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+		
+		return (static_cast<uint32_t>(u[0]) << 24) | 
+			(static_cast<uint32_t>(u[1]) << 16) | 
+			(static_cast<uint32_t>(u[2]) << 8) | u[3];
+	}
+	
+	/**
+	 * Append a big-endian 32-bit integer
+	 */
+	void	writeUint32(std::string& out, uint32_t value)
+	{
+		out += static_cast<char>((value >> 24) & 0xff);
+		out += static_cast<char>((value >> 16) & 0xff);
+		out += static_cast<char>((value >> 8) & 0xff);
+		out += static_cast<char>(value & 0xff);
+	}
+	
+	/**
+	 * Append one SETTINGS parameter
+	 */
+	void	writeSetting(std::string& out, uint16_t id, uint32_t value)
+	{
+		out += static_cast<char>(id >> 8);
+		out += static_cast<char>(id & 0xff);
+		writeUint32(out, value);
+	}
+	
+	/**
+	 * Decode base64url without padding (RFC 7540 3.2.1)
+	 */
+	bool	decodeBase64Url(const std::string& text, std::string& out)
+	{
+		unsigned int bits = 0;
+		int count = 0;
+		
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			char c = text[i];
+			int value;
+			
+			if (c >= 'A' && c <= 'Z')
+				value = c - 'A';
+			else if (c >= 'a' && c <= 'z')
+				value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9')
+				value = c - '0' + 52;
+			else if (c == '-' || c == '+')
+				value = 62;
+			else if (c == '_' || c == '/')
+				value = 63;
+			else if (c == '=')
+				break;
+			else
+				return false;
+			bits = (bits << 6) | value;
+			count += 6;
+			if (count >= 8)
+			{
+				count -= 8;
+				out += static_cast<char>((bits >> count) & 0xff);
+			}
+		}
+		return true;
+	}
+	
+	/**
+	 * Check that a field can be written back as HTTP/1.1 text: lowercase
+	 * token names and values without line breaks (RFC 9113 8.2.1)
+	 */
+	bool	isValidField(const std::string& name, const std::string& value)
+	{
+		if (name.empty())
+			return false;
+		for (size_t i = 0; i < name.size(); ++i)
+		{
+			unsigned char c = name[i];
+			
+			if (c <= 0x20 || c >= 0x7f || (c >= 'A' && c <= 'Z') || 
+				(c == ':' && i > 0))
+				return false;
+		}
+		for (size_t i = 0; i < value.size(); ++i)
+		{
+			if (value[i] == '\r' || value[i] == '\n' || value[i] == '\0')
+				return false;
+		}
+		return true;
+	}
+	
+	/**
+	 * Check for the fields that only mean something to HTTP/1.1
+	 * connections (RFC 9113 8.2.2)
+	 */
+	bool	isConnectionField(const std::string& name)
+	{
+		return name == "connection" || name == "keep-alive" || 
+			name == "proxy-connection" || name == "transfer-encoding" || 
+			name == "upgrade";
+	}
+}
+
+/**
+ * Constructor for a connection accepted on a listener
+ */
+Http2Session::Http2Session(const Config& config, 
+	const VirtualHostTable* virtualHosts, OpenFileCache* fileCache, 
+	const struct sockaddr_in& clientAddr) : _config(config), 
+	_virtualHosts(virtualHosts), _fileCache(fileCache), _clientAddr(clientAddr), 
+	_lastStreamId(0), _blockStream(0), _blockEndStream(false), 
+	_prefaceReceived(false), _goingAway(false), _draining(false), 
+	_sendWindow(DEFAULT_WINDOW), _initialWindow(DEFAULT_WINDOW), 
+	_maxFrameSize(DEFAULT_FRAME_SIZE), _consumed(0), _answered(0)
+{
+}
+
+/**
+ * Destructor
+ */
+Http2Session::~Http2Session(void)
+{
+	for (std::map<uint32_t, Stream*>::iterator it = _streams.begin(); 
+		it != _streams.end(); ++it)
+		delete it->second;
+}
+
+/**
+ * Start a prior-knowledge connection: queue the server preface
+ */
+void	Http2Session::start(void)
+{
+	std::string settings;
+	
+	writeSetting(settings, SETTINGS_MAX_CONCURRENT_STREAMS, MAX_STREAMS);
+	writeSetting(settings, SETTINGS_INITIAL_WINDOW_SIZE, RECEIVE_WINDOW);
+	writeFrame(H2_SETTINGS, 0, 0, settings.data(), settings.size());
+	writeWindowUpdate(0, RECEIVE_WINDOW - DEFAULT_WINDOW);
+}
+
+/**
+ * Take over an HTTP/1.1 connection whose request asked for h2c
+ */
+bool	Http2Session::upgrade(const HttpRequest& request)
+{
+	static const char switching[] = "HTTP/1.1 101 Switching Protocols\r\n"
+		"Connection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+	std::string settings;
+	
+	if (!decodeBase64Url(request.getHeader(HEADER_HTTP2_SETTINGS), settings) || 
+		!applySettings(settings.data(), settings.size()))
+		return false;
+	
+	_output.append(switching, sizeof(switching) - 1);
+	start();
+	
+	// The request becomes stream 1, half-closed since it came whole
+	Stream* stream = new Stream();
+	stream->id = 1;
+	stream->request = request;
+	stream->request.setResponseCache(NULL);
+	stream->chunked = false;
+	stream->remoteClosed = true;
+	stream->responded = false;
+	stream->bodyLength = 0;
+	stream->bodySent = 0;
+	stream->sendWindow = _initialWindow;
+	stream->consumed = 0;
+	_streams[1] = stream;
+	_lastStreamId = 1;
+	
+	// Stream 1 is answered once the client preface is in: clients only
+	// buffer so much behind the 101 before they switch to frames
+	_logger.tempOss << "Upgraded connection from " 
+		<< ClientSocket::formatAddress(_clientAddr) << " to h2c";
+	_logger.debug();
+	return true;
+}
+
+/**
+ * Handle bytes that were received before the session took over
+ */
+void	Http2Session::receive(const char* data, size_t length)
+{
+	if (length == 0 || _goingAway)
+		return;
+	_input.append(data, length);
+	process();
+}
+
+/**
+ * Read and handle everything available on the socket
+ */
+bool	Http2Session::read(ClientSocket& clientSocket)
+{
+	size_t total = 0;
+	
+	while (total < READ_BUDGET)
+	{
+		ssize_t received = clientSocket.recv(_input.prepare(READ_SIZE), 
+			READ_SIZE);
+		
+		if (received < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			_logger.tempOss << "Error reading from socket: " << strerror(errno);
+			_logger.debug();
+			return false;
+		}
+		if (received == 0)
+			return false;
+		_input.commit(received);
+		total += received;
+		if (static_cast<size_t>(received) < READ_SIZE)
+			break;
+	}
+	
+	if (_goingAway)
+		_input.clear();
+	else
+		process();
+	return true;
+}
+
+/**
+ * Send queued frames until the socket is full
+ */
+bool	Http2Session::flush(ClientSocket& clientSocket)
+{
+	// Response bodies turn into frames only as the socket takes them,
+	// so a large file is never queued whole
+	while (true)
+	{
+		pump();
+		if (_output.empty())
+			return true;
+		
+		ssize_t sent = clientSocket.send(_output.data(), _output.size());
+		
+		if (sent < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return true;
+			_logger.tempOss << "Error sending frames: " << strerror(errno);
+			_logger.debug();
+			return false;
+		}
+		_output.consume(sent);
+		if (!_output.empty())
+			return true;
+	}
+}
+
+/**
+ * Check if frames are waiting to be sent, or could be
+ */
+bool	Http2Session::hasOutput(void) const
+{
+	if (!_output.empty())
+		return true;
+	if (_sendWindow <= 0)
+		return false;
+	for (std::map<uint32_t, Stream*>::const_iterator it = _streams.begin(); 
+		it != _streams.end(); ++it)
+	{
+		const Stream* stream = it->second;
+		
+		if (stream->responded && stream->bodySent < stream->bodyLength && 
+			stream->sendWindow > 0)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Check if any stream is open
+ */
+bool	Http2Session::hasStreams(void) const
+{
+	return !_streams.empty();
+}
+
+/**
+ * Get the number of requests answered on the connection
+ */
+unsigned long	Http2Session::getAnswered(void) const
+{
+	return _answered;
+}
+
+/**
+ * Check if the connection should close now
+ */
+bool	Http2Session::isFinished(void) const
+{
+	if (!_output.empty())
+		return false;
+	return _goingAway || (_draining && _streams.empty());
+}
+
+/**
+ * Refuse new streams with a graceful GOAWAY; the connection closes once
+ * the open streams are answered (RFC 9113 6.8)
+ */
+void	Http2Session::goAway(void)
+{
+	std::string payload;
+	
+	if (_goingAway || _draining)
+		return;
+	writeUint32(payload, _lastStreamId);
+	writeUint32(payload, H2_NO_ERROR);
+	writeFrame(H2_GOAWAY, 0, 0, payload.data(), payload.size());
+	_draining = true;
+}
+
+/**
+ * Parse every complete frame in the input
+ */
+void	Http2Session::process(void)
+{
+	if (!_prefaceReceived)
+	{
+		if (_input.size() < CLIENT_PREFACE_LENGTH)
+		{
+			if (memcmp(_input.data(), CLIENT_PREFACE, _input.size()) != 0)
+				fail(H2_PROTOCOL_ERROR, "invalid connection preface");
+			return;
+		}
+		if (memcmp(_input.data(), CLIENT_PREFACE, CLIENT_PREFACE_LENGTH) != 0)
+		{
+			fail(H2_PROTOCOL_ERROR, "invalid connection preface");
+			return;
+		}
+		_input.consume(CLIENT_PREFACE_LENGTH);
+		_prefaceReceived = true;
+		
+		Stream* upgraded = findStream(1);
+		
+		if (upgraded && !upgraded->responded)
+			respond(upgraded);
+	}
+	
+	while (!_goingAway && _input.size() >= FRAME_HEADER_LENGTH)
+	{
+		const unsigned char* header = 
+			reinterpret_cast<const unsigned char*>(_input.data());
+		size_t length = (static_cast<size_t>(header[0]) << 16) | 
+			(static_cast<size_t>(header[1]) << 8) | header[2];
+		uint8_t type = header[3];
+		uint8_t flags = header[4];
+		uint32_t streamId = readUint32(_input.data() + 5) & 0x7fffffff;
+		
+		if (length > DEFAULT_FRAME_SIZE)
+		{
+			fail(H2_FRAME_SIZE_ERROR, "frame larger than advertised");
+			break;
+		}
+		if (_input.size() < FRAME_HEADER_LENGTH + length)
+			break;
+		
+		bool ok = handleFrame(type, flags, streamId, 
+			_input.data() + FRAME_HEADER_LENGTH, length);
+		
+		_input.consume(FRAME_HEADER_LENGTH + length);
+		if (!ok)
+			break;
+	}
+	if (_goingAway)
+		_input.clear();
+}
+
+/**
+ * Handle one frame, false once the connection is failing
+ */
+bool	Http2Session::handleFrame(uint8_t type, uint8_t flags, 
+	uint32_t streamId, const char* payload, size_t length)
+{
+	// Nothing may come between the frames of a header block
+	if (_blockStream != 0 && 
+		(type != H2_CONTINUATION || streamId != _blockStream))
+		return fail(H2_PROTOCOL_ERROR, "header block interrupted");
+	
+	switch (type)
+	{
+		case H2_DATA:
+			return handleData(flags, streamId, payload, length);
+		case H2_HEADERS:
+		case H2_CONTINUATION:
+			return handleHeaders(type, flags, streamId, payload, length);
+		case H2_PRIORITY:
+			if (streamId == 0)
+				return fail(H2_PROTOCOL_ERROR, "PRIORITY on stream 0");
+			if (length != 5)
+				resetStream(streamId, H2_FRAME_SIZE_ERROR);
+			return true;
+		case H2_RST_STREAM:
+			if (length != 4)
+				return fail(H2_FRAME_SIZE_ERROR, "bad RST_STREAM length");
+			if (streamId == 0 || streamId > _lastStreamId)
+				return fail(H2_PROTOCOL_ERROR, "RST_STREAM on idle stream");
+			closeStream(streamId);
+			return true;
+		case H2_SETTINGS:
+			return handleSettings(flags, streamId, payload, length);
+		case H2_PUSH_PROMISE:
+			return fail(H2_PROTOCOL_ERROR, "PUSH_PROMISE from a client");
+		case H2_PING:
+			if (streamId != 0)
+				return fail(H2_PROTOCOL_ERROR, "PING on a stream");
+			if (length != 8)
+				return fail(H2_FRAME_SIZE_ERROR, "bad PING length");
+			if (!(flags & FLAG_ACK))
+				writeFrame(H2_PING, FLAG_ACK, 0, payload, length);
+			return true;
+		case H2_GOAWAY:
+			if (streamId != 0)
+				return fail(H2_PROTOCOL_ERROR, "GOAWAY on a stream");
+			_draining = true;
+			return true;
+		case H2_WINDOW_UPDATE:
+			return handleWindowUpdate(streamId, payload, length);
+		default:
+			// Unknown frame types are ignored (RFC 9113 5.5)
+			return true;
+	}
+}
+
+/**
+ * Handle a SETTINGS frame
+ */
+bool	Http2Session::handleSettings(uint8_t flags, uint32_t streamId, 
+	const char* payload, size_t length)
+{
+	if (streamId != 0)
+		return fail(H2_PROTOCOL_ERROR, "SETTINGS on a stream");
+	if (flags & FLAG_ACK)
+	{
+		if (length != 0)
+			return fail(H2_FRAME_SIZE_ERROR, "SETTINGS ACK with a payload");
+		return true;
+	}
+	if (!applySettings(payload, length))
+		return false;
+	writeFrame(H2_SETTINGS, FLAG_ACK, 0, NULL, 0);
+	return true;
+}
+
+/**
+ * Apply settings sent by the peer
+ */
+bool	Http2Session::applySettings(const char* payload, size_t length)
+{
+	if (length % 6 != 0)
+		return fail(H2_FRAME_SIZE_ERROR, "bad SETTINGS length");
+	
+	for (size_t offset = 0; offset < length; offset += 6)
+	{
+		const unsigned char* p = 
+			reinterpret_cast<const unsigned char*>(payload + offset);
+		uint16_t id = static_cast<uint16_t>((p[0] << 8) | p[1]);
+		uint32_t value = readUint32(payload + offset + 2);
+		
+		if (id == SETTINGS_ENABLE_PUSH && value > 1)
+			return fail(H2_PROTOCOL_ERROR, "bad SETTINGS_ENABLE_PUSH");
+		if (id == SETTINGS_INITIAL_WINDOW_SIZE)
+		{
+			if (value > MAX_WINDOW)
+				return fail(H2_FLOW_CONTROL_ERROR, "window size too large");
+			
+			// Open streams move by the difference (RFC 9113 6.9.2)
+			int64_t delta = static_cast<int64_t>(value) - _initialWindow;
+			
+			for (std::map<uint32_t, Stream*>::iterator it = _streams.begin(); 
+				it != _streams.end(); ++it)
+			{
+				it->second->sendWindow += delta;
+				if (it->second->sendWindow > MAX_WINDOW)
+					return fail(H2_FLOW_CONTROL_ERROR, "window overflow");
+			}
+			_initialWindow = value;
+		}
+		if (id == SETTINGS_MAX_FRAME_SIZE)
+		{
+			if (value < DEFAULT_FRAME_SIZE || value > 0xffffff)
+				return fail(H2_PROTOCOL_ERROR, "bad SETTINGS_MAX_FRAME_SIZE");
+			_maxFrameSize = value;
+		}
+	}
+	return true;
+}
+
+/**
+ * Handle a HEADERS or CONTINUATION frame
+ */
+bool	Http2Session::handleHeaders(uint8_t type, uint8_t flags, 
+	uint32_t streamId, const char* payload, size_t length)
+{
+	if (streamId == 0 || (streamId & 1) == 0)
+		return fail(H2_PROTOCOL_ERROR, "HEADERS on a server stream");
+	
+	if (type == H2_CONTINUATION)
+	{
+		if (_blockStream == 0)
+			return fail(H2_PROTOCOL_ERROR, "unexpected CONTINUATION");
+	}
+	else
+	{
+		size_t padding = 0;
+		
+		if (flags & FLAG_PADDED)
+		{
+			if (length < 1)
+				return fail(H2_FRAME_SIZE_ERROR, "bad HEADERS padding");
+			padding = static_cast<unsigned char>(payload[0]);
+			payload++;
+			length--;
+		}
+		if (flags & FLAG_PRIORITY)
+		{
+			if (length < 5)
+				return fail(H2_FRAME_SIZE_ERROR, "bad HEADERS priority");
+			payload += 5;
+			length -= 5;
+		}
+		if (padding > length)
+			return fail(H2_PROTOCOL_ERROR, "padding exceeds HEADERS");
+		length -= padding;
+		_blockStream = streamId;
+		_blockEndStream = (flags & FLAG_END_STREAM) != 0;
+		_headerBlock.clear();
+	}
+	
+	if (_headerBlock.size() + length > MAX_HEADER_BLOCK)
+		return fail(H2_ENHANCE_YOUR_CALM, "header block too large");
+	_headerBlock.append(payload, length);
+	if (!(flags & FLAG_END_HEADERS))
+		return true;
+	return finishHeaderBlock();
+}
+
+/**
+ * Decode a complete header block and start or finish its request
+ */
+bool	Http2Session::finishHeaderBlock(void)
+{
+	std::vector<HeaderField> fields;
+	uint32_t streamId = _blockStream;
+	
+	_blockStream = 0;
+	// Every block goes through the decoder, even for a refused stream,
+	// or its dynamic table would drift from the peer's
+	if (!_decoder.decode(_headerBlock.data(), _headerBlock.size(), fields))
+		return fail(H2_COMPRESSION_ERROR, "HPACK decoding failed");
+	
+	Stream* stream = findStream(streamId);
+	
+	if (stream)
+	{
+		// A second block on a stream carries trailers, which end it
+		if (stream->remoteClosed || !_blockEndStream)
+		{
+			resetStream(streamId, H2_PROTOCOL_ERROR);
+			return true;
+		}
+		finishBody(stream);
+		return true;
+	}
+	
+	if (streamId <= _lastStreamId)
+	{
+		resetStream(streamId, H2_STREAM_CLOSED);
+		return true;
+	}
+	_lastStreamId = streamId;
+	if (_draining || _streams.size() >= MAX_STREAMS)
+	{
+		resetStream(streamId, H2_REFUSED_STREAM);
+		return true;
+	}
+	
+	stream = new Stream();
+	stream->id = streamId;
+	stream->chunked = false;
+	stream->remoteClosed = _blockEndStream;
+	stream->responded = false;
+	stream->bodyLength = 0;
+	stream->bodySent = 0;
+	stream->sendWindow = _initialWindow;
+	stream->consumed = 0;
+	_streams[streamId] = stream;
+	
+	std::string head;
+	
+	if (!buildHead(stream, fields, head))
+	{
+		resetStream(streamId, H2_PROTOCOL_ERROR);
+		return true;
+	}
+	stream->request.setVirtualHosts(_virtualHosts);
+	stream->request.setFileCache(_fileCache);
+	stream->request.setClientAddress(_clientAddr);
+	
+	_logger.tempOss << "Stream " << streamId << " opened";
+	_logger.debug();
+	if (stream->request.feed(head.data(), head.size()))
+		respond(stream);
+	else if (stream->remoteClosed)
+		finishBody(stream);
+	return true;
+}
+
+/**
+ * Rebuild the HTTP/1.1 head of a request from its header fields
+ */
+bool	Http2Session::buildHead(Stream* stream, 
+	const std::vector<HeaderField>& fields, std::string& head)
+{
+	std::string method;
+	std::string path;
+	std::string authority;
+	std::string cookie;
+	std::string headers;
+	bool scheme = false;
+	bool regular = false;
+	bool hasLength = false;
+	
+	for (size_t i = 0; i < fields.size(); ++i)
+	{
+		const std::string& name = fields[i].first;
+		const std::string& value = fields[i].second;
+		
+		if (!isValidField(name, value))
+			return false;
+		if (name[0] == ':')
+		{
+			// Pseudo-headers come first, once each
+			if (regular)
+				return false;
+			if (name == ":method" && method.empty())
+				method = value;
+			else if (name == ":path" && path.empty())
+				path = value;
+			else if (name == ":authority" && authority.empty())
+				authority = value;
+			else if (name == ":scheme" && !scheme)
+				scheme = true;
+			else
+				return false;
+			continue;
+		}
+		regular = true;
+		if (isConnectionField(name) || (name == "te" && value != "trailers"))
+			return false;
+		if (name == "cookie")
+		{
+			// Split cookies are joined back for HTTP/1.1 (RFC 9113 8.2.3)
+			if (!cookie.empty())
+				cookie += "; ";
+			cookie += value;
+			continue;
+		}
+		if (name == "host")
+		{
+			if (authority.empty())
+				authority = value;
+			continue;
+		}
+		if (name == "content-length")
+		{
+			if (stream->remoteClosed)
+				continue;
+			hasLength = true;
+		}
+		headers += name + ": " + value + "\r\n";
+	}
+	
+	if (method.empty() || path.empty() || !scheme)
+		return false;
+	for (size_t i = 0; i < path.size(); ++i)
+	{
+		if (path[i] == ' ')
+			return false;
+	}
+	
+	head = method + " " + path + " HTTP/1.1\r\n";
+	if (!authority.empty())
+		head += "host: " + authority + "\r\n";
+	if (!cookie.empty())
+		head += "cookie: " + cookie + "\r\n";
+	head += headers;
+	
+	// A body of unknown length is framed by DATA frames, which the
+	// parser reads as chunks
+	if (!stream->remoteClosed && !hasLength)
+	{
+		head += "transfer-encoding: chunked\r\n";
+		stream->chunked = true;
+	}
+	head += "\r\n";
+	return true;
+}
+
+/**
+ * Handle a DATA frame
+ */
+bool	Http2Session::handleData(uint8_t flags, uint32_t streamId, 
+	const char* payload, size_t length)
+{
+	if (streamId == 0 || streamId > _lastStreamId)
+		return fail(H2_PROTOCOL_ERROR, "DATA on an idle stream");
+	
+	// The whole frame, padding included, counts against the windows
+	_consumed += length;
+	if (_consumed > static_cast<size_t>(RECEIVE_WINDOW))
+		return fail(H2_FLOW_CONTROL_ERROR, "connection window exceeded");
+	if (_consumed >= static_cast<size_t>(RECEIVE_WINDOW / 2))
+	{
+		writeWindowUpdate(0, _consumed);
+		_consumed = 0;
+	}
+	
+	Stream* stream = findStream(streamId);
+	
+	// Frames still in flight after a reset are dropped
+	if (!stream)
+		return true;
+	if (stream->remoteClosed)
+	{
+		resetStream(streamId, H2_STREAM_CLOSED);
+		return true;
+	}
+	stream->consumed += length;
+	if (stream->consumed > static_cast<size_t>(RECEIVE_WINDOW))
+	{
+		resetStream(streamId, H2_FLOW_CONTROL_ERROR);
+		return true;
+	}
+	
+	size_t padding = 0;
+	
+	if (flags & FLAG_PADDED)
+	{
+		if (length < 1)
+			return fail(H2_FRAME_SIZE_ERROR, "bad DATA padding");
+		padding = static_cast<unsigned char>(payload[0]);
+		payload++;
+		length--;
+		if (padding > length)
+			return fail(H2_PROTOCOL_ERROR, "padding exceeds DATA");
+		length -= padding;
+	}
+	
+	if (flags & FLAG_END_STREAM)
+		stream->remoteClosed = true;
+	if (!stream->responded)
+	{
+		feedBody(stream, payload, length);
+		// Answering may have finished the stream already
+		if (!(stream = findStream(streamId)))
+			return true;
+		if (stream->remoteClosed && !stream->responded)
+		{
+			finishBody(stream);
+			return true;
+		}
+	}
+	if (!stream->remoteClosed && 
+		stream->consumed >= static_cast<size_t>(RECEIVE_WINDOW / 2))
+	{
+		writeWindowUpdate(streamId, stream->consumed);
+		stream->consumed = 0;
+	}
+	return true;
+}
+
+/**
+ * Handle a WINDOW_UPDATE frame
+ */
+bool	Http2Session::handleWindowUpdate(uint32_t streamId, 
+	const char* payload, size_t length)
+{
+	if (length != 4)
+		return fail(H2_FRAME_SIZE_ERROR, "bad WINDOW_UPDATE length");
+	
+	int64_t increment = readUint32(payload) & 0x7fffffff;
+	
+	if (streamId == 0)
+	{
+		if (increment == 0)
+			return fail(H2_PROTOCOL_ERROR, "zero window increment");
+		_sendWindow += increment;
+		if (_sendWindow > MAX_WINDOW)
+			return fail(H2_FLOW_CONTROL_ERROR, "connection window overflow");
+		return true;
+	}
+	
+	Stream* stream = findStream(streamId);
+	
+	if (!stream)
+	{
+		if (streamId > _lastStreamId)
+			return fail(H2_PROTOCOL_ERROR, "WINDOW_UPDATE on an idle stream");
+		return true;
+	}
+	if (increment == 0)
+		resetStream(streamId, H2_PROTOCOL_ERROR);
+	else if ((stream->sendWindow += increment) > MAX_WINDOW)
+		resetStream(streamId, H2_FLOW_CONTROL_ERROR);
+	return true;
+}
+
+/**
+ * Feed part of a request body to the stream's parser
+ */
+void	Http2Session::feedBody(Stream* stream, const char* data, size_t length)
+{
+	bool complete;
+	
+	if (length == 0)
+		return;
+	if (stream->chunked)
+	{
+		std::ostringstream size;
+		std::string chunk;
+		
+		size << std::hex << length << "\r\n";
+		chunk.reserve(size.str().size() + length + 2);
+		chunk = size.str();
+		chunk.append(data, length);
+		chunk += "\r\n";
+		complete = stream->request.feed(chunk.data(), chunk.size());
+	}
+	else
+		complete = stream->request.feed(data, length);
+	
+	// Done early: rejected, or the declared length was reached
+	if (complete)
+		respond(stream);
+}
+
+/**
+ * Mark the end of a request body
+ */
+void	Http2Session::finishBody(Stream* stream)
+{
+	static const char lastChunk[] = "0\r\n\r\n";
+	
+	stream->remoteClosed = true;
+	if (stream->responded)
+		return;
+	if (stream->chunked && stream->request.feed(lastChunk, 
+		sizeof(lastChunk) - 1))
+	{
+		respond(stream);
+		return;
+	}
+	// A body shorter than its Content-Length is malformed
+	_logger.tempOss << "Stream " << stream->id << " ended before its request";
+	_logger.debug();
+	resetStream(stream->id, H2_PROTOCOL_ERROR);
+}
+
+/**
+ * Run the handlers for a complete request and queue the response
+ */
+void	Http2Session::respond(Stream* stream)
+{
+	HttpResponse& response = stream->response;
+	std::string block;
+	
+	response = stream->request.process(_config);	
+	response.addDefaultHeaders();
+	Hpack::encodeStatus(response.getStatusCode(), block);
+	
+	const std::map<std::string, std::string>& headers = response.getHeaders();
+	
+	for (std::map<std::string, std::string>::const_iterator it = 
+		headers.begin(); it != headers.end(); ++it)
+	{
+		std::string name = it->first;
+		
+		for (size_t i = 0; i < name.size(); ++i)
+			name[i] = static_cast<char>(std::tolower(
+				static_cast<unsigned char>(name[i])));
+		if (!isConnectionField(name))
+			Hpack::encode(name, it->second, block);
+	}
+	
+	stream->bodyLength = response.getBodyLength();
+	stream->bodySent = 0;
+	stream->responded = true;
+	_answered++;
+	
+	// The block is split to the peer's frame size, HEADERS first
+	bool empty = stream->bodyLength == 0;
+	size_t offset = 0;
+	
+	do
+	{
+		size_t length = block.size() - offset;
+		uint8_t flags = 0;
+		
+		if (length > _maxFrameSize)
+			length = _maxFrameSize;
+		if (offset + length == block.size())
+			flags |= FLAG_END_HEADERS;
+		if (offset == 0 && empty)
+			flags |= FLAG_END_STREAM;
+		writeFrame(offset == 0 ? H2_HEADERS : H2_CONTINUATION, flags, 
+			stream->id, block.data() + offset, length);
+		offset += length;
+	}
+	while (offset < block.size());
+	
+	_logger.tempOss << "Stream " << stream->id << " answered with " 
+		<< response.getStatusCode();
+	_logger.debug();
+	if (empty)
+	{
+		if (stream->remoteClosed)
+			closeStream(stream->id);
+		else
+			resetStream(stream->id, H2_NO_ERROR);
+	}
+}
+
+/**
+ * Queue DATA frames for pending response bodies, within the windows
+ */
+void	Http2Session::pump(void)
+{
+	bool progress = true;
+	
+	// One frame per stream per pass, so concurrent responses share the
+	// connection instead of waiting on each other
+	while (progress && _sendWindow > 0 && _output.size() < MAX_OUTPUT)
+	{
+		std::vector<uint32_t> finished;
+		std::vector<uint32_t> failed;
+		
+		progress = false;
+		for (std::map<uint32_t, Stream*>::iterator it = _streams.begin(); 
+			it != _streams.end() && _sendWindow > 0; ++it)
+		{
+			Stream* stream = it->second;
+			size_t remaining = stream->bodyLength - stream->bodySent;
+			
+			if (!stream->responded || remaining == 0 || stream->sendWindow <= 0)
+				continue;
+			
+			size_t length = remaining;
+			
+			if (length > _maxFrameSize)
+				length = _maxFrameSize;
+			if (static_cast<int64_t>(length) > stream->sendWindow)
+				length = stream->sendWindow;
+			if (static_cast<int64_t>(length) > _sendWindow)
+				length = _sendWindow;
+			
+			bool last = length == remaining;
+			char* payload = prepareFrame(H2_DATA, last ? FLAG_END_STREAM : 0, 
+				stream->id, length);
+			
+			// File bodies are read straight into the frame
+			if (stream->response.readBody(stream->bodySent, payload, length) 
+				!= static_cast<ssize_t>(length))
+			{
+				_logger.tempOss << "Stream " << stream->id 
+					<< " body could not be read";
+				_logger.error();
+				failed.push_back(stream->id);
+				continue;
+			}
+			_output.commit(FRAME_HEADER_LENGTH + length);
+			stream->bodySent += length;
+			stream->sendWindow -= length;
+			_sendWindow -= length;
+			progress = true;
+			if (last)
+				finished.push_back(stream->id);
+		}
+		
+		for (size_t i = 0; i < failed.size(); ++i)
+			resetStream(failed[i], H2_INTERNAL_ERROR);
+		for (size_t i = 0; i < finished.size(); ++i)
+		{
+			Stream* stream = findStream(finished[i]);
+			
+			if (stream->remoteClosed)
+				closeStream(finished[i]);
+			else
+				resetStream(finished[i], H2_NO_ERROR);
+		}
+	}
+}
+
+/**
+ * Forget a stream
+ */
+void	Http2Session::closeStream(uint32_t streamId)
+{
+	std::map<uint32_t, Stream*>::iterator it = _streams.find(streamId);
+	
+	if (it == _streams.end())
+		return;
+	delete it->second;
+	_streams.erase(it);
+}
+
+/**
+ * Find an open stream, NULL if there is none
+ */
+Http2Session::Stream*	Http2Session::findStream(uint32_t streamId) const
+{
+	std::map<uint32_t, Stream*>::const_iterator it = _streams.find(streamId);
+	
+	if (it == _streams.end())
+		return NULL;
+	return it->second;
+}
+
+/**
+ * Queue a frame
+ */
+void	Http2Session::writeFrame(uint8_t type, uint8_t flags, uint32_t streamId, 
+	const char* payload, size_t length)
+{
+	char* room = prepareFrame(type, flags, streamId, length);
+	
+	if (length > 0)
+		memcpy(room, payload, length);
+	_output.commit(FRAME_HEADER_LENGTH + length);
+}
+
+/**
+ * Write a frame header into the output's free space and get room for
+ * its payload; the frame is queued by committing both
+ */
+char*	Http2Session::prepareFrame(uint8_t type, uint8_t flags, 
+	uint32_t streamId, size_t length)
+{
+	char* header = _output.prepare(FRAME_HEADER_LENGTH + length);
+	
+	header[0] = static_cast<char>((length >> 16) & 0xff);
+	header[1] = static_cast<char>((length >> 8) & 0xff);
+	header[2] = static_cast<char>(length & 0xff);
+	header[3] = static_cast<char>(type);
+	header[4] = static_cast<char>(flags);
+	header[5] = static_cast<char>((streamId >> 24) & 0x7f);
+	header[6] = static_cast<char>((streamId >> 16) & 0xff);
+	header[7] = static_cast<char>((streamId >> 8) & 0xff);
+	header[8] = static_cast<char>(streamId & 0xff);
+	return header + FRAME_HEADER_LENGTH;
+}
+
+/**
+ * Queue a WINDOW_UPDATE frame
+ */
+void	Http2Session::writeWindowUpdate(uint32_t streamId, uint32_t increment)
+{
+	std::string payload;
+	
+	writeUint32(payload, increment & 0x7fffffff);
+	writeFrame(H2_WINDOW_UPDATE, 0, streamId, payload.data(), payload.size());
+}
+
+/**
+ * Queue a RST_STREAM frame and forget the stream
+ */
+void	Http2Session::resetStream(uint32_t streamId, Http2Error error)
+{
+	std::string payload;
+	
+	writeUint32(payload, error);
+	writeFrame(H2_RST_STREAM, 0, streamId, payload.data(), payload.size());
+	closeStream(streamId);
+}
+
+/**
+ * Queue a GOAWAY frame; the connection closes once it is sent
+ */
+bool	Http2Session::fail(Http2Error error, const char* reason)
+{
+	std::string payload;
+	
+	_logger.tempOss << "HTTP/2 connection error " << error << ": " << reason;
+	_logger.debug();
+	writeUint32(payload, _lastStreamId);
+	writeUint32(payload, error);
+	writeFrame(H2_GOAWAY, 0, 0, payload.data(), payload.size());
+	
+	for (std::map<uint32_t, Stream*>::iterator it = _streams.begin(); 
+		it != _streams.end(); ++it)
+		delete it->second;
+	_streams.clear();
+	_goingAway = true;
+	return false;
+}
@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HttpDate.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/26 11:20:44 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/26 11:20:44 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "HttpDate.hpp"
+#include <cstring>
+
+/**
+ * Accepted forms, the preferred one first
+ */
+static const char*	DATE_FORMATS[] = {
+	"%a, %d %b %Y %H:%M:%S GMT",  // IMF-fixdate
+	"%A, %d-%b-%y %H:%M:%S GMT",  // RFC 850
+	"%a %b %e %H:%M:%S %Y"        // asctime()
+};
+
+/**
+ * Format a time as IMF-fixdate (Sun, 06 Nov 1994 08:49:37 GMT)
+ */
+std::string	HttpDate::format(time_t time)
+{
+	char buffer[64];
+	struct tm tm;
+	
+	gmtime_r(&time, &tm);
+	strftime(buffer, sizeof(buffer), DATE_FORMATS[0], &tm);
+	return std::string(buffer);
+}
+
+/**
+ * Parse an HTTP-date in any of its three forms, false if it is not one
+ */
+bool	HttpDate::parse(const std::string& value, time_t& time)
+{
+	for (size_t i = 0; i < sizeof(DATE_FORMATS) / sizeof(DATE_FORMATS[0]); ++i)
+	{
+		struct tm tm;
+		
+		memset(&tm, 0, sizeof(tm));
+		
+		const char* end = strptime(value.c_str(), DATE_FORMATS[i], &tm);
+		
+		if (end && *end == '\0')
+		{
+			time = timegm(&tm);
+			return time != static_cast<time_t>(-1);
+		}
+	}
+	return false;
+}
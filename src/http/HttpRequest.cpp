@@ -11,25 +11,92 @@
 /* ************************************************************************** */
 
 #include "HttpRequest.hpp"
+#include "HttpDate.hpp"
 #include "CgiHandler.hpp"
+#include "CharScanner.hpp"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
 #include <iostream>
 #include <cstring>
+#include <strings.h>
 #include <cerrno>
 #include <fstream>
 #include <ctime>
 #include <dirent.h>
 #include <sys/stat.h>
 
+/**
+ * Limits on the parts of a request kept in memory before the body
+ */
+static const size_t	MAX_HEAD_SIZE = 32768;
+static const size_t	MAX_CHUNK_LINE = 4096;
+
+/**
+ * Limits of one read() call: the receive size adapts between the two
+ * bounds, the budget keeps one fast client from starving the others
+ */
+static const size_t	MIN_RECV_SIZE = 4096;
+static const size_t	MAX_RECV_SIZE = 65536;
+static const size_t	READ_BUDGET = 262144;
+
+/**
+ * Most parse buffer and arena memory an idle connection keeps; a request
+ * that needed more allocates it again
+ */
+static const size_t	IDLE_BUFFER_SIZE = 16384;
+static const size_t	IDLE_ARENA_SIZE = 4096;
+
+/**
+ * Files up to this size are read into the response, so their body
+ * leaves with the head in one write; larger ones go out with sendfile()
+ */
+static const size_t	INLINE_FILE_SIZE = 16384;
+
+/**
+ * Most ranges honoured in one Range header; more than that is ignored
+ * and the whole file is sent, as a defence against tiny overlapping
+ * ranges
+ */
+static const size_t	MAX_RANGES = 16;
+
+/**
+ * Handlers indexed by HttpMethod, NULL for methods not implemented
+ */
+const HttpRequest::MethodHandler	HttpRequest::_handlers[METHOD_COUNT] = {
+	&HttpRequest::handleGet,     // GET
+	NULL,                        // HEAD
+	&HttpRequest::handlePost,    // POST
+	NULL,                        // PUT
+	&HttpRequest::handleDelete,  // DELETE
+	NULL,                        // CONNECT
+	NULL,                        // OPTIONS
+	NULL,                        // TRACE
+	NULL                         // PATCH
+};
+
 /**
  * Constructor initializes parsing state
  */
-HttpRequest::HttpRequest(void) : _state(REQUEST_LINE), _contentLength(0), 
-	_chunkSize(0), _chunked(false), _connectionError(false), _serverConfig(NULL)
+HttpRequest::HttpRequest(void) : _methodId(METHOD_UNKNOWN), _minorVersion(1), 
+	_head(""), _headLength(0), 
+	_otherHeaders(NULL), _otherCount(0), _otherCapacity(0), 
+	_state(REQUEST_LINE), _parsed(0), 
+	_scanned(0), _errorStatus(0), _contentLength(0), 
+	_bodyLimit(static_cast<size_t>(-1)), _expectContinue(false), 
+	_recvSize(MIN_RECV_SIZE), _chunkSize(0), 
+	_chunked(false), _connectionError(false), _http2Preface(false), 
+	_virtualHosts(NULL), 
+	_serverConfig(NULL), _fileCache(NULL), _responseCache(NULL)
 {
+	TextView empty = {0, 0};
+	
+	_methodView = empty;
+	_uriView = empty;
+	_versionView = empty;
+	memset(_knownHeaders, 0, sizeof(_knownHeaders));
+	memset(&_clientAddr, 0, sizeof(_clientAddr));
 }
 
 /**
@@ -39,18 +106,41 @@ HttpRequest::HttpRequest(const HttpRequest& other) :
 	_method(other._method),
 	_uri(other._uri),
 	_httpVersion(other._httpVersion),
+	_methodId(other._methodId),
+	_minorVersion(other._minorVersion),
 	_path(other._path),
 	_query(other._query),
-	_headers(other._headers),
+	_arena(other._arena),
+	_head(""),
+	_headLength(0),
+	_methodView(other._methodView),
+	_uriView(other._uriView),
+	_versionView(other._versionView),
+	_otherHeaders(NULL),
+	_otherCount(0),
+	_otherCapacity(0),
 	_body(other._body),
 	_state(other._state),
 	_buffer(other._buffer),
+	_parsed(other._parsed),
+	_scanned(other._scanned),
+	_errorStatus(other._errorStatus),
 	_contentLength(other._contentLength),
+	_bodyLimit(other._bodyLimit),
+	_expectContinue(other._expectContinue),
+	_recvSize(other._recvSize),
 	_chunkSize(other._chunkSize),
 	_chunked(other._chunked),
 	_connectionError(other._connectionError),
-	_serverConfig(other._serverConfig)
+	_http2Preface(other._http2Preface),
+	_virtualHosts(other._virtualHosts),
+	_serverConfig(other._serverConfig),
+	_fileCache(other._fileCache),
+	_responseCache(other._responseCache),
+	_clientAddr(other._clientAddr)
 {
+	memcpy(_knownHeaders, other._knownHeaders, sizeof(_knownHeaders));
+	copyHead(other);
 }
 
 /**
@@ -70,93 +160,253 @@ HttpRequest&	HttpRequest::operator=(const HttpRequest& other)
 		_method = other._method;
 		_uri = other._uri;
 		_httpVersion = other._httpVersion;
+		_methodId = other._methodId;
+		_minorVersion = other._minorVersion;
 		_path = other._path;
 		_query = other._query;
-		_headers = other._headers;
+		_methodView = other._methodView;
+		_uriView = other._uriView;
+		_versionView = other._versionView;
+		memcpy(_knownHeaders, other._knownHeaders, sizeof(_knownHeaders));
+		copyHead(other);
 		_body = other._body;
 		_state = other._state;
 		_buffer = other._buffer;
+		_parsed = other._parsed;
+		_scanned = other._scanned;
+		_errorStatus = other._errorStatus;
 		_contentLength = other._contentLength;
+		_bodyLimit = other._bodyLimit;
+		_expectContinue = other._expectContinue;
+		_recvSize = other._recvSize;
 		_chunkSize = other._chunkSize;
 		_chunked = other._chunked;
 		_connectionError = other._connectionError;
+		_http2Preface = other._http2Preface;
+		_virtualHosts = other._virtualHosts;
 		_serverConfig = other._serverConfig;
+		_fileCache = other._fileCache;
+		_responseCache = other._responseCache;
+		_clientAddr = other._clientAddr;
 	}
 	return *this;
 }
 
+/**
+ * Copy the head and the field list of another request into this
+ * request's arena
+ */
+void	HttpRequest::copyHead(const HttpRequest& other)
+{
+	_arena.reset();
+	_head = _arena.copy(other._head, other._headLength);
+	_headLength = other._headLength;
+	_otherHeaders = NULL;
+	_otherCount = 0;
+	_otherCapacity = 0;
+	for (size_t i = 0; i < other._otherCount; i++)
+		addOtherHeader(other._otherHeaders[i]);
+}
+
+/**
+ * Start the next request on the same connection; the memory of the
+ * previous one and any bytes already received are kept for it
+ */
+void	HttpRequest::reset(void)
+{
+	TextView empty = {0, 0};
+	
+	// Everything is cleared in place rather than rebuilt: the arena
+	// rewinds, strings and buffers keep their storage, so a connection
+	// in its steady state parses a request without touching the heap.
+	// The unread bytes belong to the next pipelined request.
+	_arena.reset();
+	_head = "";
+	_headLength = 0;
+	_otherHeaders = NULL;
+	_otherCount = 0;
+	_otherCapacity = 0;
+	_method.clear();
+	_uri.clear();
+	_httpVersion.clear();
+	_methodId = METHOD_UNKNOWN;
+	_minorVersion = 1;
+	_path.clear();
+	_query.clear();
+	_methodView = empty;
+	_uriView = empty;
+	_versionView = empty;
+	memset(_knownHeaders, 0, sizeof(_knownHeaders));
+	_body.clear();
+	_state = REQUEST_LINE;
+	_parsed = 0;
+	_scanned = 0;
+	_errorStatus = 0;
+	_contentLength = 0;
+	_bodyLimit = static_cast<size_t>(-1);
+	_expectContinue = false;
+	_chunkSize = 0;
+	_chunked = false;
+	_connectionError = false;
+	_http2Preface = false;
+	_serverConfig = _virtualHosts ? _virtualHosts->getDefault() : NULL;
+}
+
+/**
+ * Give back the memory a large request left behind, before the
+ * connection waits idle for the next one; only valid after reset(),
+ * which dropped every pointer into the arena
+ */
+void	HttpRequest::shrink(void)
+{
+	_recvSize = MIN_RECV_SIZE;
+	_buffer.shrink(IDLE_BUFFER_SIZE);
+	_arena.trim(IDLE_ARENA_SIZE);
+}
+
 /**
  * Read and parse data from the client socket
  * Returns true when the request is complete
  */
-bool	HttpRequest::read(Socket& clientSocket)
+bool	HttpRequest::read(ClientSocket& clientSocket)
 {
-	const size_t BUFFER_SIZE = 4096;
-	char buffer[BUFFER_SIZE];
+	size_t total = 0;
 	
-	ssize_t bytesRead = clientSocket.recv(buffer, BUFFER_SIZE);
-	
-	_logger.tempOss << "HttpRequest::read() received " << bytesRead 
-	    << " bytes";
-		_logger.debug();
-	
-	if (bytesRead <= 0)
+	// Drain the socket, parsing as we go so a body streams through a
+	// small buffer, until it runs dry or this connection used its share
+	while (true)
 	{
-	    if (bytesRead == 0)
-		{
-			// In non-blocking I/O, recv() returning 0 can mean either:
-			// 1. Client actually closed connection 
-			// 2. No data available right now (EAGAIN/EWOULDBLOCK)
-			// 
-			// If we haven't started parsing yet, or if we're complete/error, 
-			// then 0 bytes likely means connection closed.
-			// But if we're in the middle of reading body data, it might just
-			// mean no more data available right now.
-			if (_state == REQUEST_LINE || _state == COMPLETE || _state == ERROR)
-			{
-				_logger.tempOss << "Client closed connection";
-				_logger.debug();
-				_connectionError = true;
-			}
-			else
-			{
-				// We're in the middle of parsing, this might just be no data available
-				_logger.tempOss << "No more data available, request incomplete";
-				_logger.debug();
-				// Don't set _connectionError - let server keep connection for more data
-			}
-		}
-	    else
+		size_t wanted = _recvSize;
+		
+		// Receive straight into the parse buffer, no intermediate copy
+		ssize_t bytesRead = clientSocket.recv(_buffer.prepare(wanted), wanted);
+		
+		if (bytesRead < 0)
 		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
 			_logger.tempOss << "Error reading from socket: " << strerror(errno);
 			_logger.error();
 			_connectionError = true;
+			return false;
 		}
-		return false;
-	}
+		if (bytesRead == 0)
+		{
+			// Orderly shutdown by the peer; a partial request cannot finish
+			_logger.tempOss << "Client closed connection";
+			_logger.debug();
+			_connectionError = true;
+			return false;
+		}
+		
+		_buffer.commit(bytesRead);
+		total += bytesRead;
+		
+		if (parse())
+			return true;
 		
-	// Append the received data to our buffer
-	_buffer.append(buffer, bytesRead);
+		// A short read means the socket is empty, skip the EAGAIN call;
+		// one not even half full brings the receive size back down
+		if (static_cast<size_t>(bytesRead) < wanted)
+		{
+			if (static_cast<size_t>(bytesRead) <= wanted / 2 && 
+				_recvSize > MIN_RECV_SIZE)
+				_recvSize /= 2;
+			break;
+		}
+		
+		// A full read means more is queued: read bigger next time
+		if (_recvSize < MAX_RECV_SIZE)
+			_recvSize *= 2;
+		if (total >= READ_BUDGET)
+			break;
+	}
 	
-	// Print first line of the buffer for debugging
-	size_t firstLineEnd = _buffer.find("\r\n");
-	if (firstLineEnd != std::string::npos){
-	    _logger.tempOss << "First line of request: " << _buffer.substr(0, firstLineEnd);
-		_logger.debug();
+	_logger.tempOss << "HttpRequest::read() received " << total 
+		<< " bytes, request is INCOMPLETE";
+	_logger.debug();
+	
+	// The body is next and the client may be holding it back for us
+	continueIfOwed(clientSocket);
+	return false;
+}
+
+/**
+ * Parse data the event backend already received for the client socket;
+ * length is the receive's result, a negative errno on error
+ * Returns true when the request is complete
+ */
+bool	HttpRequest::receive(ClientSocket& clientSocket, const char* data, 
+			ssize_t length)
+{
+	if (length < 0)
+	{
+		_logger.tempOss << "Error reading from socket: " << strerror(-length);
+		_logger.error();
+		_connectionError = true;
+		return false;
 	}
-	else
+	if (length == 0)
 	{
-		_logger.tempOss << "Request buffer (incomplete): " << _buffer;
+		_logger.tempOss << "Client closed connection";
 		_logger.debug();
+		_connectionError = true;
+		return false;
 	}
 	
-	// Process the buffer based on current state
+	_buffer.append(data, length);
+	if (parse())
+		return true;
+	continueIfOwed(clientSocket);
+	return false;
+}
+
+/**
+ * Keep data received while a response is being sent, for the request
+ * that follows it; the end of the stream is seen again once reading
+ * resumes
+ */
+void	HttpRequest::stash(const char* data, ssize_t length)
+{
+	if (length > 0)
+		_buffer.append(data, length);
+}
+
+/**
+ * Parse a pipelined request from bytes already received. Responses to
+ * earlier requests may still be queued, so a 100 Continue it is owed
+ * stays owed: written now, it would overtake them.
+ * Returns true when it is complete
+ */
+bool	HttpRequest::resume(void)
+{
+	return parse();
+}
+
+/**
+ * Send the 100 Continue a pipelined request is owed, once the responses
+ * queued ahead of it are out
+ */
+void	HttpRequest::continueIfOwed(ClientSocket& clientSocket)
+{
+	if (_expectContinue && _state != COMPLETE && _state != ERROR)
+		sendContinue(clientSocket);
+}
+
+/**
+ * Run the state machine over the buffered bytes
+ * Returns true when the request is complete or rejected
+ */
+bool	HttpRequest::parse(void)
+{
+	// Each state resumes where the previous read stopped, so every byte
+	// is looked at once no matter how the request was split
 	bool done = false;
 	
 	while (!done)
 	{
-	    _logger.tempOss << "Request parse state: " << _state;
-		_logger.debug();
 		switch (_state)
 		{
 			case REQUEST_LINE:
@@ -175,38 +425,54 @@ bool	HttpRequest::read(Socket& clientSocket)
 				done = !parseChunkedData();
 				break;
 			case CHUNKED_END:
-				// Check for the final CRLF
-				if (_buffer.size() >= 2 && _buffer.substr(0, 2) == "\r\n")
-				{
-					_buffer = _buffer.substr(2);
-					_state = COMPLETE;
-					_logger.tempOss << "Request is COMPLETE after chunked end";
-					_logger.debug();
-				}
-				else
-				{
-					done = true;
-				}
+				done = !parseChunkedTrailer();
 				break;
 			case COMPLETE:
 			    _logger.tempOss << "Request is COMPLETE";
 				_logger.debug();
 				return true;
 			case ERROR:
-			    _logger.tempOss << "Request has ERROR state";
+			    _logger.tempOss << "Request has ERROR state (" << _errorStatus 
+					<< ")";
 				_logger.debug();
 				return true;
 			default:
 				done = true;
 		}
 	}
+	return _state == COMPLETE || _state == ERROR;
+}
+
+/**
+ * Find the next LF in the buffer without rescanning bytes already
+ * searched, npos if the line is not complete yet
+ */
+size_t	HttpRequest::findLineEnd(void)
+{
+	size_t from = _scanned > _parsed ? _scanned : _parsed;
+	size_t lineEnd = from + CharScanner::findByte(_buffer.data() + from, 
+		_buffer.size() - from, '\n');
 	
-	bool isComplete = (_state == COMPLETE || _state == ERROR);
-	_logger.tempOss << "Returning from read(), request is " 
-	    << (isComplete ? "COMPLETE" : "INCOMPLETE");
-		_logger.debug();
-	
-	return isComplete;
+	if (lineEnd >= _buffer.size())
+	{
+		_scanned = _buffer.size();
+		return Buffer::npos;
+	}
+	_scanned = lineEnd + 1;
+	return lineEnd;
+}
+
+/**
+ * Stop parsing and answer with the given error status
+ */
+bool	HttpRequest::reject(int statusCode, const char* reason)
+{
+	_logger.tempOss << "Rejecting request with " << statusCode << ": " 
+		<< reason;
+	_logger.warning();
+	_errorStatus = statusCode;
+	_state = ERROR;
+	return false;
 }
 
 /**
@@ -214,267 +480,559 @@ bool	HttpRequest::read(Socket& clientSocket)
  */
 bool	HttpRequest::parseRequestLine(void)
 {
-	size_t endPos = _buffer.find("\r\n");
+	size_t lineEnd;
 	
-	if (endPos == std::string::npos)
+	while (true)
 	{
-	    _logger.tempOss << "Request line incomplete, waiting for more data";
-		_logger.debug();
-		return false;
+		lineEnd = findLineEnd();
+		if (lineEnd == Buffer::npos)
+		{
+			if (_buffer.size() > MAX_HEAD_SIZE)
+				return reject(414, "request line too long");
+			return false;
+		}
+		// Empty lines before the request line are ignored (RFC 9112 2.2)
+		if (lineEnd == 0 || (lineEnd == 1 && _buffer.data()[0] == '\r'))
+		{
+			_buffer.consume(lineEnd + 1);
+			_scanned = 0;
+			continue;
+		}
+		break;
 	}
-		
-	std::string line = _buffer.substr(0, endPos);
-	_buffer = _buffer.substr(endPos + 2);
 	
-	_logger.tempOss << "Parsing request line: " << line;
-	_logger.debug();
+	const char* data = _buffer.data();
+	size_t length = lineEnd;
 	
-	std::istringstream lineStream(line);
-	if (!(lineStream >> _method >> _uri >> _httpVersion))
-	{
-	    _logger.tempOss << "Failed to parse request line";
-		_logger.debug();
-		_state = ERROR;
-		return false;
-	}
+	if (data[length - 1] == '\r')
+		length--;
 	
-	_logger.tempOss << "Method=" << _method << ", URI=" << _uri 
-	    << ", Version=" << _httpVersion;
-		_logger.debug();
-	
-	// Parse the URI into path and query
-	size_t queryPos = _uri.find('?');
-	if (queryPos != std::string::npos)
-	{
-		_path = _uri.substr(0, queryPos);
-		_query = _uri.substr(queryPos + 1);
-	}
-	else
+	// The HTTP/2 preface starts like a request line; the connection is
+	// handed over with the preface still unread (RFC 9113 3.4)
+	if (length == 14 && memcmp(data, "PRI * HTTP/2.0", 14) == 0)
 	{
-		_path = _uri;
+		_http2Preface = true;
+		_state = COMPLETE;
+		return true;
 	}
 	
-	_logger.tempOss << "Path=" << _path << ", Query=" << _query;
-	_logger.debug();
-	
+	if (CharScanner::skipFieldValue(data, length) != length)
+		return reject(400, "control character in request line");
+	
+	// METHOD SP URI SP VERSION; the URI takes everything in between
+	size_t methodEnd = CharScanner::skipToken(data, length);
+	size_t lastSpace = length;
+	
+	while (lastSpace > 0 && data[lastSpace - 1] != ' ')
+		lastSpace--;
+	if (methodEnd == 0 || methodEnd == length || data[methodEnd] != ' ' || 
+		lastSpace - 1 <= methodEnd || lastSpace == length)
+		return reject(400, "malformed request line");
+	
+	size_t uriStart = methodEnd + 1;
+	size_t uriEnd = lastSpace - 1;
+	
+	while (uriStart < uriEnd && data[uriStart] == ' ')
+		uriStart++;
+	while (uriEnd > uriStart && data[uriEnd - 1] == ' ')
+		uriEnd--;
+	if (uriStart == uriEnd)
+		return reject(400, "malformed request line");
+	
+	_methodView.offset = 0;
+	_methodView.length = methodEnd;
+	_uriView.offset = uriStart;
+	_uriView.length = uriEnd - uriStart;
+	_versionView.offset = lastSpace;
+	_versionView.length = length - lastSpace;
+	
+	// HTTP-version is "HTTP/" DIGIT "." DIGIT (RFC 9112 2.3); a later
+	// 1.x is answered as 1.1
+	const char* version = data + lastSpace;
+	
+	if (_versionView.length != 8 || memcmp(version, "HTTP/", 5) != 0 || 
+		!isdigit(version[5]) || version[6] != '.' || !isdigit(version[7]))
+		return reject(400, "bad HTTP version");
+	if (version[5] != '1')
+		return reject(505, "unsupported HTTP version");
+	_minorVersion = version[7] == '0' ? 0 : 1;
+	
+	// Known methods are told apart once, here; handlers and access
+	// checks only look at the id
+	_methodId = MethodTable::lookup(data, methodEnd);
+	
+	_parsed = lineEnd + 1;
 	_state = HEADERS;
 	return true;
 }
 
 /**
  * Parse HTTP headers
+ * Fields are recorded as offsets into the buffer, nothing is copied
+ * until the empty line ends the head
  */
 bool	HttpRequest::parseHeaders(void)
 {
 	while (true)
 	{
-		size_t endPos = _buffer.find("\r\n");
+		size_t lineEnd = findLineEnd();
 		
-		if (endPos == std::string::npos)
+		if (lineEnd == Buffer::npos)
 		{
-		    _logger.tempOss << "Headers incomplete, waiting for more data";
-			_logger.debug();
+			if (_buffer.size() > MAX_HEAD_SIZE)
+				return reject(431, "request head too large");
 			return false;
 		}
-			
+		if (lineEnd >= MAX_HEAD_SIZE)
+			return reject(431, "request head too large");
+		
+		const char* data = _buffer.data();
+		size_t start = _parsed;
+		size_t end = lineEnd;
+		
+		if (end > start && data[end - 1] == '\r')
+			end--;
+		_parsed = lineEnd + 1;
+		
 		// If we find an empty line, headers are complete
-		if (endPos == 0)
-		{
-			_buffer = _buffer.substr(2);
-			
-			_logger.tempOss << "End of headers found";
-			_logger.debug();
-			
-			// Determine the next state based on headers
-			std::string transferEncoding = getHeader("Transfer-Encoding");
-			std::transform(transferEncoding.begin(), transferEncoding.end(), 
-				transferEncoding.begin(), ::tolower);
-				
-			if (transferEncoding.find("chunked") != std::string::npos)
-			{
-			    _logger.tempOss << "Found chunked encoding";
-				_logger.debug();
-				_chunked = true;
-				_state = CHUNKED_SIZE;
-			}
-			else
-			{
-				std::string contentLengthStr = getHeader("Content-Length");
-				if (!contentLengthStr.empty())
-				{
-					_contentLength = strtoul(contentLengthStr.c_str(), NULL, 10);
-					_logger.tempOss << "Content-Length: " << _contentLength;
-					_logger.debug();
-					
-					// Check against server's client_max_body_size limit
-					if (_serverConfig && _contentLength > _serverConfig->clientMaxBodySize)
-					{
-						_logger.tempOss << "Request body size " << _contentLength 
-							<< " exceeds server limit " << _serverConfig->clientMaxBodySize;
-						_logger.warning();
-						_state = ERROR;
-						return false;
-					}
-					
-					_state = BODY;
-				}
-				else
-				{
-					// No content expected, request is complete
-					_logger.tempOss << "No body expected, request is complete";
-					_logger.debug();
-					_state = COMPLETE;
-				}
-			}
-			
-			return true;
-		}
+		if (end == start)
+			return finishHeaders();
 		
-		std::string line = _buffer.substr(0, endPos);
-		_buffer = _buffer.substr(endPos + 2);
+		// Obsolete line folding is not accepted (RFC 9112 5.2)
+		if (data[start] == ' ' || data[start] == '\t')
+			return reject(400, "folded header line");
 		
-		_logger.tempOss << "Parsing header line: " << line;
-		_logger.debug();
+		// The name is a token ending at the colon, which also rules out
+		// whitespace before the colon
+		size_t nameEnd = start + CharScanner::skipToken(data + start, 
+			end - start);
 		
-		size_t colonPos = line.find(':');
-		if (colonPos == std::string::npos)
-		{
-		    _logger.tempOss << "Invalid header line: " << line;
-			_logger.debug();
-			_state = ERROR;
-			return false;
-		}
+		if (nameEnd == start || nameEnd == end || data[nameEnd] != ':')
+			return reject(400, "invalid header name");
 		
-		std::string name = line.substr(0, colonPos);
-		std::string value = line.substr(colonPos + 1);
+		size_t valueStart = nameEnd + 1;
+		size_t valueEnd = end;
 		
 		// Trim leading and trailing whitespace from value
-		size_t valueStart = value.find_first_not_of(" \t");
-		if (valueStart != std::string::npos)
-		{
-			size_t valueEnd = value.find_last_not_of(" \t");
-			value = value.substr(valueStart, valueEnd - valueStart + 1);
-		}
-		else
+		while (valueStart < valueEnd && 
+			(data[valueStart] == ' ' || data[valueStart] == '\t'))
+			valueStart++;
+		while (valueEnd > valueStart && 
+			(data[valueEnd - 1] == ' ' || data[valueEnd - 1] == '\t'))
+			valueEnd--;
+		if (CharScanner::skipFieldValue(data + valueStart, 
+			valueEnd - valueStart) != valueEnd - valueStart)
+			return reject(400, "invalid character in header value");
+		
+		HeaderView header;
+		header.name.offset = start;
+		header.name.length = nameEnd - start;
+		header.value.offset = valueStart;
+		header.value.length = valueEnd - valueStart;
+		
+		// Known fields go to their slot, the rest to a short list
+		HeaderId id = HeaderTable::lookup(data + start, header.name.length);
+		
+		if (id == HEADER_UNKNOWN)
 		{
-			value = "";
+			addOtherHeader(header);
+			continue;
 		}
 		
-		_logger.tempOss << "Header: [" << name << "] = [" << value << "]";
-		_logger.debug();
-		_headers[name] = value;
+		HeaderView& slot = _knownHeaders[id];
+		
+		// Framing and routing must not be ambiguous (RFC 9112 3.2, 6.3);
+		// other repeated fields keep the last value
+		if (slot.name.length != 0 && (id == HEADER_HOST || 
+			id == HEADER_TRANSFER_ENCODING || 
+			(id == HEADER_CONTENT_LENGTH && 
+				(slot.value.length != header.value.length || 
+				memcmp(data + slot.value.offset, data + header.value.offset, 
+					header.value.length) != 0))))
+			return reject(400, "conflicting duplicate header");
+		slot = header;
 	}
 }
 
 /**
- * Parse request body based on Content-Length
+ * Record a field that has no slot of its own
  */
-bool	HttpRequest::parseBody(void)
+void	HttpRequest::addOtherHeader(const HeaderView& header)
 {
-    _logger.tempOss << "Parsing body, have " << _buffer.size() 
-        << " bytes, need " << _contentLength;
-		_logger.debug();
-        
-	if (_buffer.size() >= _contentLength)
+	// The list grows inside the arena; the old array is simply left
+	// behind until the next request rewinds it
+	if (_otherCount == _otherCapacity)
 	{
-		// Additional safety check: verify total body size won't exceed limit
-		size_t newBodySize = _body.size() + _contentLength;
-		if (_serverConfig && newBodySize > _serverConfig->clientMaxBodySize)
-		{
-			_logger.tempOss << "Total body size " << newBodySize 
-				<< " would exceed server limit " << _serverConfig->clientMaxBodySize;
-			_logger.warning();
-			_state = ERROR;
-			return false;
-		}
+		size_t capacity = _otherCapacity ? _otherCapacity * 2 : 8;
+		HeaderView* headers = static_cast<HeaderView*>(
+			_arena.allocate(capacity * sizeof(HeaderView)));
 		
-		_body.append(_buffer.substr(0, _contentLength));
-		_buffer = _buffer.substr(_contentLength);
-		_state = COMPLETE;
-		_logger.tempOss << "Body complete with " << _body.size() << " bytes";
+		if (_otherCount)
+			memcpy(headers, _otherHeaders, _otherCount * sizeof(HeaderView));
+		_otherHeaders = headers;
+		_otherCapacity = capacity;
+	}
+	_otherHeaders[_otherCount++] = header;
+}
+
+/**
+ * Copy the head out of the buffer once and pick the body framing
+ */
+bool	HttpRequest::finishHeaders(void)
+{
+	// The views stay valid: they are offsets from the start of the head
+	_head = _arena.copy(_buffer.data(), _parsed);
+	_headLength = _parsed;
+	_buffer.consume(_parsed);
+	_parsed = 0;
+	_scanned = 0;
+	
+	// assign() reuses the storage left by the previous request
+	_method.assign(_head + _methodView.offset, _methodView.length);
+	_uri.assign(_head + _uriView.offset, _uriView.length);
+	_httpVersion.assign(_head + _versionView.offset, _versionView.length);
+	
+	// Parse the URI into path and query
+	size_t queryPos = _uri.find('?');
+	if (queryPos != std::string::npos)
+	{
+		_path.assign(_uri, 0, queryPos);
+		_query.assign(_uri, queryPos + 1, std::string::npos);
+	}
+	else
+	{
+		_path = _uri;
+	}
+	
+	_logger.tempOss << "End of headers: " << _method << " " << _uri << " " 
+		<< _httpVersion << ", " << _otherCount << " unknown fields";
+	_logger.debug();
+	
+	// Route now, so the body is checked against the right vhost
+	if (_virtualHosts)
+		_serverConfig = _virtualHosts->find(getHeader(HEADER_HOST));
+	
+	if (_serverConfig)
+	{
+		// The location may narrow the server's client_max_body_size
+		const LocationConfig* location = findLocation(*_serverConfig);
+		
+		_bodyLimit = location ? location->clientMaxBodySize : 
+			_serverConfig->clientMaxBodySize;
+		
+		// Bodies over client_body_buffer_size are spooled to a file
+		_body.configure(_serverConfig->clientBodyBufferSize, 
+			_serverConfig->clientBodyTempPath);
+	}
+	
+	// Only 100-continue can be met (RFC 9110 10.1.1); HTTP/1.0 clients
+	// never wait for it
+	// The framing fields are read in place in the head, no copies
+	if (hasHeader(HEADER_EXPECT) && _minorVersion != 0)
+	{
+		const TextView& expect = _knownHeaders[HEADER_EXPECT].value;
+		
+		if (expect.length != 12 || 
+			strncasecmp(_head + expect.offset, "100-continue", 12) != 0)
+			return reject(417, "unsupported expectation");
+		_expectContinue = true;
+	}
+	
+	// Determine the next state based on headers. Pipelined bytes after
+	// the body are read as the next request, so any framing that two
+	// parsers could read differently is refused (RFC 9112 6.1, 6.3)
+	if (hasHeader(HEADER_TRANSFER_ENCODING))
+	{
+		const TextView& coding = _knownHeaders[HEADER_TRANSFER_ENCODING].value;
+		
+		if (hasHeader(HEADER_CONTENT_LENGTH))
+			return reject(400, "both Transfer-Encoding and Content-Length");
+		if (_minorVersion == 0)
+			return reject(400, "Transfer-Encoding in an HTTP/1.0 request");
+		if (!endsWithToken(coding, "chunked"))
+			return reject(400, "chunked is not the final transfer coding");
+		// No other coding is decoded
+		if (coding.length != 7)
+			return reject(501, "unsupported transfer coding");
+		
+	    _logger.tempOss << "Found chunked encoding";
 		_logger.debug();
+		_chunked = true;
+		_state = CHUNKED_SIZE;
 		return true;
 	}
 	
-	_logger.tempOss << "Body incomplete, waiting for more data";
+	if (!hasHeader(HEADER_CONTENT_LENGTH))
+	{
+		// No content expected, request is complete
+		_logger.tempOss << "No body expected, request is complete";
+		_logger.debug();
+		_expectContinue = false;
+		_state = COMPLETE;
+		return true;
+	}
+	
+	if (!parseLength(_knownHeaders[HEADER_CONTENT_LENGTH].value, 
+		_contentLength))
+		return reject(400, "invalid Content-Length");
+	
+	_logger.tempOss << "Content-Length: " << _contentLength;
+	_logger.debug();
+	
+	// Refuse before a single body byte is read: a client waiting on
+	// 100-continue never sends it, and the connection closes after the
+	// 413 for those that do not
+	if (_contentLength > _bodyLimit)
+		return reject(413, "Content-Length exceeds client_max_body_size");
+	
+	// A body known to be large goes to its file from the first byte
+	if (!_body.reserve(_contentLength))
+		return reject(500, "cannot store request body");
+	// No need to ramp up the receive size for a body known to be large
+	if (_contentLength >= MAX_RECV_SIZE)
+		_recvSize = MAX_RECV_SIZE;
+	if (_contentLength == 0)
+		_expectContinue = false;
+	_state = _contentLength > 0 ? BODY : COMPLETE;
+	return true;
+}
+
+/**
+ * Answer Expect: 100-continue once the body is about to be read
+ */
+void	HttpRequest::sendContinue(ClientSocket& clientSocket)
+{
+	static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+	const size_t length = sizeof(CONTINUE) - 1;
+	
+	_expectContinue = false;
+	
+	// A client that did not wait has nothing left to be told
+	if (!_buffer.empty() || !_body.empty())
+		return;
+	
+	ssize_t sent = clientSocket.send(CONTINUE, length);
+	
+	// An empty send buffer always takes these few bytes; if it cannot,
+	// the client stops waiting after its own timeout, but half an
+	// interim response would corrupt the final one
+	if (sent > 0 && static_cast<size_t>(sent) < length)
+		_connectionError = true;
+	
+	_logger.tempOss << "Sent 100 Continue";
 	_logger.debug();
+}
+
+/**
+ * Get the text of a view into the head
+ */
+std::string	HttpRequest::viewString(const TextView& view) const
+{
+	return std::string(_head + view.offset, view.length);
+}
+
+/**
+ * Check whether a view into the head contains a word, in any case
+ */
+bool	HttpRequest::containsNoCase(const TextView& view, const char* word) const
+{
+	size_t wordLength = strlen(word);
+	const char* data = _head + view.offset;
+	
+	for (size_t i = 0; i + wordLength <= view.length; i++)
+	{
+		if (strncasecmp(data + i, word, wordLength) == 0)
+			return true;
+	}
 	return false;
 }
 
+/**
+ * Check whether the last element of a comma-separated list in the head
+ * is exactly the given token, in any case
+ */
+bool	HttpRequest::endsWithToken(const TextView& view, const char* token) const
+{
+	size_t tokenLength = strlen(token);
+	const char* data = _head + view.offset;
+	
+	if (view.length < tokenLength || strncasecmp(data + view.length - 
+		tokenLength, token, tokenLength) != 0)
+		return false;
+	
+	// Only whitespace may sit between the token and the comma before it
+	size_t start = view.length - tokenLength;
+	
+	while (start > 0 && (data[start - 1] == ' ' || data[start - 1] == '\t'))
+		start--;
+	return start == 0 || data[start - 1] == ',';
+}
+
+/**
+ * Read a view into the head as a decimal length, false if it is not
+ */
+bool	HttpRequest::parseLength(const TextView& view, size_t& length) const
+{
+	const char* data = _head + view.offset;
+	size_t value = 0;
+	
+	if (view.length == 0)
+		return false;
+	for (size_t i = 0; i < view.length; i++)
+	{
+		if (!isdigit(static_cast<unsigned char>(data[i])))
+			return false;
+		
+		size_t digit = data[i] - '0';
+		
+		if (value > (static_cast<size_t>(-1) - digit) / 10)
+			return false;
+		value = value * 10 + digit;
+	}
+	length = value;
+	return true;
+}
+
+/**
+ * Parse request body based on Content-Length
+ * Whatever has arrived is moved to the body right away
+ */
+bool	HttpRequest::parseBody(void)
+{
+	size_t take = _contentLength - _body.size();
+	
+	if (take > _buffer.size())
+		take = _buffer.size();
+	if (!_body.append(_buffer.data(), take))
+		return reject(500, "cannot store request body");
+	_buffer.consume(take);
+	
+	if (_body.size() < _contentLength)
+		return false;
+	
+	_state = COMPLETE;
+	_logger.tempOss << "Body complete with " << _body.size() << " bytes";
+	_logger.debug();
+	return true;
+}
+
 /**
  * Parse chunked encoding size line
  */
 bool	HttpRequest::parseChunkedSize(void)
 {
-	size_t endPos = _buffer.find("\r\n");
+	size_t lineEnd = findLineEnd();
 	
-	if (endPos == std::string::npos)
+	if (lineEnd == Buffer::npos)
 	{
-	    _logger.tempOss << "Chunk size line incomplete";
-		_logger.debug();
+		if (_buffer.size() > MAX_CHUNK_LINE)
+			return reject(400, "chunk size line too long");
 		return false;
 	}
-		
-	std::string line = _buffer.substr(0, endPos);
-	_buffer = _buffer.substr(endPos + 2);
 	
-	// Parse the chunk size (hex)
-	char* endPtr;
-	_chunkSize = strtoul(line.c_str(), &endPtr, 16);
+	// Hex size, optionally followed by ;extensions which are ignored
+	const char* data = _buffer.data();
+	size_t pos = 0;
+	size_t size = 0;
+	
+	while (pos < lineEnd && isxdigit(static_cast<unsigned char>(data[pos])))
+	{
+		if (size > (static_cast<size_t>(-1) >> 4))
+			return reject(413, "chunk size overflow");
+		char c = tolower(data[pos++]);
+		size = size * 16 + (isdigit(c) ? c - '0' : c - 'a' + 10);
+	}
+	if (pos == 0 || (pos < lineEnd && data[pos] != ';' && data[pos] != ' ' && 
+		data[pos] != '\t' && data[pos] != '\r'))
+		return reject(400, "invalid chunk size");
+	
+	_buffer.consume(lineEnd + 1);
+	_scanned = 0;
+	_chunkSize = size;
 	
 	_logger.tempOss << "Chunk size: " << _chunkSize << " bytes";
 	_logger.debug();
 	
 	if (_chunkSize == 0)
 	{
-		// Final chunk, look for trailing headers (not implemented)
-		_logger.tempOss << "Final chunk (size 0) received";
-		_logger.debug();
 		_state = CHUNKED_END;
+		return true;
 	}
-	else
-	{
-		_state = CHUNKED_DATA;
-	}
 	
+	// Check if adding this chunk would exceed size limit
+	if (_chunkSize > _bodyLimit - _body.size())
+		return reject(413, "chunked body exceeds client_max_body_size");
+	
+	_state = CHUNKED_DATA;
 	return true;
 }
 
 /**
  * Parse chunked encoding data
+ * Partial chunks are moved to the body as they arrive
  */
 bool	HttpRequest::parseChunkedData(void)
 {
-    _logger.tempOss << "Parsing chunk data, have " << _buffer.size() 
-        << " bytes, need " << _chunkSize + 2;
-		_logger.debug();
-        
-	if (_buffer.size() >= _chunkSize + 2)  // +2 for CRLF
+	if (_chunkSize > 0)
 	{
-		// Check if adding this chunk would exceed size limit
-		size_t newBodySize = _body.size() + _chunkSize;
-		if (_serverConfig && newBodySize > _serverConfig->clientMaxBodySize)
+		size_t take = _chunkSize;
+		
+		if (take > _buffer.size())
+			take = _buffer.size();
+		if (!_body.append(_buffer.data(), take))
+			return reject(500, "cannot store request body");
+		_buffer.consume(take);
+		_chunkSize -= take;
+		if (_chunkSize > 0)
+			return false;
+	}
+	
+	// The chunk data is followed by CRLF
+	const char* data = _buffer.data();
+	
+	if (_buffer.size() >= 1 && data[0] == '\n')
+		_buffer.consume(1);
+	else if (_buffer.size() >= 2 && data[0] == '\r' && data[1] == '\n')
+		_buffer.consume(2);
+	else if (_buffer.size() == 0 || (_buffer.size() == 1 && data[0] == '\r'))
+		return false;
+	else
+		return reject(400, "missing CRLF after chunk data");
+	
+	_state = CHUNKED_SIZE;
+	return true;
+}
+
+/**
+ * Skip the trailer fields after the last chunk
+ */
+bool	HttpRequest::parseChunkedTrailer(void)
+{
+	while (true)
+	{
+		size_t lineEnd = findLineEnd();
+		
+		if (lineEnd == Buffer::npos)
 		{
-			_logger.tempOss << "Chunked body size " << newBodySize 
-				<< " would exceed server limit " << _serverConfig->clientMaxBodySize;
-			_logger.warning();
-			_state = ERROR;
+			if (_buffer.size() > MAX_HEAD_SIZE)
+				return reject(431, "chunked trailer too large");
 			return false;
 		}
 		
-		_body.append(_buffer.substr(0, _chunkSize));
-		_buffer = _buffer.substr(_chunkSize + 2);  // Skip CRLF
-		_state = CHUNKED_SIZE;
+		bool empty = lineEnd == 0 || 
+			(lineEnd == 1 && _buffer.data()[0] == '\r');
 		
-		_logger.tempOss << "Chunk data complete, body now " 
-		    << _body.size() << " bytes";
-		_logger.debug();
-		return true;
+		_buffer.consume(lineEnd + 1);
+		_scanned = 0;
+		if (empty)
+			break;
 	}
 	
-	_logger.tempOss << "Chunk data incomplete, waiting for more data";
+	_state = COMPLETE;
+	_logger.tempOss << "Request is COMPLETE after chunked end, body " 
+		<< _body.size() << " bytes";
 	_logger.debug();
-	return false;
+	return true;
 }
 
 /**
@@ -488,34 +1046,21 @@ HttpResponse	HttpRequest::process(const Config& config)
     
 	HttpResponse response;
 	
-	// If request parsing failed (e.g., due to size limits), return 413 error
+	// If request parsing failed, answer with the status picked by the
+	// parser; the rest of the stream cannot be trusted, so close after
 	if (_state == ERROR)
 	{
-		_logger.tempOss << "Request in ERROR state, returning 413 Payload Too Large";
+		_logger.tempOss << "Request in ERROR state, returning " << _errorStatus;
 		_logger.warning();
-		response.setStatus(413);
-		response.setBody(config.getDefaultErrorPage(413));
+		response.setStatus(_errorStatus);
+		response.setBody(config.getDefaultErrorPage(_errorStatus));
+		response.setKeepAlive(false);
 		return response;
 	}
 	
-	// Extract host and port from Host header
-	std::string host = getHeader("Host");
-	int port = 80;  // Default
-	
-	_logger.tempOss << "Host header: " << host;
-	_logger.debug();
-	
-	size_t colonPos = host.find(':');
-	if (colonPos != std::string::npos)
-	{
-		port = atoi(host.substr(colonPos + 1).c_str());
-		host = host.substr(0, colonPos);
-		_logger.tempOss << "Extracted host=" << host << ", port=" << port;
-		_logger.debug();
-	}
-	
-	// Find the appropriate server configuration
-	const ServerConfig* server = config.findServer(host, port, host);
+	// The server was picked from the listener's table when the headers
+	// ended, no need to scan the whole configuration again
+	const ServerConfig* server = _serverConfig;
 	
 	if (!server)
 	{
@@ -526,8 +1071,7 @@ HttpResponse	HttpRequest::process(const Config& config)
 		return response;
 	}
 	
-	_logger.tempOss << "Found matching server for " << host 
-	    << ":" << port;
+	_logger.tempOss << "Found matching server for " << getHeader(HEADER_HOST);
 		_logger.debug();
 	
 	// Find the appropriate location configuration
@@ -547,12 +1091,26 @@ HttpResponse	HttpRequest::process(const Config& config)
 	_logger.debug();
 	
 	// Check if method is allowed
-	if (!location->allowedMethods.empty() && 
-		location->allowedMethods.find(_method) == location->allowedMethods.end())
+	if (location->allowedMethods != 0 && 
+		!(location->allowedMethods & MethodTable::getBit(_methodId)))
 	{
 	    _logger.tempOss << "Method " << _method << " not allowed";
 		_logger.debug();
+		
+		// A 405 lists what the location takes (RFC 9110 15.5.6)
+		std::string allow;
+		
+		for (int method = 0; method < METHOD_COUNT; method++)
+		{
+			if (!(location->allowedMethods & 
+				MethodTable::getBit(static_cast<HttpMethod>(method))))
+				continue;
+			if (!allow.empty())
+				allow += ", ";
+			allow += MethodTable::getName(static_cast<HttpMethod>(method));
+		}
 		response.setStatus(405);
+		response.addHeader("Allow", allow);
 		response.setBody(config.getDefaultErrorPage(405));
 		return response;
 	}
@@ -568,19 +1126,10 @@ HttpResponse	HttpRequest::process(const Config& config)
 	}
 	
 	// Handle different HTTP methods
-	if (_method == "GET")
-	{
-		return handleGet(*location, response, config);
-	}
-	else if (_method == "POST")
-	{
-		return handlePost(*location, response, config);
-	}
-	else if (_method == "DELETE")
-	{
-		return handleDelete(*location, response, config);
-	}
-	else
+	MethodHandler handler = _methodId < METHOD_COUNT ? _handlers[_methodId] 
+		: NULL;
+	
+	if (!handler)
 	{
 		_logger.tempOss << "Unsupported method " << _method;
 		_logger.debug();
@@ -588,6 +1137,7 @@ HttpResponse	HttpRequest::process(const Config& config)
 		response.setBody(config.getDefaultErrorPage(501));
 		return response;
 	}
+	return (this->*handler)(*location, response, config);
 }
 
 /**
@@ -620,6 +1170,14 @@ const LocationConfig*	HttpRequest::findLocation(const ServerConfig& server) cons
 	return bestMatch;
 }
 
+/**
+ * Get the request method as parsed from the request line
+ */
+HttpMethod	HttpRequest::getMethodId(void) const
+{
+	return _methodId;
+}
+
 /**
  * Get the request method
  */
@@ -645,28 +1203,70 @@ const std::string&	HttpRequest::getHttpVersion(void) const
 }
 
 /**
- * Get a specific header value
+ * Get a known header value, empty if absent
+ */
+std::string	HttpRequest::getHeader(HeaderId id) const
+{
+	if (id >= HEADER_COUNT || _knownHeaders[id].name.length == 0)
+		return "";
+	return viewString(_knownHeaders[id].value);
+}
+
+/**
+ * Get a specific header value by name, in any case
+ */
+std::string	HttpRequest::getHeader(const std::string& name) const
+{
+	HeaderId id = HeaderTable::lookup(name.data(), name.size());
+	
+	if (id != HEADER_UNKNOWN)
+		return getHeader(id);
+	
+	// Unknown fields are few, a scan beats building an index; a repeated
+	// field keeps the last value
+	for (size_t i = _otherCount; i-- > 0; )
+	{
+		const HeaderView& header = _otherHeaders[i];
+		
+		if (header.name.length == name.size() && 
+			strncasecmp(_head + header.name.offset, name.data(), 
+				name.size()) == 0)
+			return viewString(header.value);
+	}
+	return "";
+}
+
+/**
+ * Check if a known header was sent
  */
-std::string	HttpRequest::getHeader(const std::string& name) const
+bool	HttpRequest::hasHeader(HeaderId id) const
 {
-	std::map<std::string, std::string>::const_iterator it = _headers.find(name);
-	if (it != _headers.end())
-		return it->second;
-	return "";
+	return id < HEADER_COUNT && _knownHeaders[id].name.length != 0;
 }
 
 /**
- * Get all headers
+ * Get all headers, built from the parsed views on demand
  */
-const std::map<std::string, std::string>&	HttpRequest::getHeaders(void) const
+std::map<std::string, std::string>	HttpRequest::getHeaders(void) const
 {
-	return _headers;
+	std::map<std::string, std::string> headers;
+	
+	for (size_t i = 0; i < HEADER_COUNT; i++)
+	{
+		if (_knownHeaders[i].name.length != 0)
+			headers[viewString(_knownHeaders[i].name)] = 
+				viewString(_knownHeaders[i].value);
+	}
+	for (size_t i = 0; i < _otherCount; i++)
+		headers[viewString(_otherHeaders[i].name)] = 
+			viewString(_otherHeaders[i].value);
+	return headers;
 }
 
 /**
  * Get the request body
  */
-const std::string&	HttpRequest::getBody(void) const
+const RequestBody&	HttpRequest::getBody(void) const
 {
 	return _body;
 }
@@ -700,11 +1300,20 @@ HttpResponse	HttpRequest::handleGet(const LocationConfig& location,
 		return handleCgi(location, response, config);
 	}
 	
-	// Check if the path is a directory
-	struct stat pathStat;
-	bool isDirectory = (stat(fullPath.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode));
+	// A cached answer needs no filesystem access at all; conditional and
+	// range requests are checked against the file's own stat data instead
+	if (_responseCache && !hasHeader(HEADER_IF_NONE_MATCH) && 
+		!hasHeader(HEADER_IF_MODIFIED_SINCE) && !hasHeader(HEADER_RANGE) && 
+		_responseCache->lookup(_serverConfig, _path, response))
+	{
+		_logger.tempOss << "Answered " << _path << " from the response cache";
+		_logger.debug();
+		return response;
+	}
+	
+	FileInfo info = lookupFile(fullPath);
 	
-	if (isDirectory)
+	if (info.isDirectory)
 	{
 		// If path doesn't end with '/', redirect to add trailing slash
 		if (!_path.empty() && _path[_path.length() - 1] != '/')
@@ -726,23 +1335,9 @@ HttpResponse	HttpRequest::handleGet(const LocationConfig& location,
 		}
 		
 		// Check if index file exists
-		std::ifstream indexFile(indexPath.c_str(), std::ios::binary);
-		if (indexFile.is_open())
-		{
-			// Serve the index file
-			std::string content((std::istreambuf_iterator<char>(indexFile)), 
-			                   std::istreambuf_iterator<char>());
-			indexFile.close();
-			
-			_logger.tempOss << "Successfully read " << content.size() 
-			    << " bytes from index file " << indexPath;
-			_logger.debug();
-			
-			response.setStatus(200);
-			response.setBody(content);
-			response.addHeader("Content-Type", getMimeType(indexPath));
-			return response;
-		}
+		FileInfo index = lookupFile(indexPath);
+		if (index.file.isOpen())
+			return serveFile(index, indexPath, response, config);
 		
 		// No index file found, check if autoindex is enabled
 		if (location.autoindex)
@@ -758,47 +1353,411 @@ HttpResponse	HttpRequest::handleGet(const LocationConfig& location,
 		}
 	}
 	
-	// Not a directory, handle as regular file
-	// If path ends with '/', try to serve index file (shouldn't happen after directory check)
-	if (!_path.empty() && _path[_path.length() - 1] == '/')
+	// Missing paths, and anything that is not a regular file
+	if (info.error != 0)
 	{
-		if (!location.index.empty())
+		_logger.tempOss << "File not found: " << fullPath 
+			<< " (" << strerror(info.error) << ")";
+		_logger.debug();
+		
+		response.setStatus(404);
+		response.setBody(config.getDefaultErrorPage(404));
+		return response;
+	}
+	
+	return serveFile(info, fullPath, response, config);
+}
+
+/**
+ * Look a path up, through the file cache when there is one
+ */
+FileInfo	HttpRequest::lookupFile(const std::string& path)
+{
+	FileInfo info;
+	
+	if (_fileCache)
+		return _fileCache->lookup(path);
+	OpenFileCache::load(path, info);
+	return info;
+}
+
+/**
+ * Drop a path this request wrote or removed from the caches, so the
+ * next GET on this thread sees the change at once; other threads and
+ * processes see it once their entries are checked again
+ */
+void	HttpRequest::forgetFile(const std::string& path)
+{
+	if (_fileCache)
+		_fileCache->forget(path);
+	if (_responseCache)
+		_responseCache->forget(path);
+}
+
+/**
+ * Build the strong entity tag of a file version from its inode, size
+ * and modification time, in hex. The nanoseconds are part of it: two
+ * edits of the same size within a second must not share a tag that
+ * byte ranges are matched against.
+ */
+std::string	HttpRequest::makeEntityTag(const FileInfo& info)
+{
+	std::ostringstream tag;
+	
+	tag << '"' << std::hex << static_cast<unsigned long>(info.inode) << '-' 
+		<< static_cast<unsigned long>(info.size) << '-' 
+		<< static_cast<unsigned long>(info.mtime) << '.' 
+		<< static_cast<unsigned long>(info.mtimeNsec) << '"';
+	return tag.str();
+}
+
+/**
+ * Check whether a list of entity tags (or *) holds a tag, ignoring
+ * weakness as If-None-Match does (RFC 9110 8.8.3.2)
+ */
+bool	HttpRequest::listsEntityTag(const std::string& list, 
+	const std::string& tag)
+{
+	size_t pos = 0;
+	
+	while (pos < list.size())
+	{
+		pos = list.find_first_not_of(" \t,", pos);
+		if (pos == std::string::npos)
+			break;
+		if (list[pos] == '*')
+			return true;
+		if (list.compare(pos, 2, "W/") == 0)
+			pos += 2;
+		if (pos >= list.size() || list[pos] != '"')
+			return false;
+		
+		size_t end = list.find('"', pos + 1);
+		
+		if (end == std::string::npos)
+			return false;
+		if (list.compare(pos, end + 1 - pos, tag) == 0)
+			return true;
+		pos = end + 1;
+	}
+	return false;
+}
+
+/**
+ * Check whether the validators sent with the request still match the
+ * file, so a 304 can stand for it; If-Modified-Since only counts when
+ * there is no If-None-Match (RFC 9110 13.2.2)
+ */
+bool	HttpRequest::isNotModified(const std::string& tag, time_t mtime) const
+{
+	if (hasHeader(HEADER_IF_NONE_MATCH))
+		return listsEntityTag(getHeader(HEADER_IF_NONE_MATCH), tag);
+	
+	time_t since;
+	
+	return hasHeader(HEADER_IF_MODIFIED_SINCE) && 
+		HttpDate::parse(getHeader(HEADER_IF_MODIFIED_SINCE), since) && 
+		mtime <= since;
+}
+
+/**
+ * Check whether a Range may be honoured: no If-Range, or one that still
+ * names this version of the file. Entity tags are compared strongly,
+ * so a weak one never matches, and a date must be the exact
+ * Last-Modified (RFC 9110 13.1.5).
+ */
+bool	HttpRequest::isRangeFresh(const std::string& tag, time_t mtime) const
+{
+	if (!hasHeader(HEADER_IF_RANGE))
+		return true;
+	
+	std::string value = getHeader(HEADER_IF_RANGE);
+	time_t date;
+	
+	if (!value.empty() && value[0] == '"')
+		return value == tag;
+	if (value.compare(0, 2, "W/") == 0)
+		return false;
+	return HttpDate::parse(value, date) && date == mtime;
+}
+
+/**
+ * Read a byte position, saturating instead of overflowing; false if
+ * there are no digits
+ */
+static bool	parseBytePosition(const char*& p, off_t& position)
+{
+	const off_t limit = static_cast<off_t>(
+		(static_cast<unsigned long long>(1) << (sizeof(off_t) * 8 - 1)) - 1);
+	const char* start = p;
+	
+	position = 0;
+	while (*p >= '0' && *p <= '9')
+	{
+		int digit = *p++ - '0';
+		
+		position = position > (limit - digit) / 10 ? limit 
+			: position * 10 + digit;
+	}
+	return p != start;
+}
+
+/**
+ * Parse a Range header against the file size; returns 206 with the
+ * ranges to send, 416 if none can be, or 200 to ignore the header
+ * because it is malformed or asks for too many ranges (RFC 9110 14.2).
+ * Ranges keep their order unless some overlap, then they are merged.
+ */
+int	HttpRequest::parseRanges(const std::string& value, off_t size, 
+	std::vector<ByteRange>& ranges)
+{
+	if (value.size() < 6 || strncasecmp(value.c_str(), "bytes=", 6) != 0)
+		return 200;
+	
+	const char* p = value.c_str() + 6;
+	size_t count = 0;
+	
+	while (*p)
+	{
+		// Empty list elements are allowed
+		while (*p == ' ' || *p == '\t' || *p == ',')
+			p++;
+		if (!*p)
+			break;
+		
+		off_t first;
+		off_t last;
+		bool hasFirst = parseBytePosition(p, first);
+		
+		if (*p != '-')
+			return 200;
+		p++;
+		
+		bool hasLast = parseBytePosition(p, last);
+		
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if ((*p && *p != ',') || (!hasFirst && !hasLast) || 
+			(hasFirst && hasLast && last < first) || ++count > MAX_RANGES)
+			return 200;
+		
+		ByteRange range;
+		
+		if (!hasFirst)
 		{
-			fullPath += location.index;
+			// The last N bytes; none of an empty file
+			if (last == 0 || size == 0)
+				continue;
+			range.first = last >= size ? 0 : size - last;
+			range.last = size - 1;
 		}
 		else
 		{
-			fullPath += "index.html";
+			if (first >= size)
+				continue;
+			range.first = first;
+			range.last = (!hasLast || last >= size) ? size - 1 : last;
 		}
+		ranges.push_back(range);
 	}
+	if (count == 0)
+		return 200;
+	if (ranges.empty())
+		return 416;
 	
-	// Try to open and read the file
-	std::ifstream file(fullPath.c_str(), std::ios::binary);
+	bool overlap = false;
 	
-	if (!file.is_open())
+	for (size_t i = 0; i < ranges.size() && !overlap; ++i)
 	{
-		_logger.tempOss << "File not found: " << fullPath;
-		_logger.debug();
+		for (size_t j = i + 1; j < ranges.size() && !overlap; ++j)
+			overlap = ranges[i].first <= ranges[j].last && 
+				ranges[j].first <= ranges[i].last;
+	}
+	if (overlap)
+	{
+		std::vector<ByteRange> merged;
 		
-		response.setStatus(404);
-		response.setBody(config.getDefaultErrorPage(404));
+		// Few ranges: an insertion sort by first byte, then one pass
+		for (size_t i = 1; i < ranges.size(); ++i)
+		{
+			for (size_t j = i; j > 0 && ranges[j].first < ranges[j - 1].first; --j)
+				std::swap(ranges[j], ranges[j - 1]);
+		}
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			if (!merged.empty() && ranges[i].first <= merged.back().last + 1)
+				merged.back().last = std::max(merged.back().last, ranges[i].last);
+			else
+				merged.push_back(ranges[i]);
+		}
+		ranges.swap(merged);
+	}
+	return 206;
+}
+
+/**
+ * Answer a GET with the requested ranges of a file, as one part or as
+ * multipart/byteranges. The parts are read into the body when they are
+ * small, or else sent from the file with sendfile() between the text
+ * of each part.
+ */
+HttpResponse	HttpRequest::serveRanges(const FileInfo& info, 
+	const std::string& path, const std::vector<ByteRange>& ranges, 
+	HttpResponse& response, const Config& config)
+{
+	std::vector<BodyPart> parts(ranges.size());
+	
+	response.setStatus(206);
+	if (ranges.size() == 1)
+	{
+		std::ostringstream contentRange;
+		
+		contentRange << "bytes " << ranges[0].first << '-' << ranges[0].last 
+			<< '/' << info.size;
+		response.addHeader("Content-Type", info.mimeType);
+		response.addHeader("Content-Range", contentRange.str());
+		parts[0].offset = ranges[0].first;
+		parts[0].length = ranges[0].last - ranges[0].first + 1;
+	}
+	else
+	{
+		// The file version's tag, which cannot vary within the file
+		std::string tag = makeEntityTag(info);
+		std::string boundary = "webserv-" + tag.substr(1, tag.size() - 2);
+		BodyPart closing;
+		
+		response.addHeader("Content-Type", 
+			"multipart/byteranges; boundary=" + boundary);
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			std::ostringstream head;
+			
+			head << "\r\n--" << boundary << "\r\nContent-Type: " 
+				<< info.mimeType << "\r\nContent-Range: bytes " 
+				<< ranges[i].first << '-' << ranges[i].last << '/' 
+				<< info.size << "\r\n\r\n";
+			parts[i].prefix = head.str();
+			parts[i].offset = ranges[i].first;
+			parts[i].length = ranges[i].last - ranges[i].first + 1;
+		}
+		closing.prefix = "\r\n--" + boundary + "--\r\n";
+		closing.offset = 0;
+		closing.length = 0;
+		parts.push_back(closing);
+	}
+	
+	size_t total = 0;
+	
+	for (size_t i = 0; i < parts.size(); ++i)
+		total += parts[i].prefix.size() + parts[i].length;
+	_logger.tempOss << "Sending " << ranges.size() << " ranges (" << total 
+		<< " bytes) of " << path;
+	_logger.debug();
+	if (total > INLINE_FILE_SIZE)
+	{
+		response.setFileParts(info.file, parts);
 		return response;
 	}
 	
-	// Read file content
-	std::string content((std::istreambuf_iterator<char>(file)), 
-	                   std::istreambuf_iterator<char>());
-	file.close();
+	std::string content;
 	
-	_logger.tempOss << "Successfully read " << content.size() 
-	    << " bytes from " << fullPath;
+	content.reserve(total);
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		content += parts[i].prefix;
+		
+		size_t at = content.size();
+		
+		content.resize(at + parts[i].length);
+		if (parts[i].length > 0 && info.file.read(parts[i].offset, 
+			&content[at], parts[i].length) != static_cast<ssize_t>(parts[i].length))
+		{
+			_logger.tempOss << "Error reading " << path << ": " 
+				<< (errno ? strerror(errno) : "file shrank");
+			_logger.error();
+			response.setStatus(500);
+			response.setBody(config.getDefaultErrorPage(500));
+			return response;
+		}
+	}
+	response.setBody(content);
+	return response;
+}
+
+/**
+ * Answer with an open file: small ones are read into the body to leave
+ * with the head in one write, larger ones are sent with sendfile()
+ */
+HttpResponse	HttpRequest::serveFile(const FileInfo& info, 
+	const std::string& path, HttpResponse& response, const Config& config)
+{
+	const FileHandle& file = info.file;
+	size_t size = info.size;
+	size_t inlineSize = INLINE_FILE_SIZE;
+	std::string tag = makeEntityTag(info);
+	
+	response.addHeader("ETag", tag);
+	response.addHeader("Last-Modified", HttpDate::format(info.mtime));
+	if (isNotModified(tag, info.mtime))
+	{
+		_logger.tempOss << "Not modified: " << path;
 		_logger.debug();
+		response.setStatus(304);
+		return response;
+	}
+	
+	response.addHeader("Accept-Ranges", "bytes");
+	if (hasHeader(HEADER_RANGE) && isRangeFresh(tag, info.mtime))
+	{
+		std::vector<ByteRange> ranges;
+		int status = parseRanges(getHeader(HEADER_RANGE), info.size, ranges);
+		
+		if (status == 416)
+		{
+			std::ostringstream contentRange;
+			
+			contentRange << "bytes */" << info.size;
+			response.setStatus(416);
+			response.addHeader("Content-Range", contentRange.str());
+			response.setBody(config.getDefaultErrorPage(416));
+			return response;
+		}
+		if (status == 206)
+			return serveRanges(info, path, ranges, response, config);
+	}
+	
+	// Files the response cache may keep are read to be kept
+	if (_responseCache && _responseCache->getMaxEntrySize() > inlineSize)
+		inlineSize = _responseCache->getMaxEntrySize();
 	
-	// Set response
 	response.setStatus(200);
-	response.setBody(content);
-	response.addHeader("Content-Type", getMimeType(fullPath));
+	response.addHeader("Content-Type", info.mimeType);
+	if (size > inlineSize)
+	{
+		_logger.tempOss << "Sending " << size << " bytes from " << path;
+		_logger.debug();
+		response.setFile(file, 0, size);
+		return response;
+	}
 	
+	std::string content(size, '\0');
+	ssize_t got = size > 0 ? file.read(0, &content[0], size) : 0;
+	
+	if (got < 0)
+	{
+		_logger.tempOss << "Error reading " << path << ": " << strerror(errno);
+		_logger.error();
+		response.setStatus(500);
+		response.setBody(config.getDefaultErrorPage(500));
+		return response;
+	}
+	content.resize(got);
+	_logger.tempOss << "Successfully read " << content.size() 
+	    << " bytes from " << path;
+	_logger.debug();
+	response.setBody(content);
+	if (_responseCache)
+		_responseCache->store(_serverConfig, _path, path, info, response);
 	return response;
 }
 
@@ -827,7 +1786,7 @@ HttpResponse HttpRequest::handlePost(LocationConfig const &location,
 	}
 	
 	// Parse Content-Type header to handle multipart/form-data
-	std::string contentType = getHeader("Content-Type");
+	std::string contentType = getHeader(HEADER_CONTENT_TYPE);
 	
 	if (contentType.find("multipart/form-data") != std::string::npos) {
 		return handleFileUpload(location, response, config);
@@ -864,8 +1823,16 @@ HttpResponse HttpRequest::handlePost(LocationConfig const &location,
 			return response;
 		}
 		
-		file.write(_body.c_str(), _body.size());
+		bool written = _body.writeTo(file, 0, _body.size());
 		file.close();
+		forgetFile(uploadPath);
+		if (!written) {
+			_logger.tempOss << "Failed to write upload file: " << uploadPath;
+			_logger.debug();
+			response.setStatus(500);
+			response.setBody(config.getDefaultErrorPage(500));
+			return response;
+		}
 		
 		_logger.tempOss << "Successfully uploaded " << _body.size() 
 		    << " bytes to " << uploadPath;
@@ -925,60 +1892,12 @@ HttpResponse	HttpRequest::handleDelete(const LocationConfig& location,
 	
 	_logger.tempOss << "Successfully deleted file: " << fullPath;
 	_logger.debug();
+	forgetFile(fullPath);
 	
 	response.setStatus(204); // No Content
 	return response;
 }
 
-/**
- * Get MIME type for file extension
- */
-std::string	HttpRequest::getMimeType(const std::string& filename) const
-{
-	size_t dotPos = filename.find_last_of('.');
-	if (dotPos == std::string::npos)
-		return "application/octet-stream";
-	
-	std::string ext = filename.substr(dotPos + 1);
-	
-	// Convert to lowercase for comparison
-	for (size_t i = 0; i < ext.length(); ++i)
-		ext[i] = std::tolower(ext[i]);
-	
-	if (ext == "html" || ext == "htm")
-		return "text/html";
-	else if (ext == "css")
-		return "text/css";
-	else if (ext == "js")
-		return "application/javascript";
-	else if (ext == "json")
-		return "application/json";
-	else if (ext == "xml")
-		return "application/xml";
-	else if (ext == "txt")
-		return "text/plain";
-	else if (ext == "jpg" || ext == "jpeg")
-		return "image/jpeg";
-	else if (ext == "png")
-		return "image/png";
-	else if (ext == "gif")
-		return "image/gif";
-	else if (ext == "svg")
-		return "image/svg+xml";
-	else if (ext == "ico")
-		return "image/x-icon";
-	else if (ext == "pdf")
-		return "application/pdf";
-	else if (ext == "zip")
-		return "application/zip";
-	else if (ext == "mp4")
-		return "video/mp4";
-	else if (ext == "mp3")
-		return "audio/mpeg";
-	else
-		return "application/octet-stream";
-}
-
 /**
  * Check if path is safe and within allowed directory
  */
@@ -1039,19 +1958,27 @@ HttpResponse	HttpRequest::generateDirectoryListing(const LocationConfig& locatio
 		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
 			continue;
 		
-		std::string fullItemPath = dirPath + "/" + entry->d_name;
-		struct stat statBuf;
+		// The entry type usually comes with the name; stat() only for
+		// symlinks and filesystems that leave it unknown
+		bool isDirectory = (entry->d_type == DT_DIR);
 		
-		if (stat(fullItemPath.c_str(), &statBuf) == 0)
+		if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK)
 		{
-			html << "<a href=\"" << entry->d_name;
-			if (S_ISDIR(statBuf.st_mode))
-				html << "/";
-			html << "\">" << entry->d_name;
-			if (S_ISDIR(statBuf.st_mode))
-				html << "/";
-			html << "</a>\n";
+			std::string fullItemPath = dirPath + "/" + entry->d_name;
+			struct stat statBuf;
+			
+			if (stat(fullItemPath.c_str(), &statBuf) != 0)
+				continue;
+			isDirectory = S_ISDIR(statBuf.st_mode);
 		}
+		
+		html << "<a href=\"" << entry->d_name;
+		if (isDirectory)
+			html << "/";
+		html << "\">" << entry->d_name;
+		if (isDirectory)
+			html << "/";
+		html << "</a>\n";
 	}
 	
 	html << "</pre>\n<hr>\n</body>\n</html>";
@@ -1074,7 +2001,7 @@ HttpResponse	HttpRequest::handleFileUpload(const LocationConfig& location,
 	_logger.debug();
 	
 	// Parse boundary from Content-Type header
-	std::string contentType = getHeader("Content-Type");
+	std::string contentType = getHeader(HEADER_CONTENT_TYPE);
 	size_t boundaryPos = contentType.find("boundary=");
 	
 	if (boundaryPos == std::string::npos)
@@ -1127,7 +2054,7 @@ HttpResponse	HttpRequest::handleFileUpload(const LocationConfig& location,
 		char delimiter = '"';
 		
 		// Check if filename is quoted
-		if (filenameStart < _body.length() && _body[filenameStart] == '"')
+		if (_body.substr(filenameStart, 1) == "\"")
 		{
 			filenameStart++;
 			delimiter = '"';
@@ -1138,11 +2065,12 @@ HttpResponse	HttpRequest::handleFileUpload(const LocationConfig& location,
 			delimiter = ' ';
 		}
 		
-		size_t filenameEnd = _body.find(delimiter, filenameStart);
+		size_t filenameEnd = _body.find(std::string(1, delimiter), 
+			filenameStart);
 		if (delimiter == ' ')
 		{
 			// For unquoted, also check for semicolon and CRLF
-			size_t semicolonPos = _body.find(';', filenameStart);
+			size_t semicolonPos = _body.find(";", filenameStart);
 			size_t crlfPos = _body.find("\r\n", filenameStart);
 			
 			filenameEnd = filenameEnd < semicolonPos ? filenameEnd : semicolonPos;
@@ -1173,12 +2101,12 @@ HttpResponse	HttpRequest::handleFileUpload(const LocationConfig& location,
 	}
 	contentStart += 4;
 	
-	// Find end boundary
-	size_t contentEnd = _body.find("\r\n--", contentStart);
+	// Find end boundary; the file content itself may contain "\r\n--"
+	size_t contentEnd = _body.find("\r\n" + boundary, contentStart);
 	if (contentEnd == std::string::npos)
-		contentEnd = _body.length();
+		contentEnd = _body.size();
 	
-	std::string fileContent = _body.substr(contentStart, contentEnd - contentStart);
+	size_t contentLength = contentEnd - contentStart;
 	
 	// Ensure upload directory exists
 	struct stat dirStat;
@@ -1204,10 +2132,21 @@ HttpResponse	HttpRequest::handleFileUpload(const LocationConfig& location,
 		return response;
 	}
 	
-	file.write(fileContent.c_str(), fileContent.size());
+	// Copied in blocks, a spooled upload never comes back into memory
+	bool written = _body.writeTo(file, contentStart, contentLength);
 	file.close();
+	forgetFile(uploadPath);
+	
+	if (!written)
+	{
+		_logger.tempOss << "Failed to write upload file: " << uploadPath;
+		_logger.debug();
+		response.setStatus(500);
+		response.setBody(config.getDefaultErrorPage(500));
+		return response;
+	}
 	
-	_logger.tempOss << "Successfully uploaded " << fileContent.size() 
+	_logger.tempOss << "Successfully uploaded " << contentLength 
 	    << " bytes to " << uploadPath;
 		_logger.debug();
 	
@@ -1232,7 +2171,7 @@ HttpResponse HttpRequest::handleFormData(HttpResponse &response) {
         "<h1>Form Data Received!</h1>"
         "<div class=\"success\">"
             "<img src=\"images/suggestion-box.gif\" alt=\"printing form\" class=\"data-image\" />"
-						"<h2>"+ _body +"</h2>"
+						"<h2>"+ _body.substr(0, _body.size()) +"</h2>"
         "</div>"
         "<p>Go back <a href=\"index.html\">Home</a></p>"
     "</body>"
@@ -1282,6 +2221,62 @@ HttpResponse	HttpRequest::handleCgi(const LocationConfig& location,
 	return cgiHandler.handleCgiRequest(*this, location, scriptPath);
 }
 
+/**
+ * Parse bytes handed over by another protocol layer
+ * Returns true when the request is complete or rejected
+ */
+bool	HttpRequest::feed(const char* data, size_t length)
+{
+	_buffer.append(data, length);
+	return parse();
+}
+
+/**
+ * Move the bytes received but not parsed to another buffer
+ */
+void	HttpRequest::takeBuffered(Buffer& into)
+{
+	into.append(_buffer.data(), _buffer.size());
+	_buffer.clear();
+}
+
+/**
+ * Check if the connection opened with the HTTP/2 preface instead of
+ * a request; the preface is left unparsed in the buffer
+ */
+bool	HttpRequest::isHttp2Preface(void) const
+{
+	return _http2Preface;
+}
+
+/**
+ * Check if the request asks to upgrade the connection to h2c
+ */
+bool	HttpRequest::wantsHttp2Upgrade(void) const
+{
+	// A request with a body is answered in HTTP/1.1, which the server
+	// is free to do (RFC 7540 3.2)
+	return _state == COMPLETE && _minorVersion == 1 && 
+		hasHeader(HEADER_UPGRADE) && hasHeader(HEADER_HTTP2_SETTINGS) && 
+		containsNoCase(_knownHeaders[HEADER_UPGRADE].value, "h2c") && 
+		!_chunked && _body.empty();
+}
+
+/**
+ * Check if the client lets the connection stay open after this
+ * request (RFC 9112 9.3)
+ */
+bool	HttpRequest::wantsKeepAlive(void) const
+{
+	const TextView& connection = _knownHeaders[HEADER_CONNECTION].value;
+	
+	if (_minorVersion == 0)
+		return hasHeader(HEADER_CONNECTION) && 
+			containsNoCase(connection, "keep-alive");
+	return !hasHeader(HEADER_CONNECTION) || 
+		!containsNoCase(connection, "close");
+}
+
 /**
  * Check if there was a connection error (should close connection)
  */
@@ -1291,9 +2286,71 @@ bool	HttpRequest::hasConnectionError(void) const
 }
 
 /**
- * Set server configuration for size validation during parsing
+ * Check if any byte of this request has been received yet
+ */
+bool	HttpRequest::hasReceivedData(void) const
+{
+	return _state != REQUEST_LINE || !_buffer.empty();
+}
+
+/**
+ * Check if the headers are done and the body is being received
+ */
+bool	HttpRequest::isReadingBody(void) const
+{
+	return _state == BODY || _state == CHUNKED_SIZE 
+		|| _state == CHUNKED_DATA || _state == CHUNKED_END;
+}
+
+/**
+ * Set the virtual hosts of the listener the request arrived on; the
+ * server is resolved from the Host header as soon as the headers end
+ */
+void	HttpRequest::setVirtualHosts(const VirtualHostTable* virtualHosts)
+{
+	_virtualHosts = virtualHosts;
+	_serverConfig = virtualHosts ? virtualHosts->getDefault() : NULL;
+}
+
+/**
+ * Set the open file cache of the thread serving the request, NULL to
+ * look every file up again
+ */
+void	HttpRequest::setFileCache(OpenFileCache* fileCache)
+{
+	_fileCache = fileCache;
+}
+
+/**
+ * Set the response cache of the thread serving the request, NULL to
+ * build every response
+ */
+void	HttpRequest::setResponseCache(ResponseCache* responseCache)
+{
+	_responseCache = responseCache;
+}
+
+/**
+ * Get the server handling this request (the listener's default until
+ * the headers are parsed)
+ */
+const ServerConfig*	HttpRequest::getServerConfig(void) const
+{
+	return _serverConfig;
+}
+
+/**
+ * Set the peer address of the connection the request came from
+ */
+void	HttpRequest::setClientAddress(const struct sockaddr_in& addr)
+{
+	_clientAddr = addr;
+}
+
+/**
+ * Get the peer address of the connection the request came from
  */
-void	HttpRequest::setServerConfig(const ServerConfig* serverConfig)
+const struct sockaddr_in&	HttpRequest::getClientAddress(void) const
 {
-	_serverConfig = serverConfig;
+	return _clientAddr;
 }
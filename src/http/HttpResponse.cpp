@@ -11,16 +11,25 @@
 /* ************************************************************************** */
 
 #include "HttpResponse.hpp"
+#include "HttpDate.hpp"
 #include <sstream>
+#include <algorithm>
 #include <ctime>
 #include <iostream>
 #include <cstring>
 #include <cerrno>
 
+/**
+ * Most bytes handed to one sendfile() call; the socket takes what fits
+ * and the rest waits for the next writable event
+ */
+static const size_t	SENDFILE_CHUNK = 4194304;
+
 /**
  * Constructor initializes a default response
  */
 HttpResponse::HttpResponse(void) : _statusCode(200), _statusText("OK"), 
+	_fileLength(0), _fileSent(0), _part(0), _partSent(0), _sharedBody(0), 
 	_bytesSent(0), _keepAlive(true)
 {
 }
@@ -33,6 +42,14 @@ HttpResponse::HttpResponse(const HttpResponse& other) :
 	_statusText(other._statusText),
 	_headers(other._headers),
 	_body(other._body),
+	_file(other._file),
+	_parts(other._parts),
+	_fileLength(other._fileLength),
+	_fileSent(other._fileSent),
+	_part(other._part),
+	_partSent(other._partSent),
+	_shared(other._shared),
+	_sharedBody(other._sharedBody),
 	_rawResponse(other._rawResponse),
 	_bytesSent(other._bytesSent),
 	_keepAlive(other._keepAlive)
@@ -57,6 +74,14 @@ HttpResponse&	HttpResponse::operator=(const HttpResponse& other)
 		_statusText = other._statusText;
 		_headers = other._headers;
 		_body = other._body;
+		_file = other._file;
+		_parts = other._parts;
+		_fileLength = other._fileLength;
+		_fileSent = other._fileSent;
+		_part = other._part;
+		_partSent = other._partSent;
+		_shared = other._shared;
+		_sharedBody = other._sharedBody;
 		_rawResponse = other._rawResponse;
 		_bytesSent = other._bytesSent;
 		_keepAlive = other._keepAlive;
@@ -103,6 +128,7 @@ std::string	HttpResponse::getStatusText(int statusCode)
 		case 418: return "I'm a teapot";
 		case 422: return "Unprocessable Entity";
 		case 429: return "Too Many Requests";
+		case 431: return "Request Header Fields Too Large";
 		case 500: return "Internal Server Error";
 		case 501: return "Not Implemented";
 		case 502: return "Bad Gateway";
@@ -115,81 +141,113 @@ std::string	HttpResponse::getStatusText(int statusCode)
 
 /**
  * Generate the raw HTTP response from components
+ * The head is written straight into the raw buffer, followed by the
+ * body unless it goes out from a file
  */
 void	HttpResponse::generateRawResponse(void)
 {
     _logger.tempOss << "Generating raw response for status " << _statusCode;
 		_logger.debug();
-	std::ostringstream oss;
+	std::ostringstream statusLine;
 	
 	// Status line
-	oss << "HTTP/1.1 " << _statusCode << " " << _statusText << "\r\n";
+	statusLine << "HTTP/1.1 " << _statusCode << " " << _statusText << "\r\n";
 	
-	// Add default headers if not present
-	if (_headers.find("Date") == _headers.end())
-		_headers["Date"] = getFormattedDate();
-		
-	if (_headers.find("Content-Length") == _headers.end())
+	if (_shared.size() > 0)
 	{
-		std::ostringstream lengthStr;
-		lengthStr << _body.length();
-		_headers["Content-Length"] = lengthStr.str();
+		// Only the fields that change per request; the shared buffer
+		// carries the rest of the head and the body
+		_rawResponse = statusLine.str();
+		_rawResponse += "Connection: ";
+		_rawResponse += _keepAlive ? "keep-alive" : "close";
+		_rawResponse += "\r\nDate: ";
+		_rawResponse += getFormattedDate();
+		_rawResponse += "\r\n";
+		_logger.tempOss << "Raw response head of " << _rawResponse.length() 
+			<< " bytes, " << _shared.size() << " shared bytes follow";
+		_logger.debug();
+		return;
 	}
-			
-	if (_headers.find("Connection") == _headers.end())
-		_headers["Connection"] = _keepAlive ? "keep-alive" : "close";
-		
-	if (_body.length() > 0 && _headers.find("Content-Type") == _headers.end())
-		_headers["Content-Type"] = "text/html";
 	
-	// Server header
-	if (_headers.find("Server") == _headers.end())
-	    _headers["Server"] = "WebServ/0.1";
-		
+	addDefaultHeaders();
+	
+	size_t headLength = statusLine.str().length() + 2;
+	
+	for (std::map<std::string, std::string>::const_iterator it = _headers.begin();
+		it != _headers.end(); ++it)
+		headLength += it->first.length() + it->second.length() + 4;
+	_rawResponse.reserve(headLength + _body.length());
+	_rawResponse = statusLine.str();
+	
 	// Add all headers
 	for (std::map<std::string, std::string>::const_iterator it = _headers.begin();
 		it != _headers.end(); ++it)
 	{
 	    _logger.tempOss << "Adding header: " << it->first << ": " << it->second;
 			_logger.debug();
-		oss << it->first << ": " << it->second << "\r\n";
+		_rawResponse += it->first;
+		_rawResponse += ": ";
+		_rawResponse += it->second;
+		_rawResponse += "\r\n";
 	}
 	
 	// Empty line separating headers from body
-	oss << "\r\n";
+	_rawResponse += "\r\n";
 	
 	// Add body
 	if (!_body.empty())
 	{
 	    _logger.tempOss << "Adding body of " << _body.length() << " bytes";
 		_logger.debug();
-		oss << _body;
+		_rawResponse += _body;
+	}
+	else if (_file.isOpen())
+	{
+	    _logger.tempOss << "Body of " << _fileLength << " bytes follows from fd " 
+			<< _file.getFd();
+		_logger.debug();
 	}
 	
-	_rawResponse = oss.str();
-	
-	// Debug output - show the first part of the response
-	std::string firstPart = _rawResponse.substr(0, std::min(_rawResponse.length(), 
-	    static_cast<size_t>(200)));
 	_logger.tempOss << "Raw response (" << _rawResponse.length() 
-	    << " bytes):\n" << firstPart;
-		_logger.debug();
-	if (_rawResponse.length() > 200)
-	    _logger.tempOss << "...";
+	    << " bytes in memory)";
 		_logger.debug();
 }
 
+/**
+ * Fill in the headers every response carries: Date, Content-Length,
+ * Connection, Content-Type and Server, unless already set
+ */
+void	HttpResponse::addDefaultHeaders(void)
+{
+	if (_headers.find("Date") == _headers.end())
+		_headers["Date"] = getFormattedDate();
+		
+	// A 304 has no content, and its length would have to be the one of
+	// the 200 it stands for (RFC 9110 8.6)
+	if (_statusCode != 304 && _headers.find("Content-Length") == _headers.end())
+	{
+		std::ostringstream lengthStr;
+		lengthStr << getBodyLength();
+		_headers["Content-Length"] = lengthStr.str();
+	}
+			
+	if (_headers.find("Connection") == _headers.end())
+		_headers["Connection"] = _keepAlive ? "keep-alive" : "close";
+		
+	if (getBodyLength() > 0 && _headers.find("Content-Type") == _headers.end())
+		_headers["Content-Type"] = "text/html";
+	
+	// Server header
+	if (_headers.find("Server") == _headers.end())
+	    _headers["Server"] = "WebServ/0.1";
+}
+
 /**
  * Get a formatted date string for HTTP headers
  */
 std::string	HttpResponse::getFormattedDate(void)
 {
-	char buffer[100];
-	time_t now = time(0);
-	struct tm* tm = gmtime(&now);
-	
-	strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", tm);
-	return std::string(buffer);
+	return HttpDate::format(time(0));
 }
 
 /**
@@ -222,6 +280,87 @@ void	HttpResponse::setBody(const std::string& body)
         << " bytes";
 	_logger.debug();
 	_body = body;
+	_file.reset();
+	_parts.clear();
+	_fileLength = 0;
+}
+
+/**
+ * Send a range of an open file as the body, without reading it
+ */
+void	HttpResponse::setFile(const FileHandle& file, off_t offset, size_t length)
+{
+	std::vector<BodyPart> parts(1);
+	
+	parts[0].offset = offset;
+	parts[0].length = length;
+	setFileParts(file, parts);
+}
+
+/**
+ * Send text and ranges of an open file as the body, without reading the
+ * file
+ */
+void	HttpResponse::setFileParts(const FileHandle& file, 
+	const std::vector<BodyPart>& parts)
+{
+	_body.clear();
+	_file = file;
+	_parts = parts;
+	_fileLength = 0;
+	for (size_t i = 0; i < _parts.size(); ++i)
+		_fileLength += _parts[i].prefix.size() + _parts[i].length;
+	_fileSent = 0;
+	_part = 0;
+	_partSent = 0;
+	advanceFile(0);  // past parts with nothing to send
+	_logger.tempOss << "Setting body to " << _fileLength << " bytes in " 
+		<< _parts.size() << " parts from fd " << file.getFd();
+	_logger.debug();
+}
+
+/**
+ * Answer with a cached response: the head fields that never change and
+ * the body, of which bodyLength bytes are body
+ */
+void	HttpResponse::setShared(int statusCode, const SharedBuffer& cached, 
+	size_t bodyLength)
+{
+	setStatus(statusCode);
+	_body.clear();
+	_file.reset();
+	_parts.clear();
+	_fileLength = 0;
+	_shared = cached;
+	_sharedBody = bodyLength;
+}
+
+/**
+ * Move the head fields that do not change between requests and the
+ * in-memory body into a buffer the cache can hand out again; Date and
+ * Connection are left out, to be written for each response
+ */
+SharedBuffer	HttpResponse::share(void)
+{
+	std::string cached;
+	
+	addDefaultHeaders();
+	_headers.erase("Date");
+	_headers.erase("Connection");
+	for (std::map<std::string, std::string>::const_iterator it = _headers.begin();
+		it != _headers.end(); ++it)
+	{
+		cached += it->first;
+		cached += ": ";
+		cached += it->second;
+		cached += "\r\n";
+	}
+	cached += "\r\n";
+	cached += _body;
+	_sharedBody = _body.length();
+	_shared = SharedBuffer(cached);
+	_body.clear();
+	return _shared;
 }
 
 /**
@@ -244,55 +383,220 @@ bool	HttpResponse::shouldKeepAlive(void) const
 }
 
 /**
- * Send the response to a client socket
- * Returns true when the response has been fully sent
+ * Get the status code
  */
-bool	HttpResponse::send(Socket& clientSocket)
+int	HttpResponse::getStatusCode(void) const
 {
-	// Generate raw response if not already done
+	return _statusCode;
+}
+
+/**
+ * Get the header fields
+ */
+const std::map<std::string, std::string>&	HttpResponse::getHeaders(void) const
+{
+	return _headers;
+}
+
+/**
+ * Get the body length, in memory or in a file
+ */
+size_t	HttpResponse::getBodyLength(void) const
+{
+	if (_file.isOpen())
+		return _fileLength;
+	return _shared.size() > 0 ? _sharedBody : _body.length();
+}
+
+/**
+ * Copy body bytes starting at offset, whether they are in memory or in
+ * a file; returns how many were copied, -1 on a read error
+ */
+ssize_t	HttpResponse::readBody(size_t offset, char* into, size_t length) const
+{
+	size_t total = getBodyLength();
+	
+	if (offset >= total)
+		return 0;
+	if (length > total - offset)
+		length = total - offset;
+	if (_shared.size() > 0)
+	{
+		memcpy(into, _shared.data() + _shared.size() - _sharedBody + offset, 
+			length);
+		return length;
+	}
+	if (!_file.isOpen())
+	{
+		memcpy(into, _body.data() + offset, length);
+		return length;
+	}
+	
+	// Walk the parts up to offset, then copy text and read file ranges
+	size_t copied = 0;
+	size_t start = 0;
+	
+	for (size_t i = 0; i < _parts.size() && copied < length; ++i)
+	{
+		const BodyPart& part = _parts[i];
+		size_t prefixSize = part.prefix.size();
+		size_t end = start + prefixSize + part.length;
+		
+		while (offset < end && copied < length)
+		{
+			size_t within = offset - start;
+			size_t chunk;
+			
+			if (within < prefixSize)
+			{
+				chunk = std::min(prefixSize - within, length - copied);
+				memcpy(into + copied, part.prefix.data() + within, chunk);
+			}
+			else
+			{
+				chunk = std::min(end - offset, length - copied);
+				if (_file.read(part.offset + (within - prefixSize), 
+					into + copied, chunk) != static_cast<ssize_t>(chunk))
+					return -1;
+			}
+			copied += chunk;
+			offset += chunk;
+		}
+		start = end;
+	}
+	return copied;
+}
+
+/**
+ * Point at most max buffers at the bytes not sent yet, building the raw
+ * response first; returns how many were used
+ */
+size_t	HttpResponse::getPending(struct iovec* buffers, size_t max)
+{
+	size_t count = 0;
+	size_t rawLength = _rawResponse.length();
+	
 	if (_rawResponse.empty())
 	{
 	    _logger.tempOss << "No raw response yet, generating now";
 		_logger.debug();
 		generateRawResponse();
+		rawLength = _rawResponse.length();
 	}
-		
-	// Calculate remaining bytes to send
-	size_t remaining = _rawResponse.length() - _bytesSent;
-	
-	if (remaining == 0)
+	if (_bytesSent < rawLength && count < max)
 	{
-	    _logger.tempOss << "No bytes remaining to send, response complete";
-		_logger.debug();
-		return true;
+		buffers[count].iov_base = const_cast<char*>(_rawResponse.data()) 
+			+ _bytesSent;
+		buffers[count].iov_len = rawLength - _bytesSent;
+		count++;
 	}
 	
-	_logger.tempOss << "Sending " << remaining << " remaining bytes";
-	_logger.debug();
-		
-	// Try to send the remaining data
-	ssize_t bytesSent = clientSocket.send(_rawResponse.c_str() + _bytesSent, 
-		remaining);
-		
-	if (bytesSent < 0)
+	size_t sharedSent = _bytesSent > rawLength ? _bytesSent - rawLength : 0;
+	
+	if (sharedSent < _shared.size() && count < max)
 	{
-	    _logger.tempOss << "Send failed with error: " 
-	        << strerror(errno);
-			_logger.error();
-		throw std::runtime_error("Failed to send response: " + 
-		    std::string(strerror(errno)));
+		buffers[count].iov_base = const_cast<char*>(_shared.data()) 
+			+ sharedSent;
+		buffers[count].iov_len = _shared.size() - sharedSent;
+		count++;
 	}
+	return count;
+}
+
+/**
+ * Record bytes handed to the socket, returns how many of them
+ * belonged to this response
+ */
+size_t	HttpResponse::markSent(size_t length)
+{
+	size_t total = _rawResponse.length() + _shared.size();
+	size_t remaining = total - _bytesSent;
 	
-	_logger.tempOss << "Successfully sent " << bytesSent << " bytes";
-	_logger.debug();
-	_bytesSent += bytesSent;
-	
-	// Check if we've sent everything
-	bool complete = (_bytesSent == _rawResponse.length());
+	if (length > remaining)
+		length = remaining;
+	_bytesSent += length;
 	_logger.tempOss << "Response sending is " 
-	    << (complete ? "complete" : "incomplete") 
-	    << " (" << _bytesSent << "/" << _rawResponse.length() << " bytes)";
-		_logger.debug();
+	    << (isSent() ? "complete" : "incomplete") 
+	    << " (" << _bytesSent << "/" << total << " bytes)";
+	_logger.debug();
+	return length;
+}
+
+/**
+ * Check if the body is sent from a file
+ */
+bool	HttpResponse::hasFile(void) const
+{
+	return _file.isOpen();
+}
+
+/**
+ * Check if the head is out and the file body is next
+ */
+bool	HttpResponse::isSendingFile(void) const
+{
+	return _file.isOpen() && !_rawResponse.empty() && 
+		_bytesSent == _rawResponse.length() + _shared.size() && 
+		_fileSent < _fileLength;
+}
+
+/**
+ * Send the next piece of the file body, the text of the current part or
+ * its file range; returns the bytes sent or -1 with errno set
+ */
+ssize_t	HttpResponse::sendFile(ClientSocket& clientSocket)
+{
+	const BodyPart& part = _parts[_part];
+	ssize_t sent;
 	
-	return complete;
+	if (_partSent < part.prefix.size())
+	{
+		sent = clientSocket.send(part.prefix.data() + _partSent, 
+			part.prefix.size() - _partSent);
+	}
+	else
+	{
+		size_t done = _partSent - part.prefix.size();
+		off_t offset = part.offset + done;
+		size_t length = part.length - done;
+		
+		if (length > SENDFILE_CHUNK)
+			length = SENDFILE_CHUNK;
+		sent = clientSocket.sendFile(_file.getFd(), offset, length);
+		if (sent == 0)
+		{
+			// The file shrank under us: the promised length cannot be met
+			errno = EIO;
+			return -1;
+		}
+	}
+	if (sent > 0)
+		advanceFile(sent);
+	return sent;
+}
+
+/**
+ * Record file body bytes handed to the socket, moving on to the next
+ * part once one is done
+ */
+void	HttpResponse::advanceFile(size_t length)
+{
+	_fileSent += length;
+	_partSent += length;
+	while (_part < _parts.size() && 
+		_partSent == _parts[_part].prefix.size() + _parts[_part].length)
+	{
+		_part++;
+		_partSent = 0;
+	}
+}
+
+/**
+ * Check if the whole response has been sent
+ */
+bool	HttpResponse::isSent(void) const
+{
+	return !_rawResponse.empty() && 
+		_bytesSent == _rawResponse.length() + _shared.size() && 
+		_fileSent == _fileLength;
 }
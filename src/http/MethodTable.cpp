@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MethodTable.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/21 09:48:27 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/21 09:48:27 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "MethodTable.hpp"
+#include <cstring>
+
+/**
+ * Names, in HttpMethod order
+ */
+static const char*	METHOD_NAMES[METHOD_COUNT] = {
+	"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE",
+	"PATCH"
+};
+
+/**
+ * Get the id of a method name, METHOD_UNKNOWN if the name is not a
+ * known one
+ */
+HttpMethod	MethodTable::lookup(const char* name, size_t length)
+{
+	HttpMethod candidate = METHOD_UNKNOWN;
+	
+	switch (length)
+	{
+		case 3:
+			candidate = name[0] == 'G' ? METHOD_GET : METHOD_PUT;
+			break;
+		case 4:
+			candidate = name[0] == 'H' ? METHOD_HEAD : METHOD_POST;
+			break;
+		case 5:
+			candidate = name[0] == 'T' ? METHOD_TRACE : METHOD_PATCH;
+			break;
+		case 6:
+			candidate = METHOD_DELETE;
+			break;
+		case 7:
+			candidate = name[0] == 'C' ? METHOD_CONNECT : METHOD_OPTIONS;
+			break;
+		default:
+			return METHOD_UNKNOWN;
+	}
+	if (memcmp(name, METHOD_NAMES[candidate], length) != 0)
+		return METHOD_UNKNOWN;
+	return candidate;
+}
+
+/**
+ * Get the name of a known method
+ */
+const char*	MethodTable::getName(HttpMethod method)
+{
+	if (method >= METHOD_COUNT)
+		return "";
+	return METHOD_NAMES[method];
+}
+
+/**
+ * Get the bit of a method in a MethodMask
+ */
+MethodMask	MethodTable::getBit(HttpMethod method)
+{
+	return 1u << method;
+}
@@ -0,0 +1,70 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MimeTypes.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/22 10:05:31 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/22 10:05:31 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "MimeTypes.hpp"
+#include <strings.h>
+
+/**
+ * @struct MimeEntry
+ * @brief An extension and its media type
+ */
+struct MimeEntry
+{
+	const char*	extension;
+	const char*	type;
+};
+
+/**
+ * Known extensions, lowercase
+ */
+static const MimeEntry	MIME_TYPES[] = {
+	{"html", "text/html"},
+	{"htm", "text/html"},
+	{"css", "text/css"},
+	{"js", "application/javascript"},
+	{"json", "application/json"},
+	{"xml", "application/xml"},
+	{"txt", "text/plain"},
+	{"jpg", "image/jpeg"},
+	{"jpeg", "image/jpeg"},
+	{"png", "image/png"},
+	{"gif", "image/gif"},
+	{"svg", "image/svg+xml"},
+	{"ico", "image/x-icon"},
+	{"pdf", "application/pdf"},
+	{"zip", "application/zip"},
+	{"mp4", "video/mp4"},
+	{"mp3", "audio/mpeg"}
+};
+
+static const char*	DEFAULT_TYPE = "application/octet-stream";
+
+/**
+ * Get the media type of a file name, application/octet-stream if its
+ * extension is not a known one
+ */
+const char*	MimeTypes::lookup(const std::string& filename)
+{
+	size_t dotPos = filename.find_last_of('.');
+	
+	if (dotPos == std::string::npos)
+		return DEFAULT_TYPE;
+	
+	const char* extension = filename.c_str() + dotPos + 1;
+	
+	for (size_t i = 0; i < sizeof(MIME_TYPES) / sizeof(MIME_TYPES[0]); ++i)
+	{
+		if (strcasecmp(extension, MIME_TYPES[i].extension) == 0)
+			return MIME_TYPES[i].type;
+	}
+	return DEFAULT_TYPE;
+}
@@ -0,0 +1,218 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   OpenFileCache.cpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/22 10:05:31 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/22 10:05:31 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "OpenFileCache.hpp"
+#include "MimeTypes.hpp"
+#include "TimerWheel.hpp"
+#include <cerrno>
+#include <sys/stat.h>
+
+/**
+ * Default constructor, the cache is disabled
+ */
+OpenFileCache::OpenFileCache(void) : _max(0), _valid(0), _errors(false)
+{
+}
+
+/**
+ * Constructor with the entry limit, the validity in milliseconds and
+ * whether failed lookups are cached
+ */
+OpenFileCache::OpenFileCache(size_t max, unsigned long valid, bool errors) :
+	_max(max), _valid(valid), _errors(errors)
+{
+}
+
+/**
+ * Copy constructor, starts empty with the same settings since the
+ * descriptors belong to one thread
+ */
+OpenFileCache::OpenFileCache(const OpenFileCache& other) : _max(other._max),
+	_valid(other._valid), _errors(other._errors)
+{
+}
+
+/**
+ * Destructor, closes the descriptors no response still uses
+ */
+OpenFileCache::~OpenFileCache(void)
+{
+}
+
+/**
+ * Assignment operator, takes the settings and drops the entries
+ */
+OpenFileCache&	OpenFileCache::operator=(const OpenFileCache& other)
+{
+	if (this != &other)
+	{
+		clear();
+		_max = other._max;
+		_valid = other._valid;
+		_errors = other._errors;
+	}
+	return *this;
+}
+
+/**
+ * Open and stat a path without caching it; directories are reported
+ * without keeping them open, and anything else that is not a regular
+ * file is reported as EINVAL
+ */
+void	OpenFileCache::load(const std::string& path, FileInfo& info)
+{
+	struct stat fileStat;
+	
+	info = FileInfo();
+	info.file = FileHandle::open(path);
+	if (!info.file.isOpen())
+	{
+		info.error = errno;
+		return;
+	}
+	if (fstat(info.file.getFd(), &fileStat) != 0)
+	{
+		info.error = errno;
+		info.file.reset();
+		return;
+	}
+	info.isDirectory = S_ISDIR(fileStat.st_mode);
+	info.size = fileStat.st_size;
+	info.mtime = fileStat.st_mtime;
+	info.mtimeNsec = fileStat.st_mtim.tv_nsec;
+	info.inode = fileStat.st_ino;
+	info.device = fileStat.st_dev;
+	if (!S_ISREG(fileStat.st_mode))
+	{
+		if (!info.isDirectory)
+			info.error = EINVAL;
+		info.file.reset();
+		return;
+	}
+	info.mimeType = MimeTypes::lookup(path);
+}
+
+/**
+ * Check whether a failed lookup would fail again the same way; running
+ * out of descriptors or memory is not worth remembering
+ */
+bool	OpenFileCache::isLasting(int error)
+{
+	return error == ENOENT || error == ENOTDIR || error == EACCES 
+		|| error == ENAMETOOLONG || error == ELOOP || error == EINVAL;
+}
+
+/**
+ * Check whether a cached entry still describes the file at its path
+ */
+bool	OpenFileCache::isUnchanged(const Entry& entry)
+{
+	struct stat fileStat;
+	const FileInfo& info = entry.info;
+	
+	if (stat(entry.path.c_str(), &fileStat) != 0)
+		return info.error != 0 && info.error == errno;
+	if (info.error != 0)
+		return false;
+	return fileStat.st_dev == info.device && fileStat.st_ino == info.inode 
+		&& fileStat.st_size == info.size && fileStat.st_mtime == info.mtime 
+		&& fileStat.st_mtim.tv_nsec == info.mtimeNsec
+		&& S_ISDIR(fileStat.st_mode) == info.isDirectory;
+}
+
+/**
+ * Add a fresh entry in front, dropping the least recently used ones
+ * past the limit
+ */
+void	OpenFileCache::insert(const std::string& path, const FileInfo& info, 
+	unsigned long now)
+{
+	Entry entry;
+	
+	entry.path = path;
+	entry.info = info;
+	entry.checkedAt = now;
+	_entries.push_front(entry);
+	_index[path] = _entries.begin();
+	while (_entries.size() > _max)
+	{
+		_index.erase(_entries.back().path);
+		_entries.pop_back();
+	}
+}
+
+/**
+ * Look a path up, from the cache when a recent entry exists
+ */
+FileInfo	OpenFileCache::lookup(const std::string& path)
+{
+	FileInfo info;
+	
+	if (_max == 0)
+	{
+		load(path, info);
+		return info;
+	}
+	
+	unsigned long now = TimerWheel::nowMs();
+	EntryIndex::iterator found = _index.find(path);
+	
+	if (found != _index.end())
+	{
+		EntryList::iterator entry = found->second;
+		
+		if (now - entry->checkedAt < _valid || isUnchanged(*entry))
+		{
+			if (now - entry->checkedAt >= _valid)
+				entry->checkedAt = now;
+			_entries.splice(_entries.begin(), _entries, entry);
+			return entry->info;
+		}
+		_index.erase(found);
+		_entries.erase(entry);
+	}
+	
+	load(path, info);
+	if (info.error == 0 || (_errors && isLasting(info.error)))
+		insert(path, info, now);
+	return info;
+}
+
+/**
+ * Drop the entry of a path known to have changed
+ */
+void	OpenFileCache::forget(const std::string& path)
+{
+	EntryIndex::iterator found = _index.find(path);
+	
+	if (found == _index.end())
+		return;
+	_entries.erase(found->second);
+	_index.erase(found);
+}
+
+/**
+ * Get the number of cached paths
+ */
+size_t	OpenFileCache::size(void) const
+{
+	return _entries.size();
+}
+
+/**
+ * Drop every entry
+ */
+void	OpenFileCache::clear(void)
+{
+	_index.clear();
+	_entries.clear();
+}
@@ -0,0 +1,343 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   RequestBody.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/17 14:12:36 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/17 14:12:36 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "RequestBody.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Block size for reading a spooled body back
+ */
+static const size_t	READ_BLOCK = 65536;
+
+/**
+ * Default constructor, an empty in-memory body
+ */
+RequestBody::RequestBody(void) : _fd(-1), _size(0), _threshold(16384), 
+	_tempPath("/tmp")
+{
+}
+
+/**
+ * Copy constructor, a spooled body shares its file by dup()
+ */
+RequestBody::RequestBody(const RequestBody& other) : 
+	_memory(other._memory),
+	_fd(other._fd >= 0 ? dup(other._fd) : -1),
+	_size(other._size),
+	_threshold(other._threshold),
+	_tempPath(other._tempPath)
+{
+}
+
+/**
+ * Destructor, closing the file releases it
+ */
+RequestBody::~RequestBody(void)
+{
+	if (_fd >= 0)
+		close(_fd);
+}
+
+/**
+ * Assignment operator
+ */
+RequestBody&	RequestBody::operator=(const RequestBody& other)
+{
+	if (this != &other)
+	{
+		if (_fd >= 0)
+			close(_fd);
+		_memory = other._memory;
+		_fd = other._fd >= 0 ? dup(other._fd) : -1;
+		_size = other._size;
+		_threshold = other._threshold;
+		_tempPath = other._tempPath;
+	}
+	return *this;
+}
+
+/**
+ * Set how much is kept in memory and where larger bodies go
+ */
+void	RequestBody::configure(size_t threshold, const std::string& tempPath)
+{
+	_threshold = threshold;
+	_tempPath = tempPath;
+}
+
+/**
+ * Prepare for a body of known length, spooling at once if it will not
+ * fit in memory. Returns false if the file cannot be created.
+ */
+bool	RequestBody::reserve(size_t length)
+{
+	if (_fd >= 0)
+		return true;
+	if (length > _threshold)
+		return spill();
+	_memory.reserve(length);
+	return true;
+}
+
+/**
+ * Add bytes at the end, false on a write error
+ */
+bool	RequestBody::append(const char* data, size_t length)
+{
+	if (_fd < 0 && _size + length > _threshold && !spill())
+		return false;
+	
+	if (_fd >= 0)
+	{
+		if (!writeFile(data, length))
+			return false;
+	}
+	else
+		_memory.append(data, length);
+	_size += length;
+	return true;
+}
+
+/**
+ * Drop the body, keeping the memory part's room for the next one
+ */
+void	RequestBody::clear(void)
+{
+	if (_fd >= 0)
+		close(_fd);
+	_fd = -1;
+	_memory.clear();
+	_size = 0;
+}
+
+/**
+ * Create the temporary file and move the memory part into it
+ */
+bool	RequestBody::spill(void)
+{
+	Logger logger;
+	
+#ifdef O_TMPFILE
+	// Never linked into the directory, the kernel frees it on close
+	_fd = open(_tempPath.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+	if (_fd < 0)
+	{
+		// Filesystem without O_TMPFILE: create a named file and unlink it
+		std::string path = _tempPath + "/webserv_body_XXXXXX";
+		std::vector<char> name(path.begin(), path.end());
+		name.push_back('\0');
+		
+		_fd = mkstemp(&name[0]);
+		if (_fd >= 0)
+		{
+			unlink(&name[0]);
+			fcntl(_fd, F_SETFD, FD_CLOEXEC);
+		}
+	}
+	if (_fd < 0)
+	{
+		logger.tempOss << "Cannot create body file in " << _tempPath << ": " 
+			<< strerror(errno);
+		logger.error();
+		return false;
+	}
+	
+	logger.tempOss << "Spooling request body to a temporary file in " 
+		<< _tempPath;
+	logger.debug();
+	
+	if (!_memory.empty() && !writeFile(_memory.data(), _memory.size()))
+		return false;
+	// Release the memory part, not just its length
+	std::string().swap(_memory);
+	return true;
+}
+
+/**
+ * Write the whole range to the temporary file
+ */
+bool	RequestBody::writeFile(const char* data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t written = write(_fd, data, length);
+		
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			Logger logger;
+			logger.tempOss << "Cannot write request body: " << strerror(errno);
+			logger.error();
+			return false;
+		}
+		data += written;
+		length -= written;
+	}
+	return true;
+}
+
+/**
+ * Read up to length bytes at offset, returns the count read
+ */
+size_t	RequestBody::readAt(char* data, size_t length, size_t offset) const
+{
+	if (offset >= _size)
+		return 0;
+	if (length > _size - offset)
+		length = _size - offset;
+	
+	if (_fd < 0)
+	{
+		memcpy(data, _memory.data() + offset, length);
+		return length;
+	}
+	
+	// pread leaves the file offset alone, it belongs to whoever appends
+	size_t done = 0;
+	
+	while (done < length)
+	{
+		ssize_t got = pread(_fd, data + done, length - done, offset + done);
+		
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			break;
+		done += got;
+	}
+	return done;
+}
+
+/**
+ * Get the body length
+ */
+size_t	RequestBody::size(void) const
+{
+	return _size;
+}
+
+/**
+ * Check whether the body is empty
+ */
+bool	RequestBody::empty(void) const
+{
+	return _size == 0;
+}
+
+/**
+ * Check whether the body lives in the temporary file
+ */
+bool	RequestBody::isSpooled(void) const
+{
+	return _fd >= 0;
+}
+
+/**
+ * Get the temporary file descriptor, -1 while in memory
+ */
+int	RequestBody::getFd(void) const
+{
+	return _fd;
+}
+
+/**
+ * Find needle at or after from, std::string::npos if absent
+ */
+size_t	RequestBody::find(const std::string& needle, size_t from) const
+{
+	if (_fd < 0)
+		return _memory.find(needle, from);
+	if (needle.empty() || needle.size() > READ_BLOCK)
+		return std::string::npos;
+	
+	// Consecutive blocks overlap by needle.size() - 1 bytes so a match
+	// across a block boundary is not missed
+	std::vector<char> block(READ_BLOCK);
+	size_t overlap = needle.size() - 1;
+	
+	while (from + needle.size() <= _size)
+	{
+		size_t got = readAt(&block[0], READ_BLOCK, from);
+		
+		if (got < needle.size())
+			break;
+		
+		const char* begin = &block[0];
+		const char* end = begin + got;
+		const char* match = std::search(begin, end, needle.data(), 
+			needle.data() + needle.size());
+		
+		if (match != end)
+			return from + (match - begin);
+		if (from + got >= _size)
+			break;
+		from += got - overlap;
+	}
+	return std::string::npos;
+}
+
+/**
+ * Copy out part of the body
+ */
+std::string	RequestBody::substr(size_t offset, size_t length) const
+{
+	if (offset >= _size)
+		return "";
+	if (length > _size - offset)
+		length = _size - offset;
+	if (_fd < 0)
+		return _memory.substr(offset, length);
+	
+	std::string result(length, '\0');
+	
+	if (length > 0)
+		result.resize(readAt(&result[0], length, offset));
+	return result;
+}
+
+/**
+ * Stream part of the body into out, false on a read error
+ */
+bool	RequestBody::writeTo(std::ostream& out, size_t offset, 
+			size_t length) const
+{
+	if (_fd < 0)
+	{
+		if (offset < _size)
+			out.write(_memory.data() + offset, 
+				std::min(length, _size - offset));
+		return out.good();
+	}
+	
+	std::vector<char> block(READ_BLOCK);
+	
+	while (length > 0)
+	{
+		size_t got = readAt(&block[0], std::min(length, READ_BLOCK), offset);
+		
+		if (got == 0)
+			return false;
+		out.write(&block[0], got);
+		offset += got;
+		length -= got;
+	}
+	return out.good();
+}
@@ -0,0 +1,296 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ResponseCache.cpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/24 14:12:08 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/24 14:12:08 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ResponseCache.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Changes that make a cached file stale: its bytes, its permissions,
+ * its name, or the directory holding it going away
+ */
+static const uint32_t	WATCH_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB 
+	| IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+/**
+ * Default constructor, the cache is disabled
+ */
+ResponseCache::ResponseCache(void) : _maxSize(0), _maxEntrySize(0), _used(0),
+	_inotifyFd(-1), _files(NULL)
+{
+}
+
+/**
+ * Constructor with the byte limit of all entries and of one body
+ */
+ResponseCache::ResponseCache(size_t maxSize, size_t maxEntrySize) :
+	_maxSize(maxSize), _maxEntrySize(maxEntrySize), _used(0), _inotifyFd(-1),
+	_files(NULL)
+{
+}
+
+/**
+ * Copy constructor, starts empty and stopped with the same settings
+ */
+ResponseCache::ResponseCache(const ResponseCache& other) :
+	_maxSize(other._maxSize), _maxEntrySize(other._maxEntrySize), _used(0),
+	_inotifyFd(-1), _files(NULL)
+{
+}
+
+/**
+ * Destructor, closes the inotify descriptor
+ */
+ResponseCache::~ResponseCache(void)
+{
+	if (_inotifyFd >= 0)
+		close(_inotifyFd);
+}
+
+/**
+ * Assignment operator, takes the settings and drops the entries
+ */
+ResponseCache&	ResponseCache::operator=(const ResponseCache& other)
+{
+	if (this != &other)
+	{
+		clear();
+		_maxSize = other._maxSize;
+		_maxEntrySize = other._maxEntrySize;
+	}
+	return *this;
+}
+
+/**
+ * Open the inotify descriptor, false if the cache stays disabled:
+ * without change notifications an entry could be served stale forever.
+ * Files seen changing are dropped from the open file cache as well, so
+ * the next read does not get the old descriptor and size back.
+ */
+bool	ResponseCache::start(OpenFileCache* files)
+{
+	if (_maxSize == 0 || _inotifyFd >= 0)
+		return _inotifyFd >= 0;
+	_files = files;
+	_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_inotifyFd < 0)
+	{
+		_logger.tempOss << "Response cache disabled, inotify failed: " 
+			<< strerror(errno);
+		_logger.warning();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Get the inotify descriptor to wait on, -1 when disabled
+ */
+int	ResponseCache::getFd(void) const
+{
+	return _inotifyFd;
+}
+
+/**
+ * Get the largest body worth reading into memory for the cache, 0 when
+ * disabled
+ */
+size_t	ResponseCache::getMaxEntrySize(void) const
+{
+	return _inotifyFd >= 0 ? _maxEntrySize : 0;
+}
+
+/**
+ * Answer from the cache, false on a miss
+ */
+bool	ResponseCache::lookup(const ServerConfig* server, const std::string& path,
+	HttpResponse& response)
+{
+	if (_inotifyFd < 0)
+		return false;
+	
+	EntryIndex::iterator found = _index.find(Key(server, path));
+	
+	if (found == _index.end())
+		return false;
+	
+	EntryList::iterator entry = found->second;
+	
+	_entries.splice(_entries.begin(), _entries, entry);
+	response.setShared(200, entry->response, entry->bodyLength);
+	return true;
+}
+
+/**
+ * Keep a 200 answered from a file in memory, unless it is too large or
+ * the file changed since it was read. The watch goes in before the file
+ * is checked again, so no change can fall between the two.
+ */
+void	ResponseCache::store(const ServerConfig* server, const std::string& path,
+	const std::string& filePath, const FileInfo& info, HttpResponse& response)
+{
+	if (_inotifyFd < 0 || response.getStatusCode() != 200 || 
+		response.hasFile() || response.getBodyLength() > _maxEntrySize)
+		return;
+	
+	size_t slash = filePath.find_last_of('/');
+	std::string directory = slash == std::string::npos ? "." 
+		: slash == 0 ? "/" : filePath.substr(0, slash);
+	int watch = inotify_add_watch(_inotifyFd, directory.c_str(), WATCH_MASK);
+	
+	if (watch < 0)
+	{
+		_logger.tempOss << "Not caching " << filePath << ", cannot watch " 
+			<< directory << ": " << strerror(errno);
+		_logger.debug();
+		return;
+	}
+	
+	struct stat fileStat;
+	
+	if (stat(filePath.c_str(), &fileStat) != 0 || 
+		fileStat.st_dev != info.device || fileStat.st_ino != info.inode || 
+		fileStat.st_size != info.size || fileStat.st_mtime != info.mtime || 
+		fileStat.st_mtim.tv_nsec != info.mtimeNsec)
+		return;
+	
+	Key key(server, path);
+	EntryIndex::iterator found = _index.find(key);
+	
+	if (found != _index.end())
+		erase(found->second);
+	
+	Entry entry;
+	
+	entry.key = key;
+	entry.response = response.share();
+	entry.bodyLength = response.getBodyLength();
+	entry.file = filePath;
+	entry.watch = watch;
+	entry.name = filePath.substr(slash + 1);
+	if (entry.response.size() > _maxSize)
+		return;
+	_entries.push_front(entry);
+	_index[key] = _entries.begin();
+	_used += entry.response.size();
+	while (_used > _maxSize)
+		erase(--_entries.end());
+	
+	_logger.tempOss << "Cached " << path << " (" << entry.response.size() 
+		<< " bytes, " << _used << " in use)";
+	_logger.debug();
+}
+
+/**
+ * Drop one entry
+ */
+void	ResponseCache::erase(EntryList::iterator entry)
+{
+	_used -= entry->response.size();
+	_index.erase(entry->key);
+	_entries.erase(entry);
+}
+
+/**
+ * Drop the entries of a file in a watched directory, or of the whole
+ * directory when name is NULL
+ */
+void	ResponseCache::invalidate(int watch, const char* name)
+{
+	EntryList::iterator it = _entries.begin();
+	
+	while (it != _entries.end())
+	{
+		EntryList::iterator entry = it++;
+		
+		if (entry->watch == watch && (!name || entry->name == name))
+		{
+			_logger.tempOss << "Dropped cached " << entry->key.second;
+			_logger.debug();
+			if (_files)
+				_files->forget(entry->file);
+			erase(entry);
+		}
+	}
+}
+
+/**
+ * Drop the entries read from a file this thread just changed, without
+ * waiting for its inotify event: a request pipelined behind the change
+ * would be answered before the event is read
+ */
+void	ResponseCache::forget(const std::string& file)
+{
+	EntryList::iterator it = _entries.begin();
+	
+	while (it != _entries.end())
+	{
+		EntryList::iterator entry = it++;
+		
+		if (entry->file == file)
+			erase(entry);
+	}
+}
+
+/**
+ * Read the pending inotify events and drop what they invalidate
+ */
+void	ResponseCache::handleEvents(void)
+{
+	// Aligned for struct inotify_event
+	long buffer[1024];
+	ssize_t got;
+	
+	while ((got = read(_inotifyFd, buffer, sizeof(buffer))) > 0)
+	{
+		const char* bytes = reinterpret_cast<const char*>(buffer);
+		
+		for (ssize_t offset = 0; offset < got; )
+		{
+			const struct inotify_event* event = 
+				reinterpret_cast<const struct inotify_event*>(bytes + offset);
+			
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				clear();
+				if (_files)
+					_files->clear();
+			}
+			else if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+				invalidate(event->wd, NULL);
+			else if (event->len > 0)
+				invalidate(event->wd, event->name);
+			offset += sizeof(struct inotify_event) + event->len;
+		}
+	}
+}
+
+/**
+ * Get the number of cached responses
+ */
+size_t	ResponseCache::size(void) const
+{
+	return _entries.size();
+}
+
+/**
+ * Drop every entry
+ */
+void	ResponseCache::clear(void)
+{
+	_index.clear();
+	_entries.clear();
+	_used = 0;
+}
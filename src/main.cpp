@@ -13,29 +13,93 @@
 #include <iostream>
 #include <cstdlib>
 #include <csignal>
+#include <unistd.h>
 #include "Server.hpp"
+#include "Master.hpp"
 #include "Config.hpp"
 #include "Logger.hpp"
 
 bool	g_running = true;
+bool	g_draining = false;
 
 /**
  * Signal handler to gracefully shutdown the server
+ * (SIGHUP only drains: the master has new workers listening by then)
  */
 void	signalHandler(int signum)
 {
-	(void)signum;
+	if (signum == SIGHUP)
+	{
+		g_draining = true;
+		return;
+	}
 	g_running = false;
 	std::cout << "\nShutting down server..." << std::endl;
 }
 
 /**
  * Setup signal handlers for graceful shutdown
+ * A peer gone mid-sendfile() must fail the call with EPIPE rather than
+ * kill the process, and sendfile() has no MSG_NOSIGNAL
  */
 void	setupSignals(void)
 {
 	signal(SIGINT, signalHandler);
 	signal(SIGTERM, signalHandler);
+	signal(SIGHUP, signalHandler);
+	signal(SIGPIPE, SIG_IGN);
+}
+
+/**
+ * Run a Server until a shutdown signal arrives, or until its last
+ * connection is done once SIGHUP asked it to drain
+ * Used directly in single-process mode and by every worker process,
+ * which writes its pid to readyFd once it listens
+ */
+int	runServer(const Config& config, int readyFd)
+{
+	Logger logger;
+	try
+	{
+		// Setup signal handlers
+		setupSignals();
+		
+		// Create and start the server; under the master it shares its
+		// listeners with the other workers
+		Server server(config, readyFd >= 0);
+		server.start();
+		if (readyFd >= 0)
+		{
+			pid_t pid = getpid();
+			
+			if (write(readyFd, &pid, sizeof(pid)) < 0)
+			{
+				logger.tempOss << "Failed to report ready to the master";
+				logger.error();
+			}
+			close(readyFd);
+		}
+		
+		// Main server loop
+		while (g_running)
+		{
+			if (g_draining)
+			{
+				server.drain();
+				if (server.isIdle())
+					break;
+			}
+			server.run();
+		}
+		
+		return (EXIT_SUCCESS);
+	}
+	catch (const std::exception &e)
+	{
+		logger.tempOss << e.what();
+		logger.error();
+		return (EXIT_FAILURE);
+	}
 }
 
 /**
@@ -69,18 +133,15 @@ int	main(int argc, char **argv)
 		// Parse configuration file
 		Config config(configPath);
 		
-		// Setup signal handlers
-		setupSignals();
+		// Several workers are supervised by a master process, which stays
+		// in charge on reload even if the new configuration asks for one
+		if (config.getWorkerProcesses() > 1)
+		{
+			Master master(configPath, config, runServer);
+			return master.run();
+		}
 		
-		// Create and start the server
-		Server server(config);
-		server.start();
-		
-		// Main server loop
-		while (g_running)
-			server.run();
-		
-		return (EXIT_SUCCESS);
+		return runServer(config, -1);
 	}
 	catch (const std::exception &e)
 	{
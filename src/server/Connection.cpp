@@ -0,0 +1,67 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Connection.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/05 15:02:11 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/05 15:02:11 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Connection.hpp"
+
+/**
+ * Default constructor, the connection starts closed (fd -1)
+ */
+Connection::Connection(void) : fd(-1), state(CONN_IDLE), vhosts(NULL),
+	server(NULL), http2(NULL), receiving(false)
+{
+}
+
+/**
+ * Take ownership of an accepted descriptor
+ */
+void	Connection::open(int clientFd, const struct sockaddr_in& addr,
+			const VirtualHostTable* listenerHosts)
+{
+	fd = clientFd;
+	state = CONN_IDLE;
+	vhosts = listenerHosts;
+	server = listenerHosts->getDefault();
+	socket.reset(clientFd, addr);
+	stats = ConnectionStats();
+	stats.acceptedAt = time(NULL);
+}
+
+/**
+ * Wait for the next request, keeping the connection open; routing
+ * goes back to the listener's default server until the next Host,
+ * and memory a large request grew is given back
+ */
+void	Connection::waitForRequest(void)
+{
+	state = CONN_IDLE;
+	request.shrink();
+	if (vhosts)
+		server = vhosts->getDefault();
+}
+
+/**
+ * Close the descriptor and drop the per-request state so the object
+ * can be reused for another connection
+ */
+void	Connection::close(void)
+{
+	socket.close();
+	request = HttpRequest();
+	responses.clear();
+	delete http2;
+	http2 = NULL;
+	receiving = false;
+	state = CONN_IDLE;
+	fd = -1;
+	vhosts = NULL;
+	server = NULL;
+}
@@ -0,0 +1,551 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Master.cpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/08/29 14:32:10 by josfelip          #+#    #+#             */
+/*   Updated: 2025/08/29 14:32:10 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Master.hpp"
+#include "TimerWheel.hpp"
+#include <sys/wait.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#ifdef __linux__
+# include <sys/prctl.h>
+#endif
+
+/**
+ * Delay before restarting a worker that died right after it started;
+ * it grows with each failure in a row
+ */
+static const unsigned long	RESPAWN_DELAY_MS = 1000;
+
+/**
+ * A worker that dies before reporting ready, or this soon after its
+ * start, failed to start
+ */
+static const unsigned long	QUICK_EXIT_MS = 1000;
+
+/**
+ * Failed starts in a row after which a slot is no longer restarted
+ */
+static const int			MAX_QUICK_EXITS = 5;
+
+/**
+ * How often retiring workers are sent SIGHUP again, in case the first
+ * one came just before their event loop went to sleep
+ */
+static const int			RETIRE_SIGNAL_MS = 1000;
+
+/**
+ * Signals observed by the master, processed outside the handler
+ */
+static volatile sig_atomic_t	g_masterTerminate = 0;
+static volatile sig_atomic_t	g_masterReload = 0;
+static volatile sig_atomic_t	g_masterChildExited = 0;
+
+/**
+ * Master signal handler, only records what happened
+ */
+static void	masterSignalHandler(int signum)
+{
+	if (signum == SIGTERM || signum == SIGINT)
+		g_masterTerminate = 1;
+	else if (signum == SIGHUP)
+		g_masterReload = 1;
+	else if (signum == SIGCHLD)
+		g_masterChildExited = 1;
+}
+
+/**
+ * Remove a pid from a list, false if it was not there
+ */
+static bool	removePid(std::vector<pid_t>& pids, pid_t pid)
+{
+	std::vector<pid_t>::iterator it = std::find(pids.begin(), pids.end(), pid);
+	
+	if (it == pids.end())
+		return false;
+	pids.erase(it);
+	return true;
+}
+
+/**
+ * Constructor with the configuration and the worker entry point
+ */
+Master::Master(const std::string& configPath, const Config& config,
+	WorkerMain workerMain) : _configPath(configPath), _config(config),
+	_workerMain(workerMain)
+{
+	_readyFds[0] = -1;
+	_readyFds[1] = -1;
+	sigemptyset(&_originalMask);
+}
+
+/**
+ * Private copy constructor - not implemented, workers are owned
+ */
+Master::Master(const Master& other) : _configPath(other._configPath),
+	_config(other._config), _workerMain(other._workerMain)
+{
+	_readyFds[0] = -1;
+	_readyFds[1] = -1;
+}
+
+/**
+ * Private assignment operator - not implemented, workers are owned
+ */
+Master&	Master::operator=(const Master& other)
+{
+	(void)other;
+	return *this;
+}
+
+/**
+ * Destructor
+ */
+Master::~Master(void)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		if (_readyFds[i] >= 0)
+			close(_readyFds[i]);
+	}
+}
+
+/**
+ * Install the master signal handlers and block them outside ppoll
+ */
+void	Master::setupSignals(void)
+{
+	struct sigaction action;
+	sigset_t blocked;
+	
+	// No SA_RESTART: ppoll() must return as soon as a signal arrives
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = masterSignalHandler;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGHUP, &action, NULL);
+	sigaction(SIGCHLD, &action, NULL);
+	
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGTERM);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGHUP);
+	sigaddset(&blocked, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &blocked, &_originalMask);
+}
+
+/**
+ * Fork the worker of a slot
+ */
+void	Master::spawnWorker(size_t slot)
+{
+	Worker& worker = _workers[slot];
+	
+	worker.ready = false;
+	worker.retryAt = 0;
+	
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		_logger.tempOss << "Failed to fork worker " << slot << ": " 
+			<< strerror(errno);
+		_logger.error();
+		worker.pid = 0;
+		worker.retryAt = TimerWheel::nowMs() + RESPAWN_DELAY_MS;
+		return;
+	}
+	
+	if (pid == 0)
+	{
+		// Worker: default dispositions, unblocked signals, own Server
+		signal(SIGCHLD, SIG_DFL);
+		signal(SIGHUP, SIG_DFL);
+		sigprocmask(SIG_SETMASK, &_originalMask, NULL);
+#ifdef __linux__
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+		close(_readyFds[0]);
+		std::exit(_workerMain(_config, _readyFds[1]));
+	}
+	
+	worker.pid = pid;
+	worker.spawnedAt = TimerWheel::nowMs();
+	_logger.tempOss << "Started worker " << slot << " (pid " << pid << ")";
+	_logger.info();
+}
+
+/**
+ * Restart the slots whose delay after a failed start has passed
+ */
+void	Master::respawnDue(void)
+{
+	unsigned long now = TimerWheel::nowMs();
+	
+	for (size_t slot = 0; slot < _workers.size(); slot++)
+	{
+		if (_workers[slot].pid == 0 && _workers[slot].retryAt != 0 && 
+			_workers[slot].retryAt <= now)
+			spawnWorker(slot);
+	}
+}
+
+/**
+ * Get the milliseconds until the next restart or retiring signal, -1 if
+ * nothing is timed
+ */
+int	Master::nextTimeout(void) const
+{
+	unsigned long now = TimerWheel::nowMs();
+	int timeout = _retiring.empty() ? -1 : RETIRE_SIGNAL_MS;
+	
+	for (size_t slot = 0; slot < _workers.size(); slot++)
+	{
+		const Worker& worker = _workers[slot];
+		
+		if (worker.pid != 0 || worker.retryAt == 0)
+			continue;
+		
+		int wait = worker.retryAt > now 
+			? static_cast<int>(worker.retryAt - now) : 0;
+		
+		if (timeout < 0 || wait < timeout)
+			timeout = wait;
+	}
+	return timeout;
+}
+
+/**
+ * Mark the workers that reported their listeners open; each report is
+ * one pid_t, written atomically to the pipe
+ */
+void	Master::readReady(void)
+{
+	pid_t pids[64];
+	ssize_t got;
+	
+	while ((got = read(_readyFds[0], pids, sizeof(pids))) > 0)
+	{
+		for (size_t i = 0; i < got / sizeof(pid_t); i++)
+		{
+			for (size_t slot = 0; slot < _workers.size(); slot++)
+			{
+				if (_workers[slot].pid != pids[i])
+					continue;
+				_workers[slot].ready = true;
+				_workers[slot].failures = 0;
+				_logger.tempOss << "Worker " << slot << " (pid " << pids[i] 
+					<< ") is listening";
+				_logger.debug();
+				break;
+			}
+		}
+	}
+	retirePrevious();
+}
+
+/**
+ * Tell the previous generation to drain once every slot of the new one
+ * is ready or given up; until then it keeps accepting, so the port is
+ * never left without a listener
+ */
+void	Master::retirePrevious(void)
+{
+	if (_previous.empty())
+		return;
+	
+	bool anyReady = false;
+	
+	for (size_t slot = 0; slot < _workers.size(); slot++)
+	{
+		const Worker& worker = _workers[slot];
+		
+		if (worker.ready)
+			anyReady = true;
+		else if (worker.pid != 0 || worker.retryAt != 0)
+			return;
+	}
+	if (!anyReady)
+	{
+		_logger.tempOss << "No new worker could start, the previous ones " 
+			<< "keep serving";
+		_logger.error();
+		return;
+	}
+	
+	_logger.tempOss << "New workers ready, draining " << _previous.size() 
+		<< " previous workers";
+	_logger.info();
+	for (size_t i = 0; i < _previous.size(); i++)
+	{
+		kill(_previous[i], SIGHUP);
+		_retiring.push_back(_previous[i]);
+	}
+	_previous.clear();
+}
+
+/**
+ * Collect exited workers and restart the slots that are still wanted
+ */
+void	Master::reapWorkers(void)
+{
+	int status;
+	pid_t pid;
+	
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+	{
+		if (removePid(_retiring, pid) || removePid(_previous, pid))
+		{
+			_logger.tempOss << "Previous worker (pid " << pid << ") exited";
+			_logger.info();
+			continue;
+		}
+		
+		for (size_t slot = 0; slot < _workers.size(); slot++)
+		{
+			Worker& worker = _workers[slot];
+			
+			if (worker.pid != pid)
+				continue;
+				
+			worker.pid = 0;
+			if (WIFSIGNALED(status))
+			{
+				_logger.tempOss << "Worker " << slot << " (pid " << pid 
+					<< ") killed by signal " << WTERMSIG(status);
+				_logger.warning();
+			}
+			else if (WEXITSTATUS(status) != EXIT_SUCCESS)
+			{
+				_logger.tempOss << "Worker " << slot << " (pid " << pid 
+					<< ") exited with status " << WEXITSTATUS(status);
+				_logger.warning();
+			}
+			else
+			{
+				_logger.tempOss << "Worker " << slot << " (pid " << pid 
+					<< ") exited";
+				_logger.info();
+			}
+			
+			// A worker that served for a while is replaced at once; one
+			// that keeps failing to start is retried later, then dropped
+			unsigned long now = TimerWheel::nowMs();
+			
+			if (worker.ready && now - worker.spawnedAt >= QUICK_EXIT_MS)
+			{
+				worker.failures = 0;
+				spawnWorker(slot);
+			}
+			else if (++worker.failures >= MAX_QUICK_EXITS)
+			{
+				worker.ready = false;
+				_logger.tempOss << "Worker " << slot << " failed to start " 
+					<< worker.failures << " times in a row, not restarting it";
+				_logger.error();
+			}
+			else
+			{
+				worker.ready = false;
+				worker.retryAt = now + RESPAWN_DELAY_MS * worker.failures;
+			}
+			break;
+		}
+	}
+	retirePrevious();
+}
+
+/**
+ * Check whether any worker runs or is about to be restarted
+ */
+bool	Master::hasWorkers(void) const
+{
+	if (!_previous.empty() || !_retiring.empty())
+		return true;
+	for (size_t slot = 0; slot < _workers.size(); slot++)
+	{
+		if (_workers[slot].pid != 0 || _workers[slot].retryAt != 0)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Re-read the configuration file and start a new worker generation; the
+ * running workers serve until it is ready, then drain
+ */
+void	Master::reload(void)
+{
+	_logger.tempOss << "Reloading configuration from " << _configPath;
+	_logger.info();
+	
+	try
+	{
+		Config fresh(_configPath);
+		_config = fresh;
+	}
+	catch (const std::exception& e)
+	{
+		_logger.tempOss << "Reload failed, keeping current configuration: " 
+			<< e.what();
+		_logger.error();
+		return;
+	}
+	
+	// A generation that was still starting is replaced as well
+	for (size_t slot = 0; slot < _workers.size(); slot++)
+	{
+		if (_workers[slot].pid != 0)
+			_previous.push_back(_workers[slot].pid);
+	}
+	
+	size_t wanted = static_cast<size_t>(_config.getWorkerProcesses());
+	
+	_workers.assign(wanted, Worker());
+	for (size_t slot = 0; slot < wanted; slot++)
+		spawnWorker(slot);
+}
+
+/**
+ * Send a signal to every running worker, old generations included
+ */
+void	Master::signalWorkers(int signum)
+{
+	for (size_t slot = 0; slot < _workers.size(); slot++)
+	{
+		if (_workers[slot].pid > 0)
+			kill(_workers[slot].pid, signum);
+	}
+	for (size_t i = 0; i < _previous.size(); i++)
+		kill(_previous[i], signum);
+	for (size_t i = 0; i < _retiring.size(); i++)
+		kill(_retiring[i], signum);
+}
+
+/**
+ * Forward SIGTERM and wait for every worker to exit
+ */
+void	Master::shutdown(void)
+{
+	_logger.tempOss << "Master shutting down workers";
+	_logger.info();
+	
+	signalWorkers(SIGTERM);
+	
+	std::vector<pid_t> pids(_previous);
+	
+	pids.insert(pids.end(), _retiring.begin(), _retiring.end());
+	for (size_t slot = 0; slot < _workers.size(); slot++)
+	{
+		if (_workers[slot].pid > 0)
+			pids.push_back(_workers[slot].pid);
+		_workers[slot].pid = 0;
+		_workers[slot].retryAt = 0;
+	}
+	for (size_t i = 0; i < pids.size(); i++)
+	{
+		while (waitpid(pids[i], NULL, 0) < 0 && errno == EINTR)
+			;
+	}
+	_previous.clear();
+	_retiring.clear();
+}
+
+/**
+ * Spawn the workers and supervise them until shutdown
+ */
+int	Master::run(void)
+{
+	setupSignals();
+	
+	// Workers report on this pipe once they listen
+	if (pipe(_readyFds) < 0)
+		throw std::runtime_error("Failed to create worker pipe: " 
+			+ std::string(strerror(errno)));
+	for (int i = 0; i < 2; i++)
+	{
+		fcntl(_readyFds[i], F_SETFL, O_NONBLOCK);
+		fcntl(_readyFds[i], F_SETFD, FD_CLOEXEC);
+	}
+	
+	size_t count = static_cast<size_t>(_config.getWorkerProcesses());
+	_workers.assign(count, Worker());
+	
+	_logger.tempOss << "Master process " << getpid() << " starting " 
+		<< count << " workers";
+	_logger.info();
+	
+	for (size_t slot = 0; slot < count; slot++)
+		spawnWorker(slot);
+	
+	// Signals are only delivered inside ppoll(), so no flag is lost
+	sigset_t waitMask = _originalMask;
+	sigdelset(&waitMask, SIGTERM);
+	sigdelset(&waitMask, SIGINT);
+	sigdelset(&waitMask, SIGHUP);
+	sigdelset(&waitMask, SIGCHLD);
+	
+	int status = EXIT_SUCCESS;
+	
+	while (!g_masterTerminate)
+	{
+		if (g_masterReload)
+		{
+			g_masterReload = 0;
+			reload();
+		}
+		if (g_masterChildExited)
+		{
+			g_masterChildExited = 0;
+			reapWorkers();
+		}
+		respawnDue();
+		if (!hasWorkers())
+		{
+			_logger.tempOss << "No worker left to supervise";
+			_logger.error();
+			status = EXIT_FAILURE;
+			break;
+		}
+		if (g_masterTerminate || g_masterReload || g_masterChildExited)
+			continue;
+		
+		struct pollfd ready;
+		struct timespec wait;
+		int timeout = nextTimeout();
+		
+		ready.fd = _readyFds[0];
+		ready.events = POLLIN;
+		ready.revents = 0;
+		wait.tv_sec = timeout / 1000;
+		wait.tv_nsec = (timeout % 1000) * 1000000L;
+		
+		int events = ppoll(&ready, 1, timeout < 0 ? NULL : &wait, &waitMask);
+		
+		if (events > 0)
+			readReady();
+		else if (events == 0)
+		{
+			for (size_t i = 0; i < _retiring.size(); i++)
+				kill(_retiring[i], SIGHUP);
+		}
+	}
+	
+	shutdown();
+	sigprocmask(SIG_SETMASK, &_originalMask, NULL);
+	return (status);
+}
@@ -12,37 +12,68 @@
 
 #include "Server.hpp"
 #include <iostream>
-#include <sys/select.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cerrno>
 #include <cstring>
+#include <stdexcept>
+#include <csignal>
+
+/**
+ * Responses a connection may have queued before its pipelined requests
+ * stop being parsed; they are sent together in one gathered write
+ */
+static const size_t	MAX_PIPELINE_DEPTH = 16;
+
+/**
+ * How often a draining acceptor looks at its shards' connection counts,
+ * since nothing wakes it up once its listeners are closed
+ */
+static const int	DRAIN_CHECK_MS = 100;
 
 /**
  * Default constructor initializes an empty server
  */
-Server::Server(void) : _config(NULL), _maxFd(-1)
+Server::Server(void) : _config(NULL), _supervised(false), _poller(NULL), _nextShard(0),
+	_connectionCount(0), _running(false), _drainRequested(false), 
+	_draining(false)
 {
-	FD_ZERO(&_readFds);
-	FD_ZERO(&_writeFds);
-	FD_ZERO(&_errorFds);
+	pthread_mutex_init(&_handoffMutex, NULL);
+	_wakeFds[0] = -1;
+	_wakeFds[1] = -1;
 }
 
 /**
- * Constructor initializes server with provided configuration
+ * Constructor initializes server with provided configuration; a server
+ * supervised by the master shares its listeners with the other workers
+ * and generations
  */
-Server::Server(const Config& config) : _config(&config), _maxFd(-1)
+Server::Server(const Config& config, bool supervised) : _config(&config), 
+	_supervised(supervised), _poller(NULL),
+	_fileCache(config.getOpenFileCacheMax(), config.getOpenFileCacheValid(),
+		config.getOpenFileCacheErrors()),
+	_responseCache(config.getResponseCacheSize(), 
+		config.getResponseCacheEntry()),
+	_nextShard(0), _connectionCount(0), _running(false), 
+	_drainRequested(false), _draining(false)
 {
-	FD_ZERO(&_readFds);
-	FD_ZERO(&_writeFds);
-	FD_ZERO(&_errorFds);
+	pthread_mutex_init(&_handoffMutex, NULL);
+	_wakeFds[0] = -1;
+	_wakeFds[1] = -1;
 }
 
 /**
  * Private copy constructor - not implemented to prevent copying
  */
-Server::Server(const Server& other) : _config(other._config)
+Server::Server(const Server& other) : _config(other._config), 
+	_supervised(other._supervised), _poller(NULL),
+	_fileCache(other._fileCache), _responseCache(other._responseCache),
+	_nextShard(0), _connectionCount(0), _running(false), 
+	_drainRequested(false), _draining(false)
 {
+	pthread_mutex_init(&_handoffMutex, NULL);
+	_wakeFds[0] = -1;
+	_wakeFds[1] = -1;
 	// Not implemented - copying a server with active connections
 	// is not allowed as it would duplicate file descriptors
 }
@@ -63,35 +94,56 @@ Server&	Server::operator=(const Server& other)
 Server::~Server(void)
 {
 	stop();
+	pthread_mutex_destroy(&_handoffMutex);
+}
+
+/**
+ * Return the listening socket owning fd, or NULL for client sockets
+ */
+Socket*	Server::findListenSocket(int fd)
+{
+	for (std::vector<Socket>::iterator it = _listenSockets.begin();
+		it != _listenSockets.end(); ++it)
+	{
+		if (it->getFd() == fd)
+			return &(*it);
+	}
+	return NULL;
 }
 
 /**
- * Initialize server sockets for all configured hosts/ports
+ * Initialize one listening socket per configured address; server blocks
+ * sharing an address share its socket and are told apart by Host
  */
 void	Server::initializeSockets(void)
 {
 	if (!_config)
 		throw std::runtime_error("No configuration provided for server");
 		
-	std::vector<ServerConfig> servers = _config->getServers();
+	const std::vector<ListenConfig>& listeners = _config->getListeners();
 	
-	for (std::vector<ServerConfig>::iterator it = servers.begin();
-		it != servers.end(); ++it)
+	for (std::vector<ListenConfig>::const_iterator it = listeners.begin();
+		it != listeners.end(); ++it)
 	{
 		try
 		{
 			Socket socket(it->host, it->port);
 			socket.setNonBlocking();
+			
+			// Every worker process binds its own copy of the listener,
+			// and so does the next generation on a reload, whatever
+			// worker count the reloaded configuration asks for
+			if (_supervised)
+				socket.setReusePort();
 			socket.bind();
-			socket.listen();
+			socket.listen(it->backlog);
 			
+			// Accepts complete in the backend when it can, with no
+			// readiness round trip
+			if (!_poller->addAcceptor(socket.getFd()))
+				_poller->add(socket.getFd(), EVENT_READ);
 			_listenSockets.push_back(socket);
-			int fd = socket.getFd();
-			
-			FD_SET(fd, &_readFds);
-			
-			if (fd > _maxFd)
-				_maxFd = fd;
+			_listenHosts[socket.getFd()] = &it->vhosts;
 				
 			_logger.tempOss << "Server listening on " << it->host << ":" 
 				<< it->port;
@@ -110,282 +162,881 @@ void	Server::initializeSockets(void)
 }
 
 /**
- * Accept new client connections on listening sockets
+ * Accept the pending client connections on a ready listening socket,
+ * draining the queue until it is empty or accept_batch is reached so one
+ * busy listener cannot starve the other descriptors
  */
-void Server::acceptConnections(fd_set *readFdsReady)
+void Server::acceptConnections(Socket& listenSocket)
 {
-    for (std::vector<Socket>::iterator it = _listenSockets.begin();
-        it != _listenSockets.end(); ++it)
-    {
-        int listenFd = it->getFd();
+    _logger.tempOss << "Listen socket " << listenSocket.getFd() 
+        << " is ready for accepting";
+        _logger.debug();
         
-        if (FD_ISSET(listenFd, readFdsReady))
+    const VirtualHostTable* vhosts = _listenHosts[listenSocket.getFd()];
+    int batch = _config->getAcceptBatch();
+    int accepted = 0;
+    
+    try
+    {
+        while (accepted < batch)
         {
-            _logger.tempOss << "Listen socket " << listenFd 
-                << " is ready for accepting";
-                _logger.debug();
+            struct sockaddr_in clientAddr;
+            int clientFd = listenSocket.accept(clientAddr);
+            
+            // The accept queue is empty
+            if (clientFd < 0)
+                break;
                 
-            try
-            {
-                Socket clientSocket = it->accept();
-                // Check if accept returned a valid socket
-                if (clientSocket.getFd() >= 0)
-                {
-                    clientSocket.setNonBlocking();
-                    
-                    int clientFd = clientSocket.getFd();
-                    _clientSockets[clientFd] = clientSocket;
-                    
-                    FD_SET(clientFd, &_readFds);
-                    
-                    if (clientFd > _maxFd)
-                        _maxFd = clientFd;
-                        
-                    _logger.tempOss << "New connection accepted: fd " << clientFd;
-                    _logger.info();
-                }
-            }
-            catch (const std::exception& e)
-            {
-                _logger.tempOss << "Failed to accept connection: " 
-                    << e.what();
-                    _logger.error();
-            }
+            accepted++;
+            if (!_shards.empty())
+                pickShard()->adoptConnection(clientFd, clientAddr, vhosts);
+            else
+                addConnection(clientFd, clientAddr, vhosts);
         }
     }
+    catch (const std::exception& e)
+    {
+        _logger.tempOss << "Failed to accept connection: " 
+            << e.what();
+            _logger.error();
+    }
+    
+    _logger.tempOss << "Accepted " << accepted << " connections on fd " 
+        << listenSocket.getFd();
+    _logger.debug();
 }
 
 /**
- * Handle client requests by reading from ready sockets
+ * Take a connection the event backend accepted on a listening socket;
+ * its peer address is looked up only if something asks for it
  */
-void	Server::handleRequests(fd_set *readFdsReady)
+void	Server::acceptCompleted(Socket& listenSocket, int clientFd)
 {
-	if (!_config)
+	if (clientFd < 0)
+	{
+		// A client that reset before being accepted is not an error
+		if (clientFd != -EAGAIN && clientFd != -ECONNABORTED)
+		{
+			_logger.tempOss << "Failed to accept connection: " 
+				<< strerror(-clientFd);
+			_logger.error();
+		}
+		return;
+	}
+	
+	const VirtualHostTable* vhosts = _listenHosts[listenSocket.getFd()];
+	struct sockaddr_in unknown;
+	
+	memset(&unknown, 0, sizeof(unknown));
+	if (!_shards.empty())
+		pickShard()->adoptConnection(clientFd, unknown, vhosts);
+	else
+		addConnection(clientFd, unknown, vhosts);
+}
+
+/**
+ * Register an accepted descriptor in this server's event loop
+ */
+void	Server::addConnection(int clientFd, const struct sockaddr_in& addr,
+			const VirtualHostTable* vhosts)
+{
+	bool receiving;
+	
+	try
+	{
+		// Already non-blocking, accepted with SOCK_NONBLOCK
+		receiving = _poller->addReceiver(clientFd, EVENT_READ);
+		if (!receiving)
+			_poller->add(clientFd, EVENT_READ);
+	}
+	catch (const std::exception& e)
+	{
+		_logger.tempOss << "Failed to register connection: " << e.what();
+		_logger.error();
+		::close(clientFd);
 		return;
+	}
+	
+	if (static_cast<size_t>(clientFd) >= _connections.size())
+		_connections.resize(clientFd + 1, NULL);
 		
-	std::vector<int> toRemove;
+	// Reuse a released connection object when there is one
+	Connection* conn;
+	if (!_freeConnections.empty())
+	{
+		conn = _freeConnections.back();
+		_freeConnections.pop_back();
+	}
+	else
+		conn = new Connection();
+	conn->open(clientFd, addr, vhosts);
+	conn->receiving = receiving;
+	_connections[clientFd] = conn;
+	_timers.schedule(clientFd, TIMER_HEADER, conn->server->clientHeaderTimeout);
 	
-	for (std::map<int, Socket>::iterator it = _clientSockets.begin();
-		it != _clientSockets.end(); ++it)
+	pthread_mutex_lock(&_handoffMutex);
+	_connectionCount++;
+	pthread_mutex_unlock(&_handoffMutex);
+	
+	_logger.tempOss << "New connection accepted: fd " << clientFd;
+	_logger.info();
+}
+
+/**
+ * Create the worker threads and their shard servers
+ */
+void	Server::startShards(int count)
+{
+	sigset_t blocked;
+	sigset_t previous;
+	
+	// Shutdown signals must reach the main thread, not a shard
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGTERM);
+	sigaddset(&blocked, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	
+	for (int i = 0; i < count; i++)
 	{
-		int clientFd = it->first;
+		Server* shard = new Server(*_config);
+		pthread_t thread;
 		
-		if (FD_ISSET(clientFd, readFdsReady))
+		try
 		{
-		    _logger.tempOss << "Client socket " << clientFd 
-                << " is ready for reading";
-                _logger.debug();
-                
-			try
-			{
-				if (!_requests.count(clientFd))
-				{
-				    _logger.tempOss << "Creating new request for fd " 
-                        << clientFd;
-                        _logger.debug();
-					_requests[clientFd] = HttpRequest();
-					
-					// Set default server config for size validation during parsing
-					// Use the first available server config as default
-					const std::vector<ServerConfig>& servers = _config->getServers();
-					if (!servers.empty())
-					{
-						_requests[clientFd].setServerConfig(&servers[0]);
-					}
-				}
-					
-				HttpRequest& request = _requests[clientFd];
-				
-				bool requestComplete = request.read(it->second);
-				_logger.tempOss << "Request read returned: " 
-                    << (requestComplete ? "COMPLETE" : "INCOMPLETE");
-                    _logger.debug();
-				
-				if (requestComplete)
-				{
-					// Request is complete, process it
-					_logger.tempOss << "Processing request and generating response";
-                        _logger.debug();
-					HttpResponse response = request.process(*_config);
-					_responses[clientFd] = response;
-					
-					// Switch to writing mode
-					_logger.tempOss << "Switching socket " << clientFd 
-                        << " to write mode";
-                        _logger.debug();
-					FD_CLR(clientFd, &_readFds);
-					FD_SET(clientFd, &_writeFds);
-				}
-				else
-				{
-					// Check if it's a real connection error or just incomplete request
-					if (request.hasConnectionError())
-					{
-						_logger.tempOss << "Connection error on fd " << clientFd 
-							<< ", marking for removal";
-						_logger.debug();
-						toRemove.push_back(clientFd);
-					}
-					else
-					{
-						_logger.tempOss << "Request on fd " << clientFd 
-							<< " incomplete, waiting for more data";
-						_logger.debug();
-						// Keep connection open for more data
-					}
-				}
-			}
-			catch (const std::exception& e)
+			shard->startShard();
+		}
+		catch (const std::exception&)
+		{
+			delete shard;
+			pthread_sigmask(SIG_SETMASK, &previous, NULL);
+			throw;
+		}
+		if (pthread_create(&thread, NULL, &Server::threadMain, shard) != 0)
+		{
+			delete shard;
+			pthread_sigmask(SIG_SETMASK, &previous, NULL);
+			throw std::runtime_error("Failed to create worker thread");
+		}
+		_shards.push_back(shard);
+		_threads.push_back(thread);
+	}
+	
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	_logger.tempOss << "Started " << count << " worker threads ("
+		<< (_config->getThreadBalance() == BALANCE_LEAST_CONN 
+			? "least_conn" : "round_robin") << ")";
+	_logger.info();
+}
+
+/**
+ * Prepare a server that only runs an event loop for handed-off clients
+ */
+void	Server::startShard(void)
+{
+	_poller = EventPoller::create(_config->getEventBackend());
+	
+	if (pipe(_wakeFds) < 0)
+		throw std::runtime_error("Failed to create wake-up pipe: " 
+			+ std::string(strerror(errno)));
+	for (int i = 0; i < 2; i++)
+	{
+		fcntl(_wakeFds[i], F_SETFL, O_NONBLOCK);
+		fcntl(_wakeFds[i], F_SETFD, FD_CLOEXEC);
+	}
+	_poller->add(_wakeFds[0], EVENT_READ);
+	startResponseCache();
+	_running = true;
+}
+
+/**
+ * Start watching for file changes if this loop caches responses
+ */
+void	Server::startResponseCache(void)
+{
+	if (_responseCache.start(&_fileCache))
+		_poller->add(_responseCache.getFd(), EVENT_READ);
+}
+
+/**
+ * Pick the shard that receives the next connection
+ */
+Server*	Server::pickShard(void)
+{
+	if (_config->getThreadBalance() == BALANCE_LEAST_CONN)
+	{
+		Server* best = _shards[0];
+		size_t bestCount = best->getConnectionCount();
+		
+		for (size_t i = 1; i < _shards.size(); i++)
+		{
+			size_t count = _shards[i]->getConnectionCount();
+			if (count < bestCount)
 			{
-				_logger.tempOss << "Error handling request on fd " << clientFd 
-					<< ": " << e.what();
-                    _logger.error();
-				toRemove.push_back(clientFd);
+				best = _shards[i];
+				bestCount = count;
 			}
 		}
+		return best;
 	}
 	
-	// Clean up any failed connections
-	for (std::vector<int>::iterator it = toRemove.begin();
-		it != toRemove.end(); ++it)
+	Server* shard = _shards[_nextShard];
+	_nextShard = (_nextShard + 1) % _shards.size();
+	return shard;
+}
+
+/**
+ * Hand an accepted connection to this shard (called by the acceptor)
+ */
+void	Server::adoptConnection(int clientFd, const struct sockaddr_in& addr,
+			const VirtualHostTable* vhosts)
+{
+	Handoff pending;
+	
+	pending.fd = clientFd;
+	pending.addr = addr;
+	pending.vhosts = vhosts;
+	pthread_mutex_lock(&_handoffMutex);
+	_handoff.push_back(pending);
+	// Counted now so least_conn sees connections still in the queue
+	_connectionCount++;
+	pthread_mutex_unlock(&_handoffMutex);
+	
+	wake();
+}
+
+/**
+ * Wake a shard up through its pipe. This runs on the acceptor thread
+ * while the shard logs from its own, so a failure is reported through
+ * a logger of the caller's, never through the shard's stream.
+ */
+void	Server::wake(void)
+{
+	char byte = 0;
+	
+	if (write(_wakeFds[1], &byte, 1) < 0 && errno != EAGAIN)
+	{
+		Logger logger;
+		
+		logger.tempOss << "Failed to wake worker thread: " << strerror(errno);
+		logger.error();
+	}
+}
+
+/**
+ * Register the connections queued by the acceptor
+ */
+void	Server::drainHandoff(void)
+{
+	char buffer[256];
+	std::vector<Handoff> pending;
+	
+	while (read(_wakeFds[0], buffer, sizeof(buffer)) > 0)
+		;
+		
+	pthread_mutex_lock(&_handoffMutex);
+	pending.swap(_handoff);
+	_connectionCount -= pending.size();
+	bool drain = _drainRequested;
+	pthread_mutex_unlock(&_handoffMutex);
+	
+	for (size_t i = 0; i < pending.size(); i++)
+		addConnection(pending[i].fd, pending[i].addr, pending[i].vhosts);
+	if (drain && !_draining)
 	{
-		FD_CLR(*it, &_readFds);
-		FD_CLR(*it, &_writeFds);
-		_clientSockets.erase(*it);
-		_requests.erase(*it);
-		_responses.erase(*it);
-		close(*it);
+		_draining = true;
+		closeIdleConnections();
 	}
 }
 
+/**
+ * Get the number of open connections (used for least_conn balancing)
+ */
+size_t	Server::getConnectionCount(void)
+{
+	pthread_mutex_lock(&_handoffMutex);
+	size_t count = _connectionCount;
+	pthread_mutex_unlock(&_handoffMutex);
+	return count;
+}
 
 /**
- * Send responses to clients with ready write descriptors
+ * Check whether a shard should keep running its loop
  */
-void Server::sendResponses(fd_set *writeFdsReady)
+bool	Server::isRunning(void)
 {
-    _logger.tempOss << "Checking for sockets ready to write";
-    _logger.debug();
+	pthread_mutex_lock(&_handoffMutex);
+	bool running = _running;
+	pthread_mutex_unlock(&_handoffMutex);
+	return running;
+}
+
+/**
+ * Ask a shard to leave its loop and wake it up
+ */
+void	Server::requestStop(void)
+{
+	pthread_mutex_lock(&_handoffMutex);
+	_running = false;
+	pthread_mutex_unlock(&_handoffMutex);
+	
+	wake();
+}
+
+/**
+ * Ask a shard to finish its connections without keeping them alive
+ */
+void	Server::requestDrain(void)
+{
+	pthread_mutex_lock(&_handoffMutex);
+	_drainRequested = true;
+	pthread_mutex_unlock(&_handoffMutex);
+	
+	wake();
+}
+
+/**
+ * Close the connections waiting for a request and send GOAWAY on the
+ * HTTP/2 ones, once the server drains. Connections that never sent a
+ * request are left to send it: closing them would fail a request the
+ * client has no reason to retry.
+ */
+void	Server::closeIdleConnections(void)
+{
+	for (size_t fd = 0; fd < _connections.size(); fd++)
+	{
+		Connection* conn = _connections[fd];
+		
+		if (!conn)
+			continue;
+		if (conn->http2)
+		{
+			conn->http2->goAway();
+			if (!conn->http2->flush(conn->socket))
+				closeConnection(fd);
+			else
+				updateHttp2(conn);
+		}
+		else if (conn->state == CONN_IDLE && conn->stats.requests > 0 && 
+			!conn->request.hasReceivedData())
+			closeConnection(fd);
+	}
+}
+
+/**
+ * Thread entry point running a shard event loop
+ */
+void*	Server::threadMain(void* arg)
+{
+	Server* shard = static_cast<Server*>(arg);
+	
+	while (shard->isRunning())
+		shard->run();
+	return NULL;
+}
+
+/**
+ * Get the open connection behind fd, or NULL
+ */
+Connection*	Server::findConnection(int fd) const
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _connections.size())
+		return NULL;
+	return _connections[fd];
+}
+
+/**
+ * Handle a client request on a readable socket, or on the data the event
+ * backend received for it
+ */
+void	Server::handleRequest(int clientFd, const PollEvent& event)
+{
+	if (!_config)
+		return;
+		
+	Connection* conn = findConnection(clientFd);
+	if (!conn)
+		return;
+		
+    _logger.tempOss << "Client socket " << clientFd 
+        << " is ready for reading";
+        _logger.debug();
+        
+	try
+	{
+		if (conn->state == CONN_IDLE)
+		{
+		    _logger.tempOss << "Creating new request for fd " 
+                << clientFd;
+                _logger.debug();
+			conn->state = CONN_READING;
+			
+			// The request picks its vhost from this table once headers end
+			conn->request.setVirtualHosts(conn->vhosts);
+			conn->request.setFileCache(&_fileCache);
+			conn->request.setResponseCache(&_responseCache);
+			conn->request.setClientAddress(conn->socket.getAddress());
+			
+			// A new request on a kept-alive connection starts its header clock
+			if (_timers.getKind(clientFd) == TIMER_KEEPALIVE)
+				_timers.schedule(clientFd, TIMER_HEADER, 
+					conn->server->clientHeaderTimeout);
+		}
+			
+		HttpRequest& request = conn->request;
+		
+		bool requestComplete;
+		
+		if (event.events & EVENT_RECEIVED)
+			requestComplete = request.receive(conn->socket, event.data, 
+				event.result);
+		else
+			requestComplete = request.read(conn->socket);
+		
+		// Timeouts follow the vhost as soon as the Host header is known
+		conn->server = request.getServerConfig();
+		_logger.tempOss << "Request read returned: " 
+            << (requestComplete ? "COMPLETE" : "INCOMPLETE");
+            _logger.debug();
+		
+		if (requestComplete)
+		{
+			// Request is complete, answer it and any pipelined after it
+			_logger.tempOss << "Processing request and generating response";
+                _logger.debug();
+			queueResponses(conn);
+		}
+		else if (request.hasConnectionError())
+		{
+			_logger.tempOss << "Connection error on fd " << clientFd 
+				<< ", closing";
+			_logger.debug();
+			closeConnection(clientFd);
+		}
+		else
+		{
+			_logger.tempOss << "Request on fd " << clientFd 
+				<< " incomplete, waiting for more data";
+			_logger.debug();
+			// Keep connection open for more data, the body timeout counts
+			// from the last successful read
+			if (request.isReadingBody())
+				_timers.schedule(clientFd, TIMER_BODY, 
+					conn->server->clientBodyTimeout);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		_logger.tempOss << "Error handling request on fd " << clientFd 
+			<< ": " << e.what();
+            _logger.error();
+		closeConnection(clientFd);
+	}
+}
+
+/**
+ * Answer every complete request received so far, in order, and
+ * switch the connection to writing
+ */
+void	Server::queueResponses(Connection* conn)
+{
+	HttpRequest& request = conn->request;
+	
+	if (conn->responses.empty() && startHttp2(conn))
+		return;
+	
+	// Pipelined requests are answered in the order they arrived, until
+	// one is incomplete or ends the connection, or enough responses wait
+	do
+	{
+		conn->responses.push_back(request.process(*_config));
+		if (!request.wantsKeepAlive() || _draining)
+			conn->responses.back().setKeepAlive(false);
+		conn->stats.requests++;
+		conn->server = request.getServerConfig();
+		if (!conn->responses.back().shouldKeepAlive() || 
+			conn->server->keepaliveTimeout == 0)
+			break;
+		request.reset();
+	}
+	while (conn->responses.size() < MAX_PIPELINE_DEPTH && 
+		request.resume());
+	
+	_logger.tempOss << "Switching socket " << conn->fd << " to write mode with "
+		<< conn->responses.size() << " responses queued";
+	_logger.debug();
+	conn->state = CONN_WRITING;
+	_poller->modify(conn->fd, EVENT_WRITE);
+	_timers.schedule(conn->fd, TIMER_SEND, conn->server->sendTimeout);
+}
+
+/**
+ * Hand the connection to an HTTP/2 session if its request opened with
+ * the h2c preface or asked to upgrade, false otherwise
+ */
+bool	Server::startHttp2(Connection* conn)
+{
+	HttpRequest& request = conn->request;
+	bool preface = request.isHttp2Preface();
+	
+	if (!preface && !request.wantsHttp2Upgrade())
+		return false;
+	
+	Http2Session* session = new Http2Session(*_config, conn->vhosts, 
+		&_fileCache, conn->socket.getAddress());
+	
+	if (preface)
+		session->start();
+	else if (!session->upgrade(request))
+	{
+		// Bad HTTP2-Settings: the request is answered in HTTP/1.1
+		delete session;
+		return false;
+	}
+	
+	_logger.tempOss << "Connection on fd " << conn->fd << " switched to h2c";
+	_logger.debug();
+	conn->http2 = session;
+	
+	// Frames that came along with the request belong to the session
+	Buffer pending;
+	
+	request.takeBuffered(pending);
+	session->receive(pending.data(), pending.size());
+	if (_draining)
+		session->goAway();
+	if (!session->flush(conn->socket))
+	{
+		closeConnection(conn->fd);
+		return true;
+	}
+	updateHttp2(conn);
+	return true;
+}
+
+/**
+ * Read and write frames on an HTTP/2 connection
+ */
+void	Server::serveHttp2(Connection* conn, const PollEvent& event)
+{
+	Http2Session* session = conn->http2;
+	bool open = true;
+	
+	try
+	{
+		// A receiving connection learns of errors from its receive
+		if (event.events & EVENT_RECEIVED)
+		{
+			open = event.result > 0;
+			if (open)
+				session->receive(event.data, event.result);
+		}
+		else if (event.events & (EVENT_READ | EVENT_ERROR))
+			open = !conn->receiving && session->read(conn->socket);
+		if (!open)
+		{
+			conn->stats.requests = session->getAnswered();
+			_logger.tempOss << "HTTP/2 connection on fd " << conn->fd 
+				<< " closed by peer";
+			_logger.debug();
+			closeConnection(conn->fd);
+			return;
+		}
+		if (!session->flush(conn->socket))
+		{
+			closeConnection(conn->fd);
+			return;
+		}
+		updateHttp2(conn);
+	}
+	catch (const std::exception& e)
+	{
+		_logger.tempOss << "Error serving HTTP/2 on fd " << conn->fd 
+			<< ": " << e.what();
+		_logger.error();
+		closeConnection(conn->fd);
+	}
+}
+
+/**
+ * Pick the events and timer an HTTP/2 connection waits on next
+ */
+void	Server::updateHttp2(Connection* conn)
+{
+	Http2Session* session = conn->http2;
+	
+	conn->stats.requests = session->getAnswered();
+	if (session->isFinished())
+	{
+		closeConnection(conn->fd);
+		return;
+	}
+	
+	// Reading never stops: WINDOW_UPDATE and new streams can come at any
+	// time, even while responses are waiting on the socket
+	bool writing = session->hasOutput();
+	ConnectionState state = writing ? CONN_WRITING : CONN_READING;
+	
+	if (conn->state != state)
+	{
+		_poller->modify(conn->fd, writing ? EVENT_READ | EVENT_WRITE 
+			: EVENT_READ);
+		conn->state = state;
+	}
+	if (writing)
+		_timers.schedule(conn->fd, TIMER_SEND, conn->server->sendTimeout);
+	else if (session->hasStreams())
+		_timers.schedule(conn->fd, TIMER_BODY, 
+			conn->server->clientBodyTimeout);
+	else
+		_timers.schedule(conn->fd, TIMER_KEEPALIVE, 
+			conn->server->keepaliveTimeout);
+}
+
+/**
+ * Send the queued responses on a writable socket
+ */
+void Server::sendResponse(int clientFd)
+{
+    Connection* conn = findConnection(clientFd);
     
-    std::vector<int> toRemove;
-    std::vector<int> toKeepAlive;  // New vector to track connections to keep alive
+    if (!conn || conn->state != CONN_WRITING || conn->responses.empty())
+    {
+        _logger.tempOss << "Error: No pending response for fd " << clientFd;
+        _logger.error();
+        closeConnection(clientFd);
+        return;
+    }
     
-    for (std::map<int, HttpResponse>::iterator it = _responses.begin();
-        it != _responses.end(); ++it)
+    try
     {
-        int clientFd = it->first;
+        HttpResponse& front = conn->responses.front();
+        bool fromFile = front.isSendingFile();
+        ssize_t sent;
         
-        // Validate file descriptor before using it
-        if (clientFd < 0 || clientFd >= FD_SETSIZE) {
-            _logger.tempOss << "Error: Invalid file descriptor " << clientFd;
-            _logger.error();
-            toRemove.push_back(clientFd);
-            continue;
+        if (fromFile)
+        {
+            // The head is out, the body goes from the page cache
+            sent = front.sendFile(conn->socket);
         }
-        
-        _logger.tempOss << "Checking if socket " << clientFd 
-            << " is ready for writing: " 
-            << (FD_ISSET(clientFd, writeFdsReady) ? "YES" : "NO");
-            _logger.debug();
-            
-        if (FD_ISSET(clientFd, writeFdsReady))
+        else
         {
-            try
+            // Up to two parts per response: its own head, then the
+            // head fields and body shared with the response cache
+            struct iovec buffers[MAX_PIPELINE_DEPTH * 2];
+            size_t count = 0;
+            
+            // Every queued response goes out in one gathered write, up
+            // to the head of one whose body is a file
+            for (std::deque<HttpResponse>::iterator it = 
+                conn->responses.begin(); it != conn->responses.end() && 
+                count < MAX_PIPELINE_DEPTH * 2; ++it)
             {
-                HttpResponse& response = it->second;
-                
-                // Check if client socket exists before accessing it
-                if (_clientSockets.find(clientFd) == _clientSockets.end()) {
-                    _logger.tempOss << "Error: Client socket not found for fd " 
-                        << clientFd;
-                        _logger.error();
-                    toRemove.push_back(clientFd);
-                    continue;
-                }
-                
-                _logger.tempOss << "Attempting to send response on fd " 
-                    << clientFd;
-                    _logger.debug();
-                    
-                if (response.send(_clientSockets[clientFd]))
-                {
-                    // Response fully sent, either keep-alive or close
-                    _logger.tempOss << "Response fully sent on fd " 
-                        << clientFd;
-                        _logger.debug();
-                        
-                    if (response.shouldKeepAlive())
-                    {
-                        // Mark for keep-alive processing AFTER we finish iterating
-                        _logger.tempOss << "Marking connection for keep-alive: " 
-                            << clientFd;
-                            _logger.debug();
-                        toKeepAlive.push_back(clientFd);
-                    }
-                    else
-                    {
-                        _logger.tempOss << "Connection will be closed";
-                        _logger.debug();
-                        toRemove.push_back(clientFd);
-                    }
-                }
-                else
-                {
-                    _logger.tempOss << "Response not fully sent yet, "
-                        << "will try again later";
-                        _logger.debug();
-                }
+                count += it->getPending(buffers + count, 
+                    MAX_PIPELINE_DEPTH * 2 - count);
+                if (it->hasFile())
+                    break;
             }
-            catch (const std::exception& e)
+            
+            _logger.tempOss << "Sending " << count << " responses on fd " 
+                << clientFd;
+                _logger.debug();
+                
+            sent = conn->socket.sendv(buffers, count);
+        }
+        
+        if (sent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                return;
+            throw std::runtime_error("Failed to send response: " + 
+                std::string(strerror(errno)));
+        }
+        
+        // Retire the responses that went out completely, in order
+        size_t left = fromFile ? 0 : sent;
+        
+        while (!conn->responses.empty())
+        {
+            HttpResponse& response = conn->responses.front();
+            
+            left -= response.markSent(left);
+            if (!response.isSent())
+                break;
+            if (!response.shouldKeepAlive() || 
+                conn->server->keepaliveTimeout == 0)
             {
-                _logger.tempOss << "Error sending response on fd " << clientFd 
-                    << ": " << e.what();
-                    _logger.error();
-                toRemove.push_back(clientFd);
+                _logger.tempOss << "Connection will be closed";
+                _logger.debug();
+                closeConnection(clientFd);
+                return;
             }
+            conn->responses.pop_front();
         }
-    }
-    
-    // Process keep-alive connections AFTER iteration is complete
-    for (std::vector<int>::iterator it = toKeepAlive.begin();
-         it != toKeepAlive.end(); ++it)
-    {
-        int clientFd = *it;
-        _logger.tempOss << "Keeping connection alive, "
-            << "switching " << clientFd << " back to read mode";
-            _logger.debug();
         
-        // Reset for new request
-        _requests.erase(clientFd);
-        _responses.erase(clientFd);
-        FD_CLR(clientFd, &_writeFds);
-        FD_SET(clientFd, &_readFds);
-    }
-    
-    // Clean up connections we're done with
-    for (std::vector<int>::iterator it = toRemove.begin();
-        it != toRemove.end(); ++it)
-    {
-        int clientFd = *it;
-        _logger.tempOss << "Closing connection: " << clientFd;
+        if (!conn->responses.empty())
+        {
+            _logger.tempOss << "Responses not fully sent yet, "
+                << "will try again later";
+                _logger.debug();
+            _timers.schedule(clientFd, TIMER_SEND, conn->server->sendTimeout);
+            return;
+        }
+        
+        _logger.tempOss << "Responses fully sent on fd " << clientFd;
         _logger.debug();
         
-        FD_CLR(clientFd, &_readFds);
-        FD_CLR(clientFd, &_writeFds);
-        _clientSockets.erase(clientFd);
-        _requests.erase(clientFd);
-        _responses.erase(clientFd);
-        close(clientFd);
-        _logger.tempOss << "Connection closed: fd " << clientFd;
-        _logger.info();
+        // The next request may be waiting in full behind the last one
+        HttpRequest& request = conn->request;
+        
+        if (request.resume())
+        {
+            queueResponses(conn);
+            return;
+        }
+        // Nothing is ahead of its interim response any more
+        request.continueIfOwed(conn->socket);
+        if (request.hasConnectionError())
+        {
+            closeConnection(clientFd);
+            return;
+        }
+        
+        _poller->modify(clientFd, EVENT_READ);
+        if (request.hasReceivedData())
+        {
+            // Part of it is: its clocks run from now
+            conn->state = CONN_READING;
+            conn->server = request.getServerConfig();
+            if (request.isReadingBody())
+                _timers.schedule(clientFd, TIMER_BODY, 
+                    conn->server->clientBodyTimeout);
+            else
+                _timers.schedule(clientFd, TIMER_HEADER, 
+                    conn->server->clientHeaderTimeout);
+        }
+        else if (_draining)
+        {
+            closeConnection(clientFd);
+        }
+        else
+        {
+            _logger.tempOss << "Keeping connection alive, "
+                << "switching " << clientFd << " back to read mode";
+                _logger.debug();
+            conn->waitForRequest();
+            _timers.schedule(clientFd, TIMER_KEEPALIVE, 
+                conn->server->keepaliveTimeout);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        _logger.tempOss << "Error sending response on fd " << clientFd 
+            << ": " << e.what();
+            _logger.error();
+        closeConnection(clientFd);
     }
 }
+
+/**
+ * React to an expired connection timer
+ */
+void	Server::handleTimeout(const TimerEvent& timer)
+{
+	int clientFd = timer.id;
+	Connection* conn = findConnection(clientFd);
+	
+	if (!conn)
+		return;
+		
+	bool partial = timer.kind == TIMER_BODY || (timer.kind == TIMER_HEADER 
+		&& conn->state == CONN_READING && conn->request.hasReceivedData());
+	
+	_logger.tempOss << "Timeout on fd " << clientFd << " while " 
+		<< (timer.kind == TIMER_HEADER ? "reading headers"
+			: timer.kind == TIMER_BODY ? "reading body"
+			: timer.kind == TIMER_KEEPALIVE ? "idle in keep-alive" 
+			: "sending");
+	_logger.info();
+	
+	// Idle clients and stalled readers are not worth an answer, and an
+	// HTTP/2 connection has no single request to answer
+	if (!partial || conn->state == CONN_WRITING || conn->http2)
+	{
+		closeConnection(clientFd);
+		return;
+	}
+	
+	HttpResponse response;
+	
+	response.setStatus(408);
+	response.setBody(_config->getDefaultErrorPage(408));
+	response.setKeepAlive(false);
+	conn->responses.clear();
+	conn->responses.push_back(response);
+	conn->state = CONN_WRITING;
+	
+	try
+	{
+		_poller->modify(clientFd, EVENT_WRITE);
+		_timers.schedule(clientFd, TIMER_SEND, conn->server->sendTimeout);
+	}
+	catch (const std::exception& e)
+	{
+		_logger.tempOss << "Error answering timeout on fd " << clientFd 
+			<< ": " << e.what();
+		_logger.error();
+		closeConnection(clientFd);
+	}
+}
+
+/**
+ * Close a client connection and drop its state
+ */
+void	Server::closeConnection(int clientFd)
+{
+	_logger.tempOss << "Closing connection: " << clientFd;
+	_logger.debug();
+	
+	Connection* conn = findConnection(clientFd);
+	if (!conn)
+		return;
+		
+	_poller->remove(clientFd);
+	_timers.cancel(clientFd);
+	
+	_logger.tempOss << "Connection closed: fd " << clientFd << " ("
+		<< conn->stats.requests << " requests in " 
+		<< (time(NULL) - conn->stats.acceptedAt) << "s)";
+	_logger.info();
+	
+	// The socket handle owns the descriptor and closes it
+	conn->close();
+	_connections[clientFd] = NULL;
+	_freeConnections.push_back(conn);
+	
+	pthread_mutex_lock(&_handoffMutex);
+	_connectionCount--;
+	pthread_mutex_unlock(&_handoffMutex);
+}
+
 /**
  * Start the server by initializing sockets
  */
 void	Server::start(void)
 {
+	if (!_config)
+		throw std::runtime_error("No configuration provided for server");
+		
+	_poller = EventPoller::create(_config->getEventBackend());
+	_logger.tempOss << "Using " << _poller->getName() << " event backend";
+	_logger.info();
+	
 	initializeSockets();
+	if (_config->getWorkerThreads() > 0)
+		startShards(_config->getWorkerThreads());
+	else
+		startResponseCache();
 	_logger.tempOss << "Server started successfully";
     _logger.info();
 }
@@ -395,63 +1046,138 @@ void	Server::start(void)
  */
 void	Server::run(void)
 {
-    // Create temporary copies for select() to modify
-    fd_set readFdsCopy;
-    fd_set writeFdsCopy;
-    fd_set errorFdsCopy;
+    if (!_poller)
+        return;
+        
+    // Never sleep past the next connection timer
+    int timeout = _timers.nextTimeout();
     
-    // Copy the master sets to the temporary sets
-    readFdsCopy = _readFds;
-    writeFdsCopy = _writeFds;
-    errorFdsCopy = _errorFds;
+    if (_draining && !_shards.empty() && 
+        (timeout < 0 || timeout > DRAIN_CHECK_MS))
+        timeout = DRAIN_CHECK_MS;
     
-    // Show which file descriptors we're monitoring
-    int actualFdCount = 0;
-    for (int i = 0; i <= _maxFd; i++) {
-        if (FD_ISSET(i, &_readFds) || FD_ISSET(i, &_writeFds)) {
-            _logger.tempOss << "Monitoring fd " << i;
-            if (FD_ISSET(i, &_readFds) && FD_ISSET(i, &_writeFds)) {
-                _logger.tempOss << " (read+write)";
-            } else if (FD_ISSET(i, &_readFds)) {
-                _logger.tempOss << " (read)";
-            } else {
-                _logger.tempOss << " (write)";
-            }
-            _logger.debug();
-            actualFdCount++;
-        }
-    }
-    _logger.tempOss << "select() checking range 0-" << _maxFd 
-        << " (" << _maxFd + 1 << " total), actually monitoring " 
-        << actualFdCount << " file descriptors";
-        _logger.debug();
-    
-    int activity = select(_maxFd + 1, &readFdsCopy, &writeFdsCopy, 
-        &errorFdsCopy, NULL);
+    int ready = _poller->wait(_ready, timeout);
     
-    if (activity < 0)
+    if (ready < 0)
     {
         if (errno != EINTR) // Ignore if interrupted by signal
         {
-            _logger.tempOss << "Select error: " << strerror(errno);
+            _logger.tempOss << _poller->getName() << " error: " 
+                << strerror(errno);
             _logger.error();
         }
         return;
     }
-    else if (activity == 0) 
-    {
-        // Timeout occurred, no activity
-        return;
-    }
     
-    _logger.tempOss << "select() returned " << activity 
+    _logger.tempOss << _poller->getName() << " returned " << ready 
         << " ready file descriptors";
         _logger.debug();
       
-    // Process I/O events
-    acceptConnections(&readFdsCopy);
-    handleRequests(&readFdsCopy);
-    sendResponses(&writeFdsCopy);
+    // Dispatch only the descriptors the backend reported as ready
+    for (size_t i = 0; i < _ready.size(); i++)
+    {
+        int fd = _ready[i].fd;
+        int events = _ready[i].events;
+        
+        if (fd == _wakeFds[0])
+        {
+            drainHandoff();
+            continue;
+        }
+        
+        if (fd == _responseCache.getFd())
+        {
+            _responseCache.handleEvents();
+            continue;
+        }
+        
+        Socket* listenSocket = findListenSocket(fd);
+        if (listenSocket)
+        {
+            if (events & EVENT_ACCEPTED)
+                acceptCompleted(*listenSocket, _ready[i].result);
+            else
+                acceptConnections(*listenSocket);
+            continue;
+        }
+        
+        // A previous event in this batch may have closed the connection
+        Connection* conn = findConnection(fd);
+        if (!conn)
+            continue;
+        
+        if (conn->http2)
+        {
+            serveHttp2(conn, _ready[i]);
+            continue;
+        }
+        
+        // Data received under a response is kept for the next request
+        if ((events & EVENT_RECEIVED) && conn->state == CONN_WRITING)
+            conn->request.stash(_ready[i].data, _ready[i].result);
+        else if (events & (EVENT_READ | EVENT_ERROR | EVENT_RECEIVED))
+        {
+            if (conn->state == CONN_WRITING && (events & EVENT_ERROR))
+                closeConnection(fd);
+            else if (conn->state != CONN_WRITING)
+                handleRequest(fd, _ready[i]);
+        }
+        // handleRequest may have closed and released the connection
+        if ((events & EVENT_WRITE) && findConnection(fd) == conn 
+            && !conn->http2 && conn->state == CONN_WRITING)
+            sendResponse(fd);
+    }
+    
+    _timers.expire(_fired);
+    for (size_t i = 0; i < _fired.size(); i++)
+        handleTimeout(_fired[i]);
+}
+
+/**
+ * Stop accepting and let the open connections finish their current
+ * requests, for a graceful reload. Another generation of workers holds
+ * its own SO_REUSEPORT copy of every listener by now.
+ */
+void	Server::drain(void)
+{
+	if (_draining)
+		return;
+	
+	_logger.tempOss << "Draining: closing listeners, " << getConnectionCount() 
+		<< " connections left";
+	_logger.info();
+	
+	// Connections already in a listener's queue would be reset when it
+	// closes, so they are taken first
+	for (std::vector<Socket>::iterator it = _listenSockets.begin();
+		it != _listenSockets.end(); ++it)
+	{
+		acceptConnections(*it);
+		_poller->remove(it->getFd());
+		close(it->getFd());
+	}
+	_listenSockets.clear();
+	_listenHosts.clear();
+	
+	_draining = true;
+	for (size_t i = 0; i < _shards.size(); i++)
+		_shards[i]->requestDrain();
+	closeIdleConnections();
+}
+
+/**
+ * Check whether a draining server has no connection left
+ */
+bool	Server::isIdle(void)
+{
+	if (getConnectionCount() > 0)
+		return false;
+	for (size_t i = 0; i < _shards.size(); i++)
+	{
+		if (_shards[i]->getConnectionCount() > 0)
+			return false;
+	}
+	return true;
 }
 
 /**
@@ -459,11 +1185,27 @@ void	Server::run(void)
  */
 void	Server::stop(void)
 {
-	for (std::map<int, Socket>::iterator it = _clientSockets.begin();
-		it != _clientSockets.end(); ++it)
+	for (size_t i = 0; i < _shards.size(); i++)
+	{
+		_shards[i]->requestStop();
+		pthread_join(_threads[i], NULL);
+		delete _shards[i];
+	}
+	_shards.clear();
+	_threads.clear();
+	
+	for (size_t fd = 0; fd < _connections.size(); fd++)
 	{
-		close(it->first);
+		if (_connections[fd])
+		{
+			_connections[fd]->close();
+			delete _connections[fd];
+		}
 	}
+	for (size_t i = 0; i < _freeConnections.size(); i++)
+		delete _freeConnections[i];
+	_connections.clear();
+	_freeConnections.clear();
 	
 	for (std::vector<Socket>::iterator it = _listenSockets.begin();
 		it != _listenSockets.end(); ++it)
@@ -471,11 +1213,25 @@ void	Server::stop(void)
 		close(it->getFd());
 	}
 	
-	_clientSockets.clear();
+	for (int i = 0; i < 2; i++)
+	{
+		if (_wakeFds[i] >= 0)
+			close(_wakeFds[i]);
+		_wakeFds[i] = -1;
+	}
+	
+	// Connections still queued for a shard that never picked them up
+	for (size_t i = 0; i < _handoff.size(); i++)
+		close(_handoff[i].fd);
+	_handoff.clear();
+	
+	delete _poller;
+	_poller = NULL;
+	
 	_listenSockets.clear();
-	_requests.clear();
-	_responses.clear();
+	_listenHosts.clear();
+	_timers = TimerWheel();
 	
 	_logger.tempOss << "Server stopped";
     _logger.info();
-}
\ No newline at end of file
+}
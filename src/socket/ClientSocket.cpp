@@ -0,0 +1,192 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ClientSocket.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/08 09:41:52 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/08 09:41:52 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ClientSocket.hpp"
+#include <unistd.h>
+#include <cstring>
+#include <arpa/inet.h>
+#include <sys/sendfile.h>
+
+/**
+ * Default constructor, the handle starts empty (fd -1)
+ */
+ClientSocket::ClientSocket(void) : _fd(-1)
+{
+	memset(&_addr, 0, sizeof(_addr));
+}
+
+/**
+ * Constructor taking ownership of an accepted descriptor
+ */
+ClientSocket::ClientSocket(int fd, const struct sockaddr_in& addr) : 
+	_fd(fd), _addr(addr)
+{
+}
+
+/**
+ * Private copy constructor - a descriptor has a single owner
+ */
+ClientSocket::ClientSocket(const ClientSocket& other) : _fd(-1)
+{
+	(void)other;
+	memset(&_addr, 0, sizeof(_addr));
+}
+
+/**
+ * Private assignment operator - a descriptor has a single owner
+ */
+ClientSocket&	ClientSocket::operator=(const ClientSocket& other)
+{
+	(void)other;
+	return *this;
+}
+
+/**
+ * Destructor closes the descriptor it still owns
+ */
+ClientSocket::~ClientSocket(void)
+{
+	close();
+}
+
+/**
+ * Close the current descriptor, then take ownership of fd
+ */
+void	ClientSocket::reset(int fd, const struct sockaddr_in& addr)
+{
+	if (fd != _fd)
+		close();
+	_fd = fd;
+	_addr = addr;
+}
+
+/**
+ * Give up ownership without closing, returns the descriptor
+ */
+int	ClientSocket::release(void)
+{
+	int fd = _fd;
+	
+	_fd = -1;
+	return fd;
+}
+
+/**
+ * Close the descriptor
+ */
+void	ClientSocket::close(void)
+{
+	if (_fd >= 0)
+	{
+		::close(_fd);
+		_fd = -1;
+	}
+}
+
+/**
+ * Send data, never raising SIGPIPE on a closed peer
+ */
+ssize_t	ClientSocket::send(const void* buffer, size_t length)
+{
+#ifdef MSG_NOSIGNAL
+	return ::send(_fd, buffer, length, MSG_NOSIGNAL);
+#else
+	return ::send(_fd, buffer, length, 0);
+#endif
+}
+
+/**
+ * Send several buffers in one call, never raising SIGPIPE
+ */
+ssize_t	ClientSocket::sendv(const struct iovec* buffers, size_t count)
+{
+	struct msghdr message;
+	
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = const_cast<struct iovec*>(buffers);
+	message.msg_iovlen = count;
+#ifdef MSG_NOSIGNAL
+	return ::sendmsg(_fd, &message, MSG_NOSIGNAL);
+#else
+	return ::sendmsg(_fd, &message, 0);
+#endif
+}
+
+/**
+ * Send part of a file straight from the page cache, advancing offset
+ * past the bytes sent
+ */
+ssize_t	ClientSocket::sendFile(int fileFd, off_t& offset, size_t length)
+{
+	return ::sendfile(_fd, fileFd, &offset, length);
+}
+
+/**
+ * Receive data
+ */
+ssize_t	ClientSocket::recv(void* buffer, size_t length)
+{
+	return ::recv(_fd, buffer, length, 0);
+}
+
+/**
+ * Get the descriptor, -1 when empty
+ */
+int	ClientSocket::getFd(void) const
+{
+	return _fd;
+}
+
+/**
+ * Get the peer address in binary form, looked up on first use when the
+ * descriptor was accepted without it
+ */
+const struct sockaddr_in&	ClientSocket::getAddress(void) const
+{
+	if (_addr.sin_family == 0 && _fd >= 0)
+	{
+		socklen_t length = sizeof(_addr);
+		
+		if (getpeername(_fd, reinterpret_cast<struct sockaddr*>(&_addr), 
+			&length) < 0)
+			memset(&_addr, 0, sizeof(_addr));
+	}
+	return _addr;
+}
+
+/**
+ * Get the peer address as text (dotted quad)
+ */
+std::string	ClientSocket::getHost(void) const
+{
+	return formatAddress(getAddress());
+}
+
+/**
+ * Get the peer port
+ */
+int	ClientSocket::getPort(void) const
+{
+	return ntohs(getAddress().sin_port);
+}
+
+/**
+ * Format a binary IPv4 address as text
+ */
+std::string	ClientSocket::formatAddress(const struct sockaddr_in& addr)
+{
+	char buffer[INET_ADDRSTRLEN];
+	
+	if (!inet_ntop(AF_INET, &addr.sin_addr, buffer, sizeof(buffer)))
+		return "";
+	return buffer;
+}
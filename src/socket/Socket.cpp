@@ -54,16 +54,6 @@ Socket::SocketImpl::SocketImpl(const std::string& host, int port) :
 	initAddress();
 }
 
-/**
- * Constructor with existing socket file descriptor
- */
-Socket::SocketImpl::SocketImpl(int fd, const struct sockaddr_in& addr) : 
-	_fd(fd), _addr(addr), _bound(true), _listening(false), _refCount(1)
-{
-	_host = inet_ntoa(addr.sin_addr);
-	_port = ntohs(addr.sin_port);
-}
-
 /**
  * Destructor
  */
@@ -139,9 +129,27 @@ void	Socket::SocketImpl::listen(int backlog)
  */
 int Socket::SocketImpl::accept(struct sockaddr_in& clientAddr)
 {
-    socklen_t clientLen = sizeof(clientAddr);
+    int clientFd;
     
-    int clientFd = ::accept(_fd, (struct sockaddr*)&clientAddr, &clientLen);
+    do
+    {
+        socklen_t clientLen = sizeof(clientAddr);
+#ifdef __linux__
+        // The accepted socket comes out non-blocking and close-on-exec,
+        // saving the fcntl round trips for every connection
+        clientFd = ::accept4(_fd, (struct sockaddr*)&clientAddr, &clientLen,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        clientFd = ::accept(_fd, (struct sockaddr*)&clientAddr, &clientLen);
+        if (clientFd >= 0)
+        {
+            fcntl(clientFd, F_SETFL, fcntl(clientFd, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(clientFd, F_SETFD, FD_CLOEXEC);
+        }
+#endif
+        // A client that reset before being accepted is not an error
+    } while (clientFd < 0 && (errno == ECONNABORTED || errno == EPROTO 
+        || errno == EINTR));
     
     if (clientFd < 0)
     {
@@ -171,6 +179,21 @@ void	Socket::SocketImpl::setNonBlocking(void)
 		throw std::runtime_error("Failed to set socket to non-blocking");
 }
 
+/**
+ * Allow several sockets to bind the same address, so that every worker
+ * process owns its own listen queue and the kernel balances connections
+ */
+void	Socket::SocketImpl::setReusePort(void)
+{
+#ifdef SO_REUSEPORT
+	int opt = 1;
+	if (setsockopt(_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+		throw std::runtime_error("Failed to set SO_REUSEPORT");
+#else
+	throw std::runtime_error("SO_REUSEPORT is not supported");
+#endif
+}
+
 /**
  * Send data on the socket
  */
@@ -244,14 +267,6 @@ Socket::Socket(const std::string& host, int port) :
 {
 }
 
-/**
- * Constructor with existing socket file descriptor
- */
-Socket::Socket(int fd, const struct sockaddr_in& addr) :
-	_impl(new SocketImpl(fd, addr))
-{
-}
-
 /**
  * Copy constructor - implements reference counting
  */
@@ -309,24 +324,14 @@ void	Socket::listen(int backlog)
 }
 
 /**
- * Accept a new connection
+ * Accept a new connection as a bare descriptor, -1 if none is waiting
  */
-Socket Socket::accept(void)
+int	Socket::accept(struct sockaddr_in& clientAddr)
 {
-    if (!_impl)
-        throw std::runtime_error("No socket implementation");
-        
-    struct sockaddr_in clientAddr;
-    int clientFd = _impl->accept(clientAddr);
-    
-    // If no connection is waiting, return an invalid socket
-    if (clientFd < 0)
-    {
-        Socket invalid;
-        return invalid;
-    }
-    
-    return Socket(clientFd, clientAddr);
+	if (!_impl)
+		throw std::runtime_error("No socket implementation");
+		
+	return _impl->accept(clientAddr);
 }
 
 /**
@@ -338,6 +343,15 @@ void	Socket::setNonBlocking(void)
 		_impl->setNonBlocking();
 }
 
+/**
+ * Allow several sockets to bind the same address (SO_REUSEPORT)
+ */
+void	Socket::setReusePort(void)
+{
+	if (_impl)
+		_impl->setReusePort();
+}
+
 /**
  * Send data on the socket
  */
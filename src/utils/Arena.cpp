@@ -0,0 +1,142 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Arena.cpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/19 10:21:44 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/19 10:21:44 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Arena.hpp"
+#include <cstring>
+
+/**
+ * Alignment of every allocation, enough for any fundamental type
+ */
+static const size_t	ARENA_ALIGNMENT = 2 * sizeof(void*);
+
+/**
+ * Constructor, no memory is taken until the first allocation
+ */
+Arena::Arena(size_t blockSize) : _blockSize(blockSize), _current(0), 
+	_used(0)
+{
+}
+
+/**
+ * Copy constructor, the copy starts empty with the same block size;
+ * pointers into an arena cannot be carried over
+ */
+Arena::Arena(const Arena& other) : _blockSize(other._blockSize), 
+	_current(0), _used(0)
+{
+}
+
+/**
+ * Destructor, frees every block
+ */
+Arena::~Arena(void)
+{
+	release();
+}
+
+/**
+ * Assignment operator, drops the contents and keeps the blocks
+ */
+Arena&	Arena::operator=(const Arena& other)
+{
+	if (this != &other)
+	{
+		_blockSize = other._blockSize;
+		reset();
+	}
+	return *this;
+}
+
+/**
+ * Get length bytes aligned for any fundamental type
+ */
+void*	Arena::allocate(size_t length)
+{
+	size_t offset = (_used + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+	
+	// Blocks kept from earlier requests are used again, in order
+	while (_current < _blocks.size())
+	{
+		Block& block = _blocks[_current];
+		
+		if (offset <= block.size && length <= block.size - offset)
+		{
+			_used = offset + length;
+			return block.data + offset;
+		}
+		_current++;
+		offset = 0;
+	}
+	
+	// Out of blocks: an oversized request gets a block of its own size
+	Block block;
+	
+	block.size = length > _blockSize ? length : _blockSize;
+	block.data = new char[block.size];
+	_blocks.push_back(block);
+	_current = _blocks.size() - 1;
+	_used = length;
+	return block.data;
+}
+
+/**
+ * Copy bytes into the arena, followed by a NUL
+ */
+char*	Arena::copy(const char* bytes, size_t length)
+{
+	char* data = static_cast<char*>(allocate(length + 1));
+	
+	memcpy(data, bytes, length);
+	data[length] = '\0';
+	return data;
+}
+
+/**
+ * Forget everything allocated, in constant time; blocks are kept
+ */
+void	Arena::reset(void)
+{
+	_current = 0;
+	_used = 0;
+}
+
+/**
+ * Forget everything allocated and give the blocks back
+ */
+void	Arena::release(void)
+{
+	for (size_t i = 0; i < _blocks.size(); i++)
+		delete[] _blocks[i].data;
+	_blocks.clear();
+	reset();
+}
+
+/**
+ * Forget everything allocated and give back the blocks past the first
+ * limit bytes, so one oversized request does not stay paid for
+ */
+void	Arena::trim(size_t limit)
+{
+	size_t total = 0;
+	size_t kept = 0;
+	
+	for (size_t i = 0; i < _blocks.size(); i++)
+	{
+		total += _blocks[i].size;
+		if (total > limit)
+			delete[] _blocks[i].data;
+		else
+			_blocks[kept++] = _blocks[i];
+	}
+	_blocks.resize(kept);
+	reset();
+}
@@ -0,0 +1,180 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Buffer.cpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/12 16:48:30 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/12 16:48:30 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Buffer.hpp"
+#include <cstring>
+
+/**
+ * Default constructor, the buffer starts empty
+ */
+Buffer::Buffer(void) : _start(0), _end(0)
+{
+}
+
+/**
+ * Copy constructor, only the unread bytes are copied
+ */
+Buffer::Buffer(const Buffer& other) : 
+	_data(other.data(), other.data() + other.size()), _start(0), 
+	_end(other.size())
+{
+}
+
+/**
+ * Destructor
+ */
+Buffer::~Buffer(void)
+{
+}
+
+/**
+ * Assignment operator, only the unread bytes are copied
+ */
+Buffer&	Buffer::operator=(const Buffer& other)
+{
+	if (this != &other)
+	{
+		_data.assign(other.data(), other.data() + other.size());
+		_start = 0;
+		_end = _data.size();
+	}
+	return *this;
+}
+
+/**
+ * Get room for at least length bytes at the end; fill it, then
+ * commit() the number of bytes actually written
+ */
+char*	Buffer::prepare(size_t length)
+{
+	if (_data.size() - _end < length)
+	{
+		size_t used = _end - _start;
+		
+		// Reclaim the consumed front before growing
+		if (_start > 0)
+		{
+			if (used > 0)
+				memmove(&_data[0], &_data[_start], used);
+			_start = 0;
+			_end = used;
+		}
+		if (_data.size() - _end < length)
+		{
+			size_t capacity = _data.size() * 2;
+			if (capacity < _end + length)
+				capacity = _end + length;
+			_data.resize(capacity);
+		}
+	}
+	return &_data[_end];
+}
+
+/**
+ * Make length bytes written after prepare() readable
+ */
+void	Buffer::commit(size_t length)
+{
+	_end += length;
+}
+
+/**
+ * Copy bytes at the end
+ */
+void	Buffer::append(const char* bytes, size_t length)
+{
+	if (length == 0)
+		return;
+	memcpy(prepare(length), bytes, length);
+	commit(length);
+}
+
+/**
+ * Drop length bytes from the front
+ */
+void	Buffer::consume(size_t length)
+{
+	_start += length;
+	if (_start >= _end)
+	{
+		// Empty again: the next write starts at the front for free
+		_start = 0;
+		_end = 0;
+	}
+}
+
+/**
+ * Drop everything
+ */
+void	Buffer::clear(void)
+{
+	_start = 0;
+	_end = 0;
+}
+
+/**
+ * Give the storage back once it exceeds limit bytes, keeping the unread
+ * ones; the next write allocates what it needs again
+ */
+void	Buffer::shrink(size_t limit)
+{
+	if (_data.size() <= limit)
+		return;
+	
+	std::vector<char> unread(_data.begin() + _start, _data.begin() + _end);
+	
+	_data.swap(unread);
+	_start = 0;
+	_end = _data.size();
+}
+
+/**
+ * Get the first unread byte
+ */
+const char*	Buffer::data(void) const
+{
+	if (_data.empty())
+		return "";
+	return &_data[_start];
+}
+
+/**
+ * Get the number of unread bytes
+ */
+size_t	Buffer::size(void) const
+{
+	return _end - _start;
+}
+
+/**
+ * Check whether there is nothing to read
+ */
+bool	Buffer::empty(void) const
+{
+	return _end == _start;
+}
+
+/**
+ * Find a byte at or after offset from, npos if absent
+ */
+size_t	Buffer::find(char c, size_t from) const
+{
+	if (from >= size())
+		return npos;
+		
+	const char* begin = data();
+	const void* found = memchr(begin + from, c, size() - from);
+	
+	if (!found)
+		return npos;
+	return static_cast<const char*>(found) - begin;
+}
@@ -0,0 +1,145 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FileHandle.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/21 14:12:50 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/21 14:12:50 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "FileHandle.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Default constructor, the handle starts empty
+ */
+FileHandle::FileHandle(void) : _shared(NULL)
+{
+}
+
+/**
+ * Take ownership of an open descriptor
+ */
+FileHandle::FileHandle(int fd) : _shared(NULL)
+{
+	if (fd < 0)
+		return;
+	_shared = new Shared();
+	_shared->fd = fd;
+	_shared->references = 1;
+}
+
+/**
+ * Copy constructor, shares the descriptor
+ */
+FileHandle::FileHandle(const FileHandle& other) : _shared(other._shared)
+{
+	if (_shared)
+		_shared->references++;
+}
+
+/**
+ * Destructor
+ */
+FileHandle::~FileHandle(void)
+{
+	release();
+}
+
+/**
+ * Assignment operator, shares the descriptor
+ */
+FileHandle&	FileHandle::operator=(const FileHandle& other)
+{
+	if (_shared != other._shared)
+	{
+		release();
+		_shared = other._shared;
+		if (_shared)
+			_shared->references++;
+	}
+	return *this;
+}
+
+/**
+ * Drop this handle's reference, closing the descriptor on the last
+ */
+void	FileHandle::release(void)
+{
+	if (!_shared)
+		return;
+	if (--_shared->references == 0)
+	{
+		::close(_shared->fd);
+		delete _shared;
+	}
+	_shared = NULL;
+}
+
+/**
+ * Open a file for reading, empty handle on failure (errno is set)
+ */
+FileHandle	FileHandle::open(const std::string& path)
+{
+	int fd;
+	
+	do
+		fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+	while (fd < 0 && errno == EINTR);
+	return FileHandle(fd);
+}
+
+/**
+ * Get the descriptor, -1 when empty
+ */
+int	FileHandle::getFd(void) const
+{
+	return _shared ? _shared->fd : -1;
+}
+
+/**
+ * Check if the handle holds a descriptor
+ */
+bool	FileHandle::isOpen(void) const
+{
+	return _shared != NULL;
+}
+
+/**
+ * Let go of the descriptor; other copies keep it open
+ */
+void	FileHandle::reset(void)
+{
+	release();
+}
+
+/**
+ * Read at an offset, without moving a file position other copies may
+ * rely on; returns the bytes read or -1
+ */
+ssize_t	FileHandle::read(off_t offset, char* into, size_t length) const
+{
+	size_t total = 0;
+	
+	if (!_shared)
+		return -1;
+	while (total < length)
+	{
+		ssize_t got = ::pread(_shared->fd, into + total, length - total, 
+			offset + total);
+		
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got < 0)
+			return -1;
+		if (got == 0)
+			break;
+		total += got;
+	}
+	return total;
+}
@@ -11,6 +11,10 @@
 /* ************************************************************************** */
 
 #include "Logger.hpp"
+#include <pthread.h>
+
+// Serializes output lines when worker threads log concurrently
+static pthread_mutex_t	g_outputMutex = PTHREAD_MUTEX_INITIALIZER;
 
 Logger::Logger() : _filterLevel(LOG_LEVEL) {}
 
@@ -39,6 +43,7 @@ LogLevel Logger::getFilterLevel() const {
 
 void Logger::log(LogLevel level, const std::string& message) const {
 	if (level >= _filterLevel) {
+		pthread_mutex_lock(&g_outputMutex);
 		if (level == LOG_DEBUG)
 			std::cout << "[DEBUG] " << message << std::endl;
 		else if (level == LOG_INFO)
@@ -49,27 +54,39 @@ void Logger::log(LogLevel level, const std::string& message) const {
 			std::cerr << "[ERROR] " << message << std::endl;
 		else if (level == LOG_CRITICAL)
 			std::cerr << "[CRITICAL] " << message << std::endl;
+		pthread_mutex_unlock(&g_outputMutex);
 	}
 	tempOss.str("");
 	tempOss.clear();
 }
 
+// A filtered message is dropped without copying it out of tempOss, whose
+// storage is reused by the next message
+void Logger::flush(LogLevel level) const {
+	if (level >= _filterLevel)
+		log(level, tempOss.str());
+	else {
+		tempOss.str("");
+		tempOss.clear();
+	}
+}
+
 void Logger::debug() const {
-	log(LOG_DEBUG, tempOss.str());
+	flush(LOG_DEBUG);
 }
 
 void Logger::info() const {
-	log(LOG_INFO, tempOss.str());
+	flush(LOG_INFO);
 }
 
 void Logger::warning() const {
-	log(LOG_WARNING, tempOss.str());
+	flush(LOG_WARNING);
 }
 
 void Logger::error() const {
-	log(LOG_ERROR, tempOss.str());
+	flush(LOG_ERROR);
 }
 
 void Logger::critical() const {
-	log(LOG_CRITICAL, tempOss.str());
+	flush(LOG_CRITICAL);
 }
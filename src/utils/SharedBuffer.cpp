@@ -0,0 +1,97 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SharedBuffer.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: josfelip <josfelip@student.42sp.org.br>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/09/24 14:12:08 by josfelip          #+#    #+#             */
+/*   Updated: 2025/09/24 14:12:08 by josfelip         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "SharedBuffer.hpp"
+
+/**
+ * Default constructor, the buffer starts empty
+ */
+SharedBuffer::SharedBuffer(void) : _shared(NULL)
+{
+}
+
+/**
+ * Take a copy of the bytes to share
+ */
+SharedBuffer::SharedBuffer(const std::string& data) : _shared(new Shared())
+{
+	_shared->data = data;
+	_shared->references = 1;
+}
+
+/**
+ * Copy constructor, shares the bytes
+ */
+SharedBuffer::SharedBuffer(const SharedBuffer& other) : _shared(other._shared)
+{
+	if (_shared)
+		_shared->references++;
+}
+
+/**
+ * Destructor
+ */
+SharedBuffer::~SharedBuffer(void)
+{
+	release();
+}
+
+/**
+ * Assignment operator, shares the bytes
+ */
+SharedBuffer&	SharedBuffer::operator=(const SharedBuffer& other)
+{
+	if (_shared != other._shared)
+	{
+		release();
+		_shared = other._shared;
+		if (_shared)
+			_shared->references++;
+	}
+	return *this;
+}
+
+/**
+ * Drop this buffer's reference, freeing the bytes on the last
+ */
+void	SharedBuffer::release(void)
+{
+	if (!_shared)
+		return;
+	if (--_shared->references == 0)
+		delete _shared;
+	_shared = NULL;
+}
+
+/**
+ * Get the bytes, NULL when empty
+ */
+const char*	SharedBuffer::data(void) const
+{
+	return _shared ? _shared->data.data() : NULL;
+}
+
+/**
+ * Get the number of bytes
+ */
+size_t	SharedBuffer::size(void) const
+{
+	return _shared ? _shared->data.size() : 0;
+}
+
+/**
+ * Let go of the bytes; other copies keep them
+ */
+void	SharedBuffer::reset(void)
+{
+	release();
+}
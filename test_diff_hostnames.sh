@@ -88,7 +88,22 @@ run_test "sasuke.com - CSS file" \
     "curl -s --resolve sasuke.com:3002:127.0.0.1 http://sasuke.com:3002/style.css" \
     "Sasuke.com Virtual Host Styles"
 
-# Test 9: Different content verification - check that hosts serve different content
+# Test 9: kakashi.com shares naruto.com's port
+run_test "kakashi.com - Same port as naruto.com" \
+    "curl -s --resolve kakashi.com:3001:127.0.0.1 http://kakashi.com:3001/" \
+    "Welcome to Kakashi.com"
+
+# Test 10: unknown names on a shared port go to its first server block
+run_test "Unknown host on port 3001 - Default server" \
+    "curl -s -H 'Host: unknown.com' http://127.0.0.1:3001/" \
+    "Welcome to Naruto.com"
+
+# Test 11: body limits follow the vhost chosen by Host
+run_test "kakashi.com - 1K body limit" \
+    "head -c 2048 /dev/zero | tr '\0' a | curl -s -o /dev/null -w '%{http_code}' --resolve kakashi.com:3001:127.0.0.1 --data-binary @- http://kakashi.com:3001/" \
+    "413"
+
+# Test 12: Different content verification - check that hosts serve different content
 echo -e "\n${BLUE}Testing: Content Differentiation${NC}"
 naruto_response=$(curl -s --resolve naruto.com:3001:127.0.0.1 http://naruto.com:3001/ 2>/dev/null)
 sasuke_response=$(curl -s --resolve sasuke.com:3002:127.0.0.1 http://sasuke.com:3002/ 2>/dev/null)
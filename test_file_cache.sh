@@ -0,0 +1,67 @@
+#!/bin/bash
+
+# Test script for file cache freshness after uploads and deletions
+# WebServ HTTP server - File Cache Tests
+# Configuration: open_file_cache with open_file_cache_errors on
+
+echo "=== WebServ File Cache Tests ==="
+echo "Configuration: open_file_cache max=256 valid=30s, errors cached"
+echo
+
+# Check if webserv is running
+if ! pgrep -f "./webserv" > /dev/null; then
+    echo "Starting webserv..."
+    ./webserv &
+    sleep 2
+fi
+
+# Pipelined requests go out in one write and are answered before any
+# inotify event is read; prints the status of every response
+send_pipelined() {
+    exec 3<>/dev/tcp/localhost/8080
+    printf "$1" | cat >&3
+    timeout 5 cat <&3 | grep -ao 'HTTP/1\.1 [0-9][0-9][0-9] ' | awk '{ printf "%s%s", sep, $2; sep=" " }'
+    exec 3<&-
+}
+
+UPLOADED=zz_cache_upload.txt
+DELETED=zz_cache_delete.txt
+
+# Test file creation
+echo "Creating test files..."
+echo "uploaded content" > /tmp/$UPLOADED
+mkdir -p www/files
+echo "deleted content" > www/files/$DELETED
+echo
+
+# Test 1: A missing file that gets uploaded is served at once
+echo "Test 1: GET (404), upload, GET again - Expected: 200 with the upload"
+before=$(curl -s -o /dev/null -w "%{http_code}" http://localhost:8080/uploads/$UPLOADED)
+upload=$(curl -s -o /dev/null -w "%{http_code}" -X POST -F "file=@/tmp/$UPLOADED" http://localhost:8080/upload)
+after=$(curl -s -w " %{http_code}" http://localhost:8080/uploads/$UPLOADED)
+if [ "$before" == "404" ] && [ "$upload" == "303" ] && [ "$after" == "uploaded content
+ 200" ]; then
+    echo "✓ PASS: Upload seen by the next GET (HTTP $before, $upload, 200)"
+else
+    echo "✗ FAIL: Expected 404, 303, 200, got $before, $upload, '$after'"
+fi
+echo
+
+# Test 2: A deleted file is not served from a cached descriptor or
+# response, even by a GET pipelined right behind the DELETE
+echo "Test 2: GET (200), then pipelined DELETE + GET - Expected: 204 404"
+before=$(curl -s -o /dev/null -w "%{http_code}" http://localhost:8080/files/$DELETED)
+response=$(send_pipelined "DELETE /files/$DELETED HTTP/1.1\r\nHost: localhost\r\n\r\nGET /files/$DELETED HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n")
+if [ "$before" == "200" ] && [ "$response" == "204 404" ]; then
+    echo "✓ PASS: Deletion seen by the next GET (HTTP $before, $response)"
+else
+    echo "✗ FAIL: Expected 200, '204 404', got $before, '$response'"
+fi
+echo
+
+# Cleanup
+echo "Cleaning up test files..."
+rm -f /tmp/$UPLOADED www/uploads/$UPLOADED www/files/$DELETED
+rmdir www/files 2>/dev/null
+
+echo "=== File Cache Tests Complete ==="